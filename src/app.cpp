@@ -1,10 +1,12 @@
 #include "app.hpp"
 #include "nvg_util.hpp"
 #include "nanovg/deko3d/nanovg_dk.h"
+#include "nanovg/nanovg_trace.h"
 
 #include <algorithm>
 #include <ranges>
 #include <cassert>
+#include <sys/stat.h>
 
 #ifndef NDEBUG
     #include <cstdio>
@@ -31,6 +33,10 @@ struct ApplicationOccupiedSize {
 constexpr float SCREEN_WIDTH = 1280.f;
 constexpr float SCREEN_HEIGHT = 720.f;
 
+// glyphs rasterized by previous runs, saves the warm-up of the first frames
+constexpr auto FONT_ATLAS_CACHE_DIR = "sdmc:/config/untitled";
+constexpr auto FONT_ATLAS_CACHE_PATH = "sdmc:/config/untitled/font_atlas.bin";
+
 
 void NsDeleteAppsAsync(std::stop_token stop_token, NsDeleteData&& data) {
     for (const auto&p : data.entries) {
@@ -183,6 +189,16 @@ void App::Draw() {
 
     nvgEndFrame(this->vg);
     this->queue.presentImage(this->swapchain, slot);
+
+#ifndef NDEBUG
+    // report draw call merging whenever the frame changes shape
+    static nvg::DkRenderer::FrameStats last_stats{};
+    const auto& stats = this->renderer->GetFrameStats();
+    if (stats.calls != last_stats.calls || stats.merged_calls != last_stats.merged_calls) {
+        LOG("nvg calls: %u merged: %u\n", stats.calls, stats.merged_calls);
+        last_stats = stats;
+    }
+#endif // NDEBUG
 }
 
 void App::DrawBackground() {
@@ -604,6 +620,8 @@ void App::Scan(std::stop_token stop_token) {
     }
 
 done:
+    // icons are decoded in memory of this thread, keep it no longer than the scan.
+    nvgFreeImageArena();
     std::scoped_lock lock{this->mutex};
     this->finished_scanning = true;
 }
@@ -643,7 +661,26 @@ App::App() {
     this->createFramebufferResources();
 
     this->renderer.emplace(1280, 720, this->device, this->queue, *this->pool_images, *this->pool_code, *this->pool_data);
-    this->vg = nvgCreateDk(&*this->renderer, NVG_ANTIALIAS | NVG_STENCIL_STROKES);
+    this->vg = nvgCreateDk(&*this->renderer, NVG_ANTIALIAS | NVG_STENCIL_STROKES | NVG_SDF_TEXT);
+
+    const NVGworkers workers{
+        .userPtr = &this->tess_pool,
+        .count = this->tess_pool.size(),
+        .parallelFor = [](void* uptr, int n, void (*func)(void*, int, int), void* arg) {
+            static_cast<util::ThreadPool*>(uptr)->parallel_for(n, func, arg);
+        },
+        .async = [](void* uptr, void (*func)(void*), void* arg) {
+            static_cast<util::ThreadPool*>(uptr)->submit(func, arg);
+        },
+    };
+    nvgSetWorkers(this->vg, &workers);
+
+#ifdef NVG_TRACE
+    // build with -DNVG_TRACE=\"sdmc:/untitled.nvgtrace\" to record every frame for tools/nvgreplay.c
+    if (!nvgTraceBegin(this->vg, NVG_TRACE)) {
+        LOG("failed to open trace %s\n", NVG_TRACE);
+    }
+#endif // NVG_TRACE
 
     // not sure if these are meant to be deleted or not...
     int standard_font = nvgCreateFontMem(this->vg, "Standard", (unsigned char*)font_standard.address, font_standard.size, 0);
@@ -657,6 +694,9 @@ App::App() {
     }
 
     nvgAddFallbackFontId(this->vg, standard_font, extended_font);
+    if (!nvgLoadFontAtlas(this->vg, FONT_ATLAS_CACHE_PATH)) {
+        LOG("no font atlas cache at %s\n", FONT_ATLAS_CACHE_PATH);
+    }
     this->default_icon_image = nvgCreateImage(this->vg, "romfs:/default_icon.jpg", NVG_IMAGE_NEAREST);
 
     // todo: handle errors
@@ -682,6 +722,13 @@ App::~App() {
     }
 
     nvgDeleteImage(this->vg, default_icon_image);
+
+    mkdir("sdmc:/config", 0777);
+    mkdir(FONT_ATLAS_CACHE_DIR, 0777);
+    if (!nvgSaveFontAtlas(this->vg, FONT_ATLAS_CACHE_PATH)) {
+        LOG("failed to save font atlas cache to %s\n", FONT_ATLAS_CACHE_PATH);
+    }
+
     this->destroyFramebufferResources();
     nvgDeleteDk(this->vg);
     this->renderer.reset();
@@ -3,6 +3,7 @@
 #include "nanovg/nanovg.h"
 #include "nanovg/deko3d/dk_renderer.hpp"
 #include "async.hpp"
+#include "thread_pool.hpp"
 
 #include <switch.h>
 #include <cstdint>
@@ -149,6 +150,8 @@ private: // from nanovg decko3d example by adubbz
     dk::UniqueSwapchain swapchain;
     DkCmdList render_cmdlist;
     std::optional<nvg::DkRenderer> renderer;
+    // tessellates nanovg paths on cores 1 and 2, alongside the main thread on core 0.
+    util::ThreadPool tess_pool{2};
     void createFramebufferResources();
     void destroyFramebufferResources();
     void recordStaticCommands();
@@ -4,7 +4,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <limits.h>
 #include <switch.h>
+#include <algorithm>
 
 #define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES /* Enforces GLSL std140/std430 alignment rules for glm types. */
 #define GLM_FORCE_INTRINSICS               /* Enables usage of SIMD CPU instructions (requiring the above as well). */
@@ -14,41 +16,92 @@ namespace nvg {
 
     namespace {
 
-        constexpr std::array VertexBufferState = { DkVtxBufferState{sizeof(NVGvertex), 0}, };
+        /* Vertices come from nanovg, paint indices are a second stream filled at flush time. */
+        constexpr std::array VertexBufferState = {
+            DkVtxBufferState{sizeof(NVGvertex), 0},
+            DkVtxBufferState{sizeof(u32), 0},
+        };
 
         constexpr std::array VertexAttribState = {
             DkVtxAttribState{0, 0, offsetof(NVGvertex, x), DkVtxAttribSize_2x32, DkVtxAttribType_Float, 0},
             DkVtxAttribState{0, 0, offsetof(NVGvertex, u), DkVtxAttribSize_2x32, DkVtxAttribType_Float, 0},
+            DkVtxAttribState{1, 0, 0, DkVtxAttribSize_1x32, DkVtxAttribType_Uint, 0},
         };
 
         struct View {
             glm::vec2 size;
+            s32 paint;
         };
 
-        void UpdateImage(dk::Image &image, CMemPool &scratchPool, dk::Device device, dk::Queue transferQueue, int type, int x, int y, int w, int h, const u8 *data) {
-            /* Do not proceed if no data is provided upfront. */
-            if (data == nullptr) {
-                return;
+        /* Paint index used by merged draws, telling the vertex shader to read it from the vertex. */
+        constexpr int VertexPaint = -1;
+
+        bool IsMergeable(const DKNVGcall &call) {
+            return call.type == DKNVG_CONVEXFILL || call.type == DKNVG_TRIANGLES;
+        }
+
+        bool CanMerge(const DKNVGcall &a, const DKNVGcall &b) {
+            return IsMergeable(a) && IsMergeable(b) && a.image == b.image && memcmp(&a.blendFunc, &b.blendFunc, sizeof(DKNVGblend)) == 0 &&
+                memcmp(a.scissor, b.scissor, sizeof(a.scissor)) == 0;
+        }
+
+        u32 FanIndexCount(int count) {
+            return count > 2 ? (count - 2) * 3 : 0;
+        }
+
+        u32 CountIndices(const DKNVGcontext &ctx, const DKNVGcall &call) {
+            if (call.type == DKNVG_TRIANGLES) {
+                return call.triangleCount;
             }
 
-            /* Allocate memory from the pool for the image. */
-            const size_t imageSize = type == NVG_TEXTURE_RGBA ? w * h * 4 : w * h;
-            CMemPool::Handle tempimgmem = scratchPool.allocate(imageSize, DK_IMAGE_LINEAR_STRIDE_ALIGNMENT);
-            memcpy(tempimgmem.getCpuAddr(), data, imageSize);
+            u32 count = 0;
+            for (int i = 0; i < call.pathCount; i++) {
+                const DKNVGpath &path = ctx.paths[call.pathOffset + i];
+                count += FanIndexCount(path.fillCount) + FanIndexCount(path.strokeCount);
+            }
+            return count;
+        }
 
-            dk::UniqueCmdBuf tempcmdbuf = dk::CmdBufMaker{device}.create();
-            CMemPool::Handle tempcmdmem = scratchPool.allocate(DK_MEMBLOCK_ALIGNMENT);
-            tempcmdbuf.addMemory(tempcmdmem.getMemBlock(), tempcmdmem.getOffset(), tempcmdmem.getSize());
+        u32 *AppendFan(u32 *out, u32 offset, int count) {
+            for (int i = 2; i < count; i++) {
+                *out++ = offset;
+                *out++ = offset + i - 1;
+                *out++ = offset + i;
+            }
+            return out;
+        }
 
-            dk::ImageView imageView{image};
-            tempcmdbuf.copyBufferToImage({ tempimgmem.getGpuAddr() }, imageView, { static_cast<uint32_t>(x), static_cast<uint32_t>(y), 0, static_cast<uint32_t>(w), static_cast<uint32_t>(h), 1 });
+        u32 *AppendStrip(u32 *out, u32 offset, int count) {
+            /* Swap every other triangle so that the winding matches the strip. */
+            for (int i = 2; i < count; i++) {
+                const u32 odd = i & 1;
+                *out++ = offset + i - 2 + odd;
+                *out++ = offset + i - 1 - odd;
+                *out++ = offset + i;
+            }
+            return out;
+        }
 
-            transferQueue.submitCommands(tempcmdbuf.finishList());
-            transferQueue.waitIdle();
+        u32 *AppendIndices(const DKNVGcontext &ctx, const DKNVGcall &call, u32 *out) {
+            if (call.type == DKNVG_TRIANGLES) {
+                for (int i = 0; i < call.triangleCount; i++) {
+                    *out++ = call.triangleOffset + i;
+                }
+                return out;
+            }
 
-            /* Destroy temp mem. */
-            tempcmdmem.destroy();
-            tempimgmem.destroy();
+            for (int i = 0; i < call.pathCount; i++) {
+                const DKNVGpath &path = ctx.paths[call.pathOffset + i];
+                out = AppendFan(out, path.fillOffset, path.fillCount);
+                out = AppendStrip(out, path.strokeOffset, path.strokeCount);
+            }
+            return out;
+        }
+
+        void FillPaint(u32 *paints, int offset, int count, u32 paint) {
+            for (int i = 0; i < count; i++) {
+                paints[offset + i] = paint;
+            }
         }
 
     }
@@ -59,7 +112,7 @@ namespace nvg {
         m_image_mem.destroy();
     }
 
-    void Texture::Initialize(CMemPool &image_pool, CMemPool &scratch_pool, dk::Device device, dk::Queue queue, int type, int w, int h, int image_flags, const u8 *data) {
+    void Texture::Initialize(CMemPool &image_pool, dk::Device device, int type, int w, int h, int image_flags) {
         m_texture_descriptor = {
             .width = w,
             .height = h,
@@ -81,17 +134,20 @@ namespace nvg {
         m_image_mem = image_pool.allocate(layout.getSize(), layout.getAlignment());
         m_image.initialize(layout, m_image_mem.getMemBlock(), m_image_mem.getOffset());
         m_image_descriptor.initialize(m_image);
-
-        /* Only update the image if the data isn't null. */
-        if (data != nullptr) {
-            UpdateImage(m_image, scratch_pool, device, queue, type, 0, 0, w, h, data);
-        }
     }
 
     int Texture::GetId() {
         return m_id;
     }
 
+    int Texture::GetDescriptorIndex() {
+        return m_descriptor_index;
+    }
+
+    void Texture::SetDescriptorIndex(int index) {
+        m_descriptor_index = index;
+    }
+
     const DKNVGtextureDescriptor &Texture::GetDescriptor() {
         return m_texture_descriptor;
     }
@@ -105,17 +161,23 @@ namespace nvg {
     }
 
     DkRenderer::DkRenderer(unsigned int view_width, unsigned int view_height, dk::Device device, dk::Queue queue, CMemPool &image_mem_pool, CMemPool &code_mem_pool, CMemPool &data_mem_pool) :
-        m_view_width(view_width), m_view_height(view_height), m_device(device), m_queue(queue), m_image_mem_pool(image_mem_pool), m_code_mem_pool(code_mem_pool), m_data_mem_pool(data_mem_pool), m_image_descriptor_mappings({0})
+        m_view_width(view_width), m_view_height(view_height), m_device(device), m_queue(queue), m_image_mem_pool(image_mem_pool), m_code_mem_pool(code_mem_pool), m_data_mem_pool(data_mem_pool)
     {
         /* Create a dynamic command buffer and allocate memory for it. */
         m_dyn_cmd_buf = dk::CmdBufMaker{m_device}.create();
         m_dyn_cmd_mem.allocate(m_data_mem_pool, DynamicCmdSize);
 
         m_image_descriptor_set.allocate(m_data_mem_pool);
+        for (auto &entry : m_image_descriptors) {
+            m_image_descriptor_lru.add(&entry);
+        }
         m_sampler_descriptor_set.allocate(m_data_mem_pool);
 
         m_view_uniform_buffer = m_data_mem_pool.allocate(sizeof(View), DK_UNIFORM_BUF_ALIGNMENT);
-        m_frag_uniform_buffer = m_data_mem_pool.allocate(sizeof(FragmentUniformSize), DK_UNIFORM_BUF_ALIGNMENT);
+        m_staging_mem = m_data_mem_pool.allocate(StagingSlices * StagingSliceSize, DK_IMAGE_LINEAR_STRIDE_ALIGNMENT);
+        m_upload_mem = m_data_mem_pool.allocate(UploadBatches * UploadBatchSize, DK_IMAGE_LINEAR_STRIDE_ALIGNMENT);
+        m_upload_cmd_buf = dk::CmdBufMaker{m_device}.create();
+        m_upload_cmd_mem.allocate(m_data_mem_pool, UploadBatchCmdSize);
 
         /* Create and bind preset samplers. */
         dk::UniqueCmdBuf init_cmd_buf = dk::CmdBufMaker{m_device}.create();
@@ -150,88 +212,225 @@ namespace nvg {
     }
 
     DkRenderer::~DkRenderer() {
-        if (m_vertex_buffer) {
-            m_vertex_buffer->destroy();
+        for (auto *buffer : { &m_vertex_buffer, &m_paint_buffer, &m_index_buffer, &m_frag_uniform_buffer }) {
+            if (*buffer) {
+                (*buffer)->destroy();
+            }
         }
 
         m_view_uniform_buffer.destroy();
-        m_frag_uniform_buffer.destroy();
-        m_textures.clear();
+        m_staging_mem.destroy();
+        m_upload_mem.destroy();
+        m_uploads.clear();
+        for (auto &textures : m_upload_textures) {
+            textures.clear();
+        }
+        for (auto &chunk : m_texture_chunks) {
+            chunk.reset();
+        }
     }
 
-    int DkRenderer::AcquireImageDescriptor(std::shared_ptr<Texture> texture, int image) {
-        int free_image_descriptor = m_last_image_descriptor + 1;
-        int mapping = 0;
+    int DkRenderer::AcquireImageDescriptor(Texture *texture) {
+        int desc = texture->GetDescriptorIndex();
 
-        for (int desc = 0; desc <= m_last_image_descriptor; desc++) {
-            mapping = m_image_descriptor_mappings[desc];
+        if (desc == -1) {
+            /* Recycle the least recently drawn descriptor, unless draws since the last invalidate read every one of them. */
+            ImageDescriptorEntry *victim = m_image_descriptor_lru.first();
+            if (victim->epoch == m_image_descriptor_epoch) {
+                return -1;
+            }
 
-            /* We've found the image descriptor requested. */
-            if (mapping == image) {
-                return desc;
+            if (victim->texture != nullptr) {
+                victim->texture->SetDescriptorIndex(-1);
             }
 
-            /* Update the free image descriptor. */
-            if (mapping == 0 && free_image_descriptor == m_last_image_descriptor + 1) {
-                free_image_descriptor = desc;
+            /* Written now, visible to draws after the invalidate issued by the caller. */
+            desc = victim - m_image_descriptors.data();
+            victim->texture = texture;
+            m_image_descriptor_set.update(m_dyn_cmd_buf, desc, texture->GetImageDescriptor());
+            texture->SetDescriptorIndex(desc);
+        }
+
+        /* Move to the most recently drawn end. */
+        ImageDescriptorEntry &entry = m_image_descriptors[desc];
+        entry.epoch = m_image_descriptor_epoch;
+        m_image_descriptor_lru.remove(&entry);
+        m_image_descriptor_lru.add(&entry);
+        return desc;
+    }
+
+    void DkRenderer::FreeImageDescriptor(Texture *texture) {
+        const int desc = texture->GetDescriptorIndex();
+        if (desc == -1) {
+            return;
+        }
+
+        /* Recycled before any descriptor still holding a texture. */
+        ImageDescriptorEntry &entry = m_image_descriptors[desc];
+        entry.texture = nullptr;
+        entry.epoch = 0;
+        m_image_descriptor_lru.remove(&entry);
+        m_image_descriptor_lru.addAfter(nullptr, &entry);
+        texture->SetDescriptorIndex(-1);
+    }
+
+    size_t DkRenderer::UpdateImageDescriptors(const DKNVGcontext &ctx, size_t first_batch) {
+        /* The flush before has finished, as its command memory was waited on. Within a flush, descriptors read by earlier draws are rewritten once those are done. */
+        if (first_batch > 0) {
+            m_dyn_cmd_buf.barrier(DkBarrier_Fragments, 0);
+            m_bound_image = 0;
+        }
+        m_image_descriptor_epoch++;
+
+        /* Give every texture drawn from here on a descriptor, as long as there are descriptors left to recycle. */
+        bool updated = false;
+        size_t batch = first_batch;
+        for (; batch < m_batches.size(); batch++) {
+            /* Calls are merged only when they share an image. */
+            Texture *texture = this->FindTexture(ctx.calls[m_batches[batch].call].image);
+            if (texture == nullptr) {
+                continue;
             }
+
+            const bool resident = texture->GetDescriptorIndex() != -1;
+            if (this->AcquireImageDescriptor(texture) == -1) {
+                break;
+            }
+            updated |= !resident;
         }
 
-        /* No descriptors are free. */
-        if (free_image_descriptor >= static_cast<int>(MaxImages)) {
-            return -1;
+        /* Flush the descriptor cache once for all of them. */
+        if (updated) {
+            m_dyn_cmd_buf.barrier(DkBarrier_None, DkInvalidateFlags_Descriptors);
         }
 
-        /* Update descriptor sets. */
-        m_image_descriptor_set.update(m_dyn_cmd_buf, free_image_descriptor, texture->GetImageDescriptor());
+        /* The batch needing the next round of descriptors. */
+        return batch;
+    }
 
-        /* Flush the descriptor cache. */
-        m_dyn_cmd_buf.barrier(DkBarrier_None, DkInvalidateFlags_Descriptors);
+    void *DkRenderer::ReserveBuffer(std::optional<CMemPool::Handle> &buffer, size_t size, u32 alignment) {
+        /* Never hand out an empty buffer, so binding it stays valid. */
+        size = std::max<size_t>(size, alignment);
 
-        /* Update the map. */
-        m_image_descriptor_mappings[free_image_descriptor] = image;
-        m_last_image_descriptor = free_image_descriptor;
-        return free_image_descriptor;
+        /* Destroy the existing buffer if it is too small. */
+        if (buffer && buffer->getSize() < size) {
+            buffer->destroy();
+            buffer.reset();
+        }
+
+        /* Create a new buffer if needed. */
+        if (!buffer) {
+            buffer = m_data_mem_pool.allocate(size, alignment);
+        }
+
+        return buffer ? buffer->getCpuAddr() : nullptr;
     }
 
-    void DkRenderer::FreeImageDescriptor(int image) {
-        for (int desc = 0; desc <= m_last_image_descriptor; desc++) {
-            if (m_image_descriptor_mappings[desc] == image) {
-                m_image_descriptor_mappings[desc] = 0;
+    void DkRenderer::UpdateBuffers(const DKNVGcontext &ctx) {
+        /* Copy vertices and paints. */
+        const size_t vertex_size = ctx.nverts * sizeof(NVGvertex);
+        memcpy(this->ReserveBuffer(m_vertex_buffer, vertex_size, DK_CMDMEM_ALIGNMENT), ctx.verts, vertex_size);
+
+        const size_t frag_size = ctx.nuniforms * ctx.fragSize;
+        memcpy(this->ReserveBuffer(m_frag_uniform_buffer, frag_size, DK_UNIFORM_BUF_ALIGNMENT), ctx.uniforms, frag_size);
+
+        /* Tag the vertices of mergeable calls with their paint, other calls override it when drawn. */
+        u32 *paints = static_cast<u32 *>(this->ReserveBuffer(m_paint_buffer, ctx.nverts * sizeof(u32), DK_CMDMEM_ALIGNMENT));
+        for (int i = 0; i < ctx.ncalls; i++) {
+            const DKNVGcall &call = ctx.calls[i];
+            const u32 paint = call.uniformOffset / ctx.fragSize;
+
+            if (call.type == DKNVG_TRIANGLES) {
+                FillPaint(paints, call.triangleOffset, call.triangleCount, paint);
+            } else if (call.type == DKNVG_CONVEXFILL) {
+                for (int j = 0; j < call.pathCount; j++) {
+                    const DKNVGpath &path = ctx.paths[call.pathOffset + j];
+                    FillPaint(paints, path.fillOffset, path.fillCount, paint);
+                    FillPaint(paints, path.strokeOffset, path.strokeCount, paint);
+                }
             }
         }
     }
 
-    void DkRenderer::UpdateVertexBuffer(const void *data, size_t size) {
-        /* Destroy the existing vertex buffer if it is too small. */
-        if (m_vertex_buffer && m_vertex_buffer->getSize() < size) {
-            m_vertex_buffer->destroy();
-            m_vertex_buffer.reset();
+    void DkRenderer::BuildBatches(const DKNVGcontext &ctx) {
+        /* Count the indices needed by mergeable calls. */
+        size_t index_count = 0;
+        for (int i = 0; i < ctx.ncalls; i++) {
+            if (IsMergeable(ctx.calls[i])) {
+                index_count += CountIndices(ctx, ctx.calls[i]);
+            }
         }
 
-        /* Create a new buffer if needed. */
-        if (!m_vertex_buffer) {
-            m_vertex_buffer = m_data_mem_pool.allocate(size);
+        u32 *indices = static_cast<u32 *>(this->ReserveBuffer(m_index_buffer, index_count * sizeof(u32), DK_CMDMEM_ALIGNMENT));
+        u32 *out = indices;
+
+        /* Group consecutive calls which share an image and blend state. */
+        m_batches.clear();
+        for (int i = 0; i < ctx.ncalls; i++) {
+            const DKNVGcall &call = ctx.calls[i];
+
+            if (m_batches.empty() || !CanMerge(ctx.calls[m_batches.back().call], call)) {
+                m_batches.push_back({ i, 0, static_cast<u32>(out - indices), 0 });
+            }
+
+            Batch &batch = m_batches.back();
+            batch.call_count++;
+
+            if (IsMergeable(call)) {
+                u32 *end = AppendIndices(ctx, call, out);
+                batch.index_count += end - out;
+                out = end;
+            }
+        }
+    }
+
+    void DkRenderer::BindPaint(int paint) {
+        if (paint == m_bound_paint) {
+            return;
         }
 
-        /* Copy data to the vertex buffer if it exists. */
-        if (m_vertex_buffer) {
-            memcpy(m_vertex_buffer->getCpuAddr(), data, size);
+        const s32 value = paint;
+        m_dyn_cmd_buf.pushConstants(m_view_uniform_buffer.getGpuAddr(), m_view_uniform_buffer.getSize(), offsetof(View, paint), sizeof(value), &value);
+        m_bound_paint = paint;
+    }
+
+    void DkRenderer::BindBlend(const DKNVGblend &blend) {
+        if (memcmp(&blend, &m_bound_blend, sizeof(blend)) == 0) {
+            return;
         }
+
+        m_dyn_cmd_buf.bindBlendStates(0, { dk::BlendState{}.setFactors(static_cast<DkBlendFactor>(blend.srcRGB), static_cast<DkBlendFactor>(blend.dstRGB), static_cast<DkBlendFactor>(blend.srcAlpha), static_cast<DkBlendFactor>(blend.dstAlpha)) });
+        m_bound_blend = blend;
+    }
+
+    void DkRenderer::BindScissor(const int *scissor) {
+        if (memcmp(scissor, m_bound_scissor, sizeof(m_bound_scissor)) == 0) {
+            return;
+        }
+
+        m_dyn_cmd_buf.setScissors(0, { DkScissor{ static_cast<u32>(scissor[0]), static_cast<u32>(scissor[1]), static_cast<u32>(scissor[2]), static_cast<u32>(scissor[3]) } });
+        memcpy(m_bound_scissor, scissor, sizeof(m_bound_scissor));
     }
 
     void DkRenderer::SetUniforms(const DKNVGcontext &ctx, int offset, int image) {
-        m_dyn_cmd_buf.pushConstants(m_frag_uniform_buffer.getGpuAddr(), m_frag_uniform_buffer.getSize(), 0, ctx.fragSize, ctx.uniforms + offset);
-        m_dyn_cmd_buf.bindUniformBuffer(DkStage_Fragment, 0, m_frag_uniform_buffer.getGpuAddr(), m_frag_uniform_buffer.getSize());
+        this->BindPaint(offset / ctx.fragSize);
+        this->BindImage(image);
+    }
+
+    void DkRenderer::BindImage(int image) {
+        /* The image is still bound from the last draw. */
+        if (image == m_bound_image) {
+            return;
+        }
 
         /* Attempt to find a texture. */
-        const auto texture = this->FindTexture(image);
+        Texture *texture = this->FindTexture(image);
         if (texture == nullptr) {
             return;
         }
 
-        /* Acquire an image descriptor. */
-        const int image_desc_id = this->AcquireImageDescriptor(texture, image);
+        /* Written by UpdateImageDescriptors() before the batch drawing it. */
+        const int image_desc_id = texture->GetDescriptorIndex();
         if (image_desc_id == -1) {
             return;
         }
@@ -245,6 +444,7 @@ namespace nvg {
         if (image_flags & NVG_IMAGE_REPEATY)          sampler_id |= SamplerType_RepeatY;
 
         m_dyn_cmd_buf.bindTextures(DkStage_Fragment, 0, dkMakeTextureHandle(image_desc_id, sampler_id));
+        m_bound_image = image;
     }
 
     void DkRenderer::DrawFill(const DKNVGcontext &ctx, const DKNVGcall &call) {
@@ -318,22 +518,6 @@ namespace nvg {
         m_dyn_cmd_buf.bindDepthStencilState(dk::DepthStencilState{});
     }
 
-    void DkRenderer::DrawConvexFill(const DKNVGcontext &ctx, const DKNVGcall &call) {
-        DKNVGpath *paths = &ctx.paths[call.pathOffset];
-        int npaths = call.pathCount;
-
-        this->SetUniforms(ctx, call.uniformOffset, call.image);
-
-        for (int i = 0; i < npaths; i++) {
-            m_dyn_cmd_buf.draw(DkPrimitive_TriangleFan, paths[i].fillCount, 1, paths[i].fillOffset, 0);
-
-            /* Draw fringes. */
-            if (paths[i].strokeCount > 0) {
-                m_dyn_cmd_buf.draw(DkPrimitive_TriangleStrip, paths[i].strokeCount, 1, paths[i].strokeOffset, 0);
-            }
-        }
-    }
-
     void DkRenderer::DrawStroke(const DKNVGcontext &ctx, const DKNVGcall &call) {
         DKNVGpath* paths = &ctx.paths[call.pathOffset];
         int npaths = call.pathCount;
@@ -393,9 +577,15 @@ namespace nvg {
         }
     }
 
-    void DkRenderer::DrawTriangles(const DKNVGcontext &ctx, const DKNVGcall &call) {
-        this->SetUniforms(ctx, call.uniformOffset, call.image);
-        m_dyn_cmd_buf.draw(DkPrimitive_Triangles, call.triangleCount, 1, call.triangleOffset, 0);
+    void DkRenderer::DrawBatch(const DKNVGcontext &ctx, const DKNVGcall &call, u32 first_index, u32 index_count) {
+        if (index_count == 0) {
+            return;
+        }
+
+        /* Each vertex carries its own paint. */
+        this->BindPaint(VertexPaint);
+        this->BindImage(call.image);
+        m_dyn_cmd_buf.drawIndexed(DkPrimitive_Triangles, index_count, 1, first_index, 0, 0);
     }
 
     int DkRenderer::Create(DKNVGcontext &ctx) {
@@ -413,63 +603,335 @@ namespace nvg {
         return 1;
     }
 
-    std::shared_ptr<Texture> DkRenderer::FindTexture(int id) {
-        for (auto it = m_textures.begin(); it != m_textures.end(); it++) {
-            if ((*it)->GetId() == id) {
-                return *it;
-            }
+    DkRenderer::TextureSlot &DkRenderer::GetTextureSlot(u32 index) {
+        return m_texture_chunks[index / TextureChunkSize][index % TextureChunkSize];
+    }
+
+    DkRenderer::TextureSlot *DkRenderer::FindTextureSlot(int id) {
+        const u32 index = static_cast<u32>(id) & TextureSlotMask;
+        if (id <= 0 || index >= static_cast<u32>(m_texture_slot_count)) {
+            return nullptr;
         }
 
-        return nullptr;
+        /* A stale id names a reused or empty slot of another generation. */
+        TextureSlot &slot = this->GetTextureSlot(index);
+        if (slot.texture == nullptr || slot.generation != static_cast<u32>(id) >> TextureSlotBits) {
+            return nullptr;
+        }
+
+        return &slot;
+    }
+
+    Texture *DkRenderer::FindTexture(int id) {
+        TextureSlot *slot = this->FindTextureSlot(id);
+        return slot != nullptr ? slot->texture.get() : nullptr;
     }
 
     int DkRenderer::CreateTexture(const DKNVGcontext &ctx, int type, int w, int h, int image_flags, const unsigned char* data) {
-        const auto texture_id = m_next_texture_id++;
+        std::scoped_lock lock{m_texture_mutex};
+
+        /* Pixels decoded into a range MapTexture() pinned are copied from there, the slice stays open while the lock is held. */
+        const uintptr_t batch_mem = reinterpret_cast<uintptr_t>(m_upload_mem.getCpuAddr()) + m_upload_batch * UploadBatchSize;
+        const uintptr_t data_addr = reinterpret_cast<uintptr_t>(data);
+        const bool mapped = m_upload_pins > 0 && data_addr >= batch_mem && data_addr < batch_mem + m_upload_offset;
+        if (mapped) {
+            m_upload_pins--;
+            m_upload_unpinned.notify_all();
+        }
+
+        /* Reuse a slot of a deleted texture before taking a new one. */
+        int index = m_free_texture_slot;
+        if (index != -1) {
+            m_free_texture_slot = this->GetTextureSlot(index).next_free;
+        } else if (m_texture_slot_count <= static_cast<int>(TextureSlotMask)) {
+            index = m_texture_slot_count++;
+            if (m_texture_chunks[index / TextureChunkSize] == nullptr) {
+                m_texture_chunks[index / TextureChunkSize] = std::make_unique<TextureSlot[]>(TextureChunkSize);
+            }
+        } else {
+            /* Out of slots, mapped staging memory is simply not copied. */
+            return 0;
+        }
+
+        TextureSlot &slot = this->GetTextureSlot(index);
+        const int texture_id = static_cast<int>((slot.generation << TextureSlotBits) | index);
         auto texture = std::make_shared<Texture>(texture_id);
-        texture->Initialize(m_image_mem_pool, m_data_mem_pool, m_device, m_queue, type, w, h, image_flags, data);
-        m_textures.push_back(texture);
-        return texture->GetId();
+
+        texture->Initialize(m_image_mem_pool, m_device, type, w, h, image_flags);
+
+        if (mapped) {
+            this->QueueUpload(texture, static_cast<u32>(data_addr - batch_mem), 0, h);
+        } else if (data != nullptr) {
+            this->UploadRows(texture, 0, h, data);
+        }
+
+        slot.texture = std::move(texture);
+        return texture_id;
+    }
+
+    u8 *DkRenderer::MapTexture(const DKNVGcontext &ctx, int type, int w, int h) {
+        const u32 size = w * h * (type == NVG_TEXTURE_RGBA ? 4 : 1);
+        if (w <= 0 || h <= 0 || size > UploadBatchSize) {
+            return nullptr;
+        }
+
+        std::scoped_lock lock{m_texture_mutex};
+
+        /* The slice of a pinned batch cannot be swapped for a fresh one without waiting, the caller decodes into its own memory then. */
+        if (m_upload_pins > 0 && m_upload_offset + size > UploadBatchSize) {
+            return nullptr;
+        }
+
+        /* Decoded straight into staging memory of the open batch once the lock is released, the pin keeps the slice from being
+           handed to another batch until CreateTexture() has recorded the copy. */
+        const u32 offset = this->ReserveUpload(size);
+        m_upload_pins++;
+        return static_cast<u8 *>(m_upload_mem.getCpuAddr()) + m_upload_batch * UploadBatchSize + offset;
     }
 
     int DkRenderer::DeleteTexture(const DKNVGcontext &ctx, int image) {
-        bool found = false;
-
-        for (auto it = m_textures.begin(); it != m_textures.end();) {
-            /* Remove textures with the given id. */
-            if ((*it)->GetId() == image) {
-                it = m_textures.erase(it);
-                found = true;
-            } else {
-                ++it;
+        std::scoped_lock lock{m_texture_mutex};
+        TextureSlot *slot = this->FindTextureSlot(image);
+        if (slot == nullptr) {
+            return 0;
+        }
+
+        /* Free any used image descriptor, pending uploads hold their own reference until they are copied. */
+        this->FreeImageDescriptor(slot->texture.get());
+        slot->texture.reset();
+
+        /* Retire the id, generation zero is skipped so no id is ever zero. */
+        slot->generation = (slot->generation + 1) & TextureGenerationMask;
+        if (slot->generation == 0) {
+            slot->generation = 1;
+        }
+
+        slot->next_free = m_free_texture_slot;
+        m_free_texture_slot = static_cast<int>(static_cast<u32>(image) & TextureSlotMask);
+        return 1;
+    }
+
+    bool DkRenderer::StageUpload(const std::shared_ptr<Texture> &texture, int x, int y, int w, int h, const u8 *data) {
+        const DKNVGtextureDescriptor &tex_desc = texture->GetDescriptor();
+        const int bpp = tex_desc.type == NVG_TEXTURE_RGBA ? 4 : 1;
+
+        const auto staged_size = [bpp](int w, int h) -> u32 {
+            return (w * h * bpp + DK_IMAGE_LINEAR_STRIDE_ALIGNMENT - 1) & ~(DK_IMAGE_LINEAR_STRIDE_ALIGNMENT - 1);
+        };
+
+        /* Fold in a pending rectangle of the same texture when the union costs no extra texels, like neighbouring glyphs of a shelf. */
+        for (auto it = m_uploads.begin(); it != m_uploads.end(); it++) {
+            if (it->texture != texture) {
+                continue;
+            }
+
+            const int x0 = std::min(x, it->x), y0 = std::min(y, it->y);
+            const int x1 = std::max(x + w, it->x + it->w), y1 = std::max(y + h, it->y + it->h);
+            if ((x1 - x0) * (y1 - y0) <= w * h + it->w * it->h && staged_size(x1 - x0, y1 - y0) <= StagingSliceSize) {
+                x = x0;
+                y = y0;
+                w = x1 - x0;
+                h = y1 - y0;
+                m_uploads.erase(it);
+                break;
             }
         }
 
-        /* Free any used image descriptors. */
-        this->FreeImageDescriptor(image);
-        return found;
+        const u32 size = staged_size(w, h);
+        if (size > StagingSliceSize) {
+            return false;
+        }
+
+        /* The slice was last used two flushes ago, so its fence has normally been signalled long before. */
+        if (!m_staging_acquired) {
+            m_staging_fences[m_staging_slice].wait();
+            m_staging_offset = 0;
+            m_staging_acquired = true;
+        }
+
+        /* Out of room, copy what is staged right away and start the slice over. */
+        if (m_staging_offset + size > StagingSliceSize) {
+            this->SubmitUploads();
+        }
+
+        /* Rows are packed tightly, the source is the whole texture. */
+        u8 *dst = static_cast<u8 *>(m_staging_mem.getCpuAddr()) + m_staging_slice * StagingSliceSize + m_staging_offset;
+        for (int row = 0; row < h; row++) {
+            memcpy(dst + row * w * bpp, data + ((y + row) * tex_desc.width + x) * bpp, w * bpp);
+        }
+
+        m_uploads.push_back(Upload{texture, m_staging_offset, x, y, w, h});
+        m_staging_offset += size;
+        return true;
+    }
+
+    void DkRenderer::RecordUploads(dk::CmdBuf cmd_buf) {
+        if (m_uploads.empty()) {
+            return;
+        }
+
+        const DkGpuAddr staging = m_staging_mem.getGpuAddr() + m_staging_slice * StagingSliceSize;
+        for (const Upload &upload : m_uploads) {
+            dk::ImageView image_view{upload.texture->GetImage()};
+            cmd_buf.copyBufferToImage({ staging + upload.offset }, image_view,
+                { static_cast<uint32_t>(upload.x), static_cast<uint32_t>(upload.y), 0, static_cast<uint32_t>(upload.w), static_cast<uint32_t>(upload.h), 1 });
+        }
+
+        /* Draws sample the new texels only once the copies have landed. */
+        cmd_buf.barrier(DkBarrier_Full, DkInvalidateFlags_Image);
+        m_uploads.clear();
+    }
+
+    void DkRenderer::CopyStagedUploads() {
+        if (!m_staging_acquired) {
+            return;
+        }
+
+        /* The fence tells when the slice can be written again. */
+        this->RecordUploads(m_dyn_cmd_buf);
+        m_dyn_cmd_buf.signalFence(m_staging_fences[m_staging_slice]);
+        m_staging_slice = (m_staging_slice + 1) % StagingSlices;
+        m_staging_acquired = false;
+    }
+
+    void DkRenderer::SubmitUploads() {
+        if (m_uploads.empty()) {
+            return;
+        }
+
+        /* The open batch may still copy from the slice. */
+        this->SubmitUploadBatch();
+
+        dk::UniqueCmdBuf upload_cmd_buf = dk::CmdBufMaker{m_device}.create();
+        CMemPool::Handle upload_cmd_mem = m_data_mem_pool.allocate(DK_MEMBLOCK_ALIGNMENT);
+        upload_cmd_buf.addMemory(upload_cmd_mem.getMemBlock(), upload_cmd_mem.getOffset(), upload_cmd_mem.getSize());
+
+        this->RecordUploads(upload_cmd_buf);
+        m_queue.submitCommands(upload_cmd_buf.finishList());
+        m_queue.waitIdle();
+
+        /* The queue is idle, the whole slice is free again. */
+        m_staging_offset = 0;
+        upload_cmd_mem.destroy();
     }
 
     int DkRenderer::UpdateTexture(const DKNVGcontext &ctx, int image, int x, int y, int w, int h, const unsigned char *data) {
-        const std::shared_ptr<Texture> texture = this->FindTexture(image);
+        std::scoped_lock lock{m_texture_mutex};
+        const TextureSlot *slot = this->FindTextureSlot(image);
 
         /* Could not find a texture. */
-        if (texture == nullptr) {
+        if (slot == nullptr) {
             return 0;
         }
 
-        const DKNVGtextureDescriptor &tex_desc = texture->GetDescriptor();
-        if (tex_desc.type == NVG_TEXTURE_RGBA) {
-            data += y * tex_desc.width*4;
-        } else {
-            data += y * tex_desc.width;
+        const std::shared_ptr<Texture> &texture = slot->texture;
+
+        if (data == nullptr || w <= 0 || h <= 0) {
+            return 1;
+        }
+
+        /* Copied by the next flush, in its own command list. */
+        if (this->StageUpload(texture, x, y, w, h, data)) {
+            return 1;
+        }
+
+        /* Larger than a staging slice, upload whole rows in a batch, after the rectangles staged before. */
+        if (!m_uploads.empty()) {
+            this->ReserveUpload(0);
+            for (const Upload &upload : m_uploads) {
+                m_upload_textures[m_upload_batch].push_back(upload.texture);
+            }
+            m_upload_copies += m_uploads.size();
+            this->RecordUploads(m_upload_cmd_buf);
         }
-        x = 0;
-        w = tex_desc.width;
 
-        UpdateImage(texture->GetImage(), m_data_mem_pool, m_device, m_queue, tex_desc.type, x, y, w, h, data);
+        const DKNVGtextureDescriptor &tex_desc = texture->GetDescriptor();
+        this->UploadRows(texture, y, h, data + y * tex_desc.width * (tex_desc.type == NVG_TEXTURE_RGBA ? 4 : 1));
         return 1;
     }
 
+    u32 DkRenderer::ReserveUpload(u32 size) {
+        size = (size + DK_IMAGE_LINEAR_STRIDE_ALIGNMENT - 1) & ~(DK_IMAGE_LINEAR_STRIDE_ALIGNMENT - 1);
+
+        /* Only a fresh slice makes room, wait for the ranges still being decoded into this one. The lock is released meanwhile. */
+        if (m_upload_open && m_upload_offset + size > UploadBatchSize && m_upload_pins > 0) {
+            m_upload_unpinned.wait(m_texture_mutex, [this] { return m_upload_pins == 0; });
+        }
+
+        /* Out of staging memory or command memory, send the batch on its way. */
+        if (m_upload_open && (m_upload_offset + size > UploadBatchSize || m_upload_copies >= UploadBatchCopies)) {
+            this->SubmitUploadBatch();
+        }
+
+        /* Waits for the last list that copied from the slice, normally long done, then lets go of its textures. */
+        if (!m_upload_open) {
+            m_upload_fences[m_upload_batch].wait();
+            m_upload_cmd_mem.begin(m_upload_cmd_buf);
+            m_upload_textures[m_upload_batch].clear();
+            m_upload_offset = 0;
+            m_upload_copies = 0;
+            m_upload_open = true;
+        }
+
+        const u32 offset = m_upload_offset;
+        m_upload_offset += size;
+        return offset;
+    }
+
+    void DkRenderer::QueueUpload(const std::shared_ptr<Texture> &texture, u32 offset, int y, int h) {
+        const DkGpuAddr staging = m_upload_mem.getGpuAddr() + m_upload_batch * UploadBatchSize + offset;
+        dk::ImageView image_view{texture->GetImage()};
+        m_upload_cmd_buf.copyBufferToImage({ staging }, image_view,
+            { 0, static_cast<uint32_t>(y), 0, static_cast<uint32_t>(texture->GetDescriptor().width), static_cast<uint32_t>(h), 1 });
+
+        /* Kept alive until the copy has run, even if deleted right away. */
+        m_upload_textures[m_upload_batch].push_back(texture);
+        m_upload_copies++;
+    }
+
+    void DkRenderer::UploadRows(const std::shared_ptr<Texture> &texture, int y, int h, const u8 *data) {
+        const DKNVGtextureDescriptor &tex_desc = texture->GetDescriptor();
+        const u32 pitch = tex_desc.width * (tex_desc.type == NVG_TEXTURE_RGBA ? 4 : 1);
+        const int batch_rows = UploadBatchSize / pitch;
+        if (batch_rows == 0) {
+            return;
+        }
+
+        /* Rows are contiguous, images larger than a batch are split across batches. */
+        while (h > 0) {
+            const int rows = std::min(h, batch_rows);
+            const u32 offset = this->ReserveUpload(rows * pitch);
+            memcpy(static_cast<u8 *>(m_upload_mem.getCpuAddr()) + m_upload_batch * UploadBatchSize + offset, data, rows * pitch);
+            this->QueueUpload(texture, offset, y, rows);
+
+            data += rows * pitch;
+            y += rows;
+            h -= rows;
+        }
+    }
+
+    void DkRenderer::SubmitUploadBatch() {
+        if (!m_upload_open) {
+            return;
+        }
+
+        /* Draws submitted later run after the copies, the fence only tells when the slice is free again. */
+        m_upload_cmd_buf.barrier(DkBarrier_Full, DkInvalidateFlags_Image);
+        m_upload_cmd_buf.signalFence(m_upload_fences[m_upload_batch]);
+        m_queue.submitCommands(m_upload_cmd_mem.end(m_upload_cmd_buf));
+        m_queue.flush();
+
+        /* Mapped ranges are still being decoded into the slice, it stays open and their copies go out with a later list. */
+        if (m_upload_pins > 0) {
+            m_upload_cmd_mem.begin(m_upload_cmd_buf);
+            m_upload_copies = 0;
+            return;
+        }
+
+        m_upload_batch = (m_upload_batch + 1) % UploadBatches;
+        m_upload_open = false;
+    }
+
     int DkRenderer::GetTextureSize(const DKNVGcontext &ctx, int image, int *w, int *h) {
         const auto descriptor = this->GetTextureDescriptor(ctx, image);
         if (descriptor == nullptr) {
@@ -482,22 +944,45 @@ namespace nvg {
     }
 
     const DKNVGtextureDescriptor *DkRenderer::GetTextureDescriptor(const DKNVGcontext &ctx, int id) {
-        for (auto it = m_textures.begin(); it != m_textures.end(); it++) {
-            if ((*it)->GetId() == id) {
-                return &(*it)->GetDescriptor();
-            }
-        }
-
-        return nullptr;
+        /* The lookup races with textures created on the scan thread, deletes only happen on the drawing thread. */
+        std::scoped_lock lock{m_texture_mutex};
+        Texture *texture = this->FindTexture(id);
+        return texture != nullptr ? &texture->GetDescriptor() : nullptr;
     }
 
     void DkRenderer::Flush(DKNVGcontext &ctx) {
+        std::scoped_lock lock{m_texture_mutex};
+        m_frame_stats = {};
+
+        /* Textures created since the last flush are copied before anything draws them. */
+        this->SubmitUploadBatch();
+
+        /* Nothing to draw, the staged texture updates still go out. */
+        if (ctx.ncalls == 0 && m_staging_acquired) {
+            m_dyn_cmd_mem.begin(m_dyn_cmd_buf);
+            this->CopyStagedUploads();
+            m_queue.submitCommands(m_dyn_cmd_mem.end(m_dyn_cmd_buf));
+        }
+
         if (ctx.ncalls > 0) {
             /* Prepare dynamic command buffer. */
             m_dyn_cmd_mem.begin(m_dyn_cmd_buf);
 
+            /* Texture updates staged since the last flush come first. */
+            this->CopyStagedUploads();
+
             /* Update buffers with data. */
-            this->UpdateVertexBuffer(ctx.verts, ctx.nverts * sizeof(NVGvertex));
+            this->UpdateBuffers(ctx);
+            this->BuildBatches(ctx);
+
+            /* Forget state bound by the previous flush. */
+            m_bound_paint = INT_MIN;
+            m_bound_image = 0;
+            m_bound_blend = { -1, -1, -1, -1 };
+            m_bound_scissor[0] = 0;
+            m_bound_scissor[1] = 0;
+            m_bound_scissor[2] = m_view_width;
+            m_bound_scissor[3] = m_view_height;
 
             /* Enable blending. */
             m_dyn_cmd_buf.bindColorState(dk::ColorState{}.setBlendEnable(0, true));
@@ -507,31 +992,47 @@ namespace nvg {
             m_dyn_cmd_buf.bindVtxAttribState(VertexAttribState);
             m_dyn_cmd_buf.bindVtxBufferState(VertexBufferState);
             m_dyn_cmd_buf.bindVtxBuffer(0, m_vertex_buffer->getGpuAddr(), m_vertex_buffer->getSize());
+            m_dyn_cmd_buf.bindVtxBuffer(1, m_paint_buffer->getGpuAddr(), m_paint_buffer->getSize());
+            m_dyn_cmd_buf.bindIdxBuffer(DkIdxFormat_Uint32, m_index_buffer->getGpuAddr());
+            m_dyn_cmd_buf.bindStorageBuffer(DkStage_Fragment, 0, m_frag_uniform_buffer->getGpuAddr(), m_frag_uniform_buffer->getSize());
 
             /* Push the view size to the uniform buffer and bind it. */
-            const auto view = View{glm::vec2{m_view_width, m_view_height}};
+            const auto view = View{glm::vec2{m_view_width, m_view_height}, VertexPaint};
             m_dyn_cmd_buf.pushConstants(m_view_uniform_buffer.getGpuAddr(), m_view_uniform_buffer.getSize(), 0, sizeof(view), &view);
             m_dyn_cmd_buf.bindUniformBuffer(DkStage_Vertex, 0, m_view_uniform_buffer.getGpuAddr(), m_view_uniform_buffer.getSize());
+            m_bound_paint = VertexPaint;
 
-            /* Iterate over calls. */
-            for (int i = 0; i < ctx.ncalls; i++) {
-                const DKNVGcall &call = ctx.calls[i];
+            /* Iterate over batches, writing image descriptors ahead of the batches drawing them. */
+            size_t next_descriptors = 0;
+            for (size_t i = 0; i < m_batches.size(); i++) {
+                if (i == next_descriptors) {
+                    next_descriptors = this->UpdateImageDescriptors(ctx, i);
+                }
+
+                const Batch &batch = m_batches[i];
+                const DKNVGcall &call = ctx.calls[batch.call];
 
-                /* Perform blending. */
-                m_dyn_cmd_buf.bindBlendStates(0, { dk::BlendState{}.setFactors(static_cast<DkBlendFactor>(call.blendFunc.srcRGB), static_cast<DkBlendFactor>(call.blendFunc.dstRGB), static_cast<DkBlendFactor>(call.blendFunc.srcAlpha), static_cast<DkBlendFactor>(call.blendFunc.dstRGB)) });
+                /* Perform blending and clipping. */
+                this->BindBlend(call.blendFunc);
+                this->BindScissor(call.scissor);
 
-                if (call.type == DKNVG_FILL) {
+                if (IsMergeable(call)) {
+                    this->DrawBatch(ctx, call, batch.first_index, batch.index_count);
+                } else if (call.type == DKNVG_FILL) {
                     this->DrawFill(ctx, call);
-                } else if (call.type == DKNVG_CONVEXFILL) {
-                    this->DrawConvexFill(ctx, call);
                 } else if (call.type == DKNVG_STROKE) {
                     this->DrawStroke(ctx, call);
-                } else if (call.type == DKNVG_TRIANGLES) {
-                    this->DrawTriangles(ctx, call);
                 }
             }
 
+            /* Leave the full view scissor behind. */
+            const int full_scissor[4] = { 0, 0, static_cast<int>(m_view_width), static_cast<int>(m_view_height) };
+            this->BindScissor(full_scissor);
+
             m_queue.submitCommands(m_dyn_cmd_mem.end(m_dyn_cmd_buf));
+
+            m_frame_stats.calls = ctx.ncalls;
+            m_frame_stats.merged_calls = m_batches.size();
         }
 
         /* Reset calls. */
@@ -541,4 +1042,8 @@ namespace nvg {
         ctx.nuniforms = 0;
     }
 
+    const DkRenderer::FrameStats &DkRenderer::GetFrameStats() const {
+        return m_frame_stats;
+    }
+
 }
\ No newline at end of file
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <deko3d.hpp>
+#include <array>
+#include <condition_variable>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <optional>
 
@@ -10,6 +13,7 @@
 #include "framework/CMemPool.h"
 #include "framework/CShader.h"
 #include "framework/CCmdMemRing.h"
+#include "framework/CIntrusiveList.h"
 #include "../nanovg.h"
 
 // Create flags
@@ -21,6 +25,8 @@ enum NVGcreateFlags {
     NVG_STENCIL_STROKES	= 1<<1,
     // Flag indicating that additional debug checks are done.
     NVG_DEBUG 			= 1<<2,
+    // Flag indicating that text is drawn from signed distance field glyphs, rasterized once for all sizes.
+    NVG_SDF_TEXT		= 1<<3,
 };
 
 enum DKNVGuniformLoc
@@ -68,6 +74,7 @@ struct DKNVGcall {
     int triangleCount;
     int uniformOffset;
     DKNVGblend blendFunc;
+    int scissor[4]; // x, y, width, height clipped by the hardware
 };
 
 struct DKNVGpath {
@@ -115,6 +122,11 @@ struct DKNVGcontext {
     unsigned char* uniforms;
     int cuniforms;
     int nuniforms;
+    // High-water marks of the per frame buffers
+    int peakCalls;
+    int peakPaths;
+    int peakVerts;
+    int peakUniforms;
 };
 
 namespace nvg {
@@ -122,6 +134,7 @@ namespace nvg {
     class Texture {
         private:
             const int m_id;
+            int m_descriptor_index = -1;
             dk::Image m_image;
             dk::ImageDescriptor m_image_descriptor;
             CMemPool::Handle m_image_mem;
@@ -130,10 +143,12 @@ namespace nvg {
             Texture(int id);
             ~Texture();
 
-            void Initialize(CMemPool &image_pool, CMemPool &scratch_pool, dk::Device device, dk::Queue transfer_queue, int type, int w, int h, int image_flags, const u8 *data);
+            void Initialize(CMemPool &image_pool, dk::Device device, int type, int w, int h, int image_flags);
             void Update(CMemPool &image_pool, CMemPool &scratch_pool, dk::Device device, dk::Queue transfer_queue, int type, int w, int h, int image_flags, const u8 *data);
 
             int GetId();
+            int GetDescriptorIndex();
+            void SetDescriptorIndex(int index);
             const DKNVGtextureDescriptor &GetDescriptor();
 
             dk::Image &GetImage();
@@ -141,6 +156,11 @@ namespace nvg {
     };
 
     class DkRenderer {
+        public:
+            struct FrameStats {
+                u32 calls;        /* Calls recorded by nanovg. */
+                u32 merged_calls; /* Calls left after merging, each one or more draws. */
+            };
         private:
             enum SamplerType : u8 {
                 SamplerType_MipFilter = 1 << 0,
@@ -149,10 +169,54 @@ namespace nvg {
                 SamplerType_RepeatY   = 1 << 3,
                 SamplerType_Total     = 0x10,
             };
+
+            /* A run of calls drawn together, either a single call or merged calls sharing one indexed draw. */
+            struct Batch {
+                int call;
+                int call_count;
+                u32 first_index;
+                u32 index_count;
+            };
+
+            /* A texture rectangle in the staging ring, copied into the image by the next flush. */
+            struct Upload {
+                std::shared_ptr<Texture> texture;
+                u32 offset;
+                int x, y, w, h;
+            };
+
+            /* A texture id holds its slot index in the low bits and the slot generation above them, ids of deleted textures never resolve. */
+            struct TextureSlot {
+                std::shared_ptr<Texture> texture;
+                u32 generation = 1;
+                int next_free = -1;
+            };
+
+            /* An image descriptor, linked from least to most recently drawn. The epoch tells whether draws recorded since the last invalidate read it. */
+            struct ImageDescriptorEntry {
+                Texture *texture = nullptr;
+                u32 epoch = 0;
+                CIntrusiveListNode<ImageDescriptorEntry> node;
+            };
         private:
             static constexpr size_t DynamicCmdSize = 0x20000;
-            static constexpr size_t FragmentUniformSize = sizeof(DKNVGfragUniforms) + 4 - sizeof(DKNVGfragUniforms) % 4;
+            /* Fragment uniforms are indexed as an array of std430 structs, which are 16 byte aligned. */
+            static constexpr size_t FragmentUniformSize = (sizeof(DKNVGfragUniforms) + 0xF) & ~0xF;
+            /* Image descriptors are a cache, only textures drawn by a flush need one. */
             static constexpr size_t MaxImages = 0x1000;
+            static constexpr int TextureSlotBits = 16;
+            static constexpr u32 TextureSlotMask = (1u << TextureSlotBits) - 1;
+            static constexpr u32 TextureGenerationMask = 0x7FFF;
+            static constexpr u32 TextureChunkSize = 0x400;
+            static constexpr u32 TextureChunks = (TextureSlotMask + 1) / TextureChunkSize;
+            /* Uploads of one flush are staged in one slice, reused once the flush two frames back has finished. */
+            static constexpr u32 StagingSliceSize = 0x20000;
+            static constexpr unsigned StagingSlices = 2;
+            /* Texture contents are copied by batches of uploads, each staged in a slice of its own until its fence has passed. */
+            static constexpr u32 UploadBatchSize = 0x80000; /* Eight 256x256 RGBA title icons. */
+            static constexpr unsigned UploadBatches = 4;
+            static constexpr unsigned UploadBatchCopies = 0x100;
+            static constexpr size_t UploadBatchCmdSize = 0x10000;
 
             /* From the application. */
             u32 m_view_width;
@@ -167,42 +231,103 @@ namespace nvg {
             dk::UniqueCmdBuf m_dyn_cmd_buf;
             CCmdMemRing<1> m_dyn_cmd_mem;
             std::optional<CMemPool::Handle> m_vertex_buffer;
+            std::optional<CMemPool::Handle> m_paint_buffer;
+            std::optional<CMemPool::Handle> m_index_buffer;
+            std::optional<CMemPool::Handle> m_frag_uniform_buffer;
             CShader m_vertex_shader;
             CShader m_fragment_shader;
             CMemPool::Handle m_view_uniform_buffer;
-            CMemPool::Handle m_frag_uniform_buffer;
 
-            u32 m_next_texture_id = 1;
-            std::vector<std::shared_ptr<Texture>> m_textures;
+            /* Per flush state, used to skip redundant state changes. */
+            int m_bound_paint;
+            int m_bound_image;
+            DKNVGblend m_bound_blend;
+            int m_bound_scissor[4];
+            FrameStats m_frame_stats = {};
+            std::vector<Batch> m_batches;
+
+            /* Texture updates waiting for the next flush. */
+            CMemPool::Handle m_staging_mem;
+            dk::Fence m_staging_fences[StagingSlices] = {};
+            unsigned m_staging_slice = 0;
+            u32 m_staging_offset = 0;
+            bool m_staging_acquired = false;
+            std::vector<Upload> m_uploads;
+
+            /* Texture uploads, each batch is staged in the slice with its index, guarded by the fence of the last list copying from it. */
+            CMemPool::Handle m_upload_mem;
+            dk::UniqueCmdBuf m_upload_cmd_buf;
+            CCmdMemRing<UploadBatches> m_upload_cmd_mem;
+            std::array<std::vector<std::shared_ptr<Texture>>, UploadBatches> m_upload_textures;
+            unsigned m_upload_batch = 0;
+            u32 m_upload_offset = 0;
+            unsigned m_upload_copies = 0;
+            bool m_upload_open = false;
+            dk::Fence m_upload_fences[UploadBatches] = {};
+            /* Ranges of the open batch handed out by MapTexture() and not taken by a CreateTexture() yet. A pinned batch submits the
+               copies recorded so far and keeps its slice open, only an upload that needs a fresh slice waits for m_upload_unpinned. */
+            unsigned m_upload_pins = 0;
+            std::condition_variable_any m_upload_unpinned;
+
+            /* Textures are created on the scan thread while the main thread draws and flushes. Guards the uploads, the slots and the
+               image descriptors, it is not held while pixels are decoded into a mapped range. */
+            std::mutex m_texture_mutex;
+
+            /* Slots are allocated in chunks which never move, so lookups stay valid while textures are created. */
+            std::array<std::unique_ptr<TextureSlot[]>, TextureChunks> m_texture_chunks;
+            int m_texture_slot_count = 0;
+            int m_free_texture_slot = -1;
             CDescriptorSet<MaxImages> m_image_descriptor_set;
             CDescriptorSet<SamplerType_Total> m_sampler_descriptor_set;
-            std::array<int, MaxImages> m_image_descriptor_mappings;
-            int m_last_image_descriptor = 0;
+            std::array<ImageDescriptorEntry, MaxImages> m_image_descriptors;
+            CIntrusiveList<ImageDescriptorEntry, &ImageDescriptorEntry::node> m_image_descriptor_lru;
+            u32 m_image_descriptor_epoch = 0;
 
-            int AcquireImageDescriptor(std::shared_ptr<Texture> texture, int image);
-            void FreeImageDescriptor(int image);
+            int AcquireImageDescriptor(Texture *texture);
+            void FreeImageDescriptor(Texture *texture);
+            size_t UpdateImageDescriptors(const DKNVGcontext &ctx, size_t first_batch);
             void SetUniforms(const DKNVGcontext &ctx, int offset, int image);
+            void BindPaint(int paint);
+            void BindImage(int image);
+            void BindBlend(const DKNVGblend &blend);
+            void BindScissor(const int *scissor);
 
-            void UpdateVertexBuffer(const void *data, size_t size);
+            void *ReserveBuffer(std::optional<CMemPool::Handle> &buffer, size_t size, u32 alignment);
+            void UpdateBuffers(const DKNVGcontext &ctx);
+            void BuildBatches(const DKNVGcontext &ctx);
 
             void DrawFill(const DKNVGcontext &ctx, const DKNVGcall &call);
-            void DrawConvexFill(const DKNVGcontext &ctx, const DKNVGcall &call);
             void DrawStroke(const DKNVGcontext &ctx, const DKNVGcall &call);
-            void DrawTriangles(const DKNVGcontext &ctx, const DKNVGcall &call);
+            void DrawBatch(const DKNVGcontext &ctx, const DKNVGcall &call, u32 first_index, u32 index_count);
+
+            bool StageUpload(const std::shared_ptr<Texture> &texture, int x, int y, int w, int h, const u8 *data);
+            void RecordUploads(dk::CmdBuf cmd_buf);
+            void CopyStagedUploads();
+            void SubmitUploads();
 
-            std::shared_ptr<Texture> FindTexture(int id);
+            u32 ReserveUpload(u32 size);
+            void QueueUpload(const std::shared_ptr<Texture> &texture, u32 offset, int y, int h);
+            void UploadRows(const std::shared_ptr<Texture> &texture, int y, int h, const u8 *data);
+            void SubmitUploadBatch();
+
+            TextureSlot &GetTextureSlot(u32 index);
+            TextureSlot *FindTextureSlot(int id);
+            Texture *FindTexture(int id);
         public:
             DkRenderer(unsigned int view_width, unsigned int view_height, dk::Device device, dk::Queue queue, CMemPool &image_mem_pool, CMemPool &code_mem_pool, CMemPool &data_mem_pool);
             ~DkRenderer();
 
             int Create(DKNVGcontext &ctx);
             int CreateTexture(const DKNVGcontext &ctx, int type, int w, int h, int image_flags, const u8 *data);
+            u8 *MapTexture(const DKNVGcontext &ctx, int type, int w, int h);
             int DeleteTexture(const DKNVGcontext &ctx, int id);
             int UpdateTexture(const DKNVGcontext &ctx, int id, int x, int y, int w, int h, const u8 *data);
             int GetTextureSize(const DKNVGcontext &ctx, int id, int *w, int *h);
             const DKNVGtextureDescriptor *GetTextureDescriptor(const DKNVGcontext &ctx, int id);
 
             void Flush(DKNVGcontext &ctx);
+
+            const FrameStats &GetFrameStats() const;
     };
 
 }
\ No newline at end of file
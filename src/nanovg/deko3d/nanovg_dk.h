@@ -31,6 +31,12 @@ static int dknvg__renderCreateTexture(void* uptr, int type, int w, int h, int im
     return dk->renderer->CreateTexture(*dk, type, w, h, imageFlags, data);
 }
 
+static unsigned char* dknvg__renderMapTexture(void* uptr, int type, int w, int h)
+{
+    DKNVGcontext *dk = (DKNVGcontext*)uptr;
+    return dk->renderer->MapTexture(*dk, type, w, h);
+}
+
 static int dknvg__renderDeleteTexture(void* uptr, int image) {
     DKNVGcontext *dk = (DKNVGcontext*)uptr;
     return dk->renderer->DeleteTexture(*dk, image);
@@ -68,21 +74,74 @@ static NVGcolor dknvg__premulColor(NVGcolor c) {
     return c;
 }
 
+static int dknvg__isIntegral(float a) { return a == floorf(a); }
+
+// Returns 1 if the scissor can be applied by the hardware with the same result as the shader,
+// that is, no scissor at all or an axis-aligned one with hard edges on the pixel grid.
+// rect receives the clip rect as x, y, width, height.
+static int dknvg__hardwareScissor(DKNVGcontext* dk, NVGscissor* scissor, float fringe, int* rect)
+{
+    const float* t = scissor->xform;
+    float x0, y0, x1, y1;
+
+    if (scissor->extent[0] < -0.5f || scissor->extent[1] < -0.5f) {
+        rect[0] = 0;
+        rect[1] = 0;
+        rect[2] = (int)dk->view[0];
+        rect[3] = (int)dk->view[1];
+        return 1;
+    }
+
+    // The shader fades the edge over fringe/scale pixels, the hardware has no fade.
+    if (t[1] != 0.0f || t[2] != 0.0f || fabsf(t[0]) < fringe || fabsf(t[3]) < fringe)
+        return 0;
+
+    x0 = t[4] - fabsf(t[0]) * scissor->extent[0];
+    y0 = t[5] - fabsf(t[3]) * scissor->extent[1];
+    x1 = t[4] + fabsf(t[0]) * scissor->extent[0];
+    y1 = t[5] + fabsf(t[3]) * scissor->extent[1];
+    if (!dknvg__isIntegral(x0) || !dknvg__isIntegral(y0) || !dknvg__isIntegral(x1) || !dknvg__isIntegral(y1))
+        return 0;
+
+    x0 = x0 < 0.0f ? 0.0f : x0;
+    y0 = y0 < 0.0f ? 0.0f : y0;
+    x1 = x1 > dk->view[0] ? dk->view[0] : x1;
+    y1 = y1 > dk->view[1] ? dk->view[1] : y1;
+    rect[0] = (int)x0;
+    rect[1] = (int)y0;
+    rect[2] = x1 > x0 ? (int)(x1 - x0) : 0;
+    rect[3] = y1 > y0 ? (int)(y1 - y0) : 0;
+    return 1;
+}
+
+// Sets the hardware scissor of the call, the full view if the shader does the clipping.
+static void dknvg__setCallScissor(DKNVGcontext* dk, DKNVGcall* call, NVGscissor* scissor, float fringe)
+{
+    if (!dknvg__hardwareScissor(dk, scissor, fringe, call->scissor)) {
+        call->scissor[0] = 0;
+        call->scissor[1] = 0;
+        call->scissor[2] = (int)dk->view[0];
+        call->scissor[3] = (int)dk->view[1];
+    }
+}
+
 static int dknvg__convertPaint(DKNVGcontext* dk, DKNVGfragUniforms* frag, NVGpaint* paint,
                                NVGscissor* scissor, float width, float fringe, float strokeThr)
 {
     const DKNVGtextureDescriptor *tex = NULL;
     float invxform[6];
+    int rect[4];
 
     memset(frag, 0, sizeof(*frag));
 
     frag->innerCol = dknvg__premulColor(paint->innerColor);
     frag->outerCol = dknvg__premulColor(paint->outerColor);
 
-    if (scissor->extent[0] < -0.5f || scissor->extent[1] < -0.5f) {
+    if (dknvg__hardwareScissor(dk, scissor, fringe, rect)) {
+        // Negative extent skips scissoring in the shader.
         memset(frag->scissorMat, 0, sizeof(frag->scissorMat));
-        frag->scissorExt[0] = 1.0f;
-        frag->scissorExt[1] = 1.0f;
+        frag->scissorExt[0] = -1.0f;
+        frag->scissorExt[1] = -1.0f;
         frag->scissorScale[0] = 1.0f;
         frag->scissorScale[1] = 1.0f;
     } else {
@@ -118,7 +177,7 @@ static int dknvg__convertPaint(DKNVGcontext* dk, DKNVGfragUniforms* frag, NVGpai
         if (tex->type == NVG_TEXTURE_RGBA)
             frag->texType = (tex->flags & NVG_IMAGE_PREMULTIPLIED) ? 0 : 1;
         else
-            frag->texType = 2;
+            frag->texType = (tex->flags & NVG_IMAGE_SDF) ? 3 : 2;
 //		printf("frag->texType = %d\n", frag->texType);
     } else {
         frag->type = NSVG_SHADER_FILLGRAD;
@@ -134,16 +193,46 @@ static int dknvg__convertPaint(DKNVGcontext* dk, DKNVGfragUniforms* frag, NVGpai
 
 static DKNVGfragUniforms* nvg__fragUniformPtr(DKNVGcontext* dk, int i);
 
+static void* dknvg__reserveBuffer(void* buf, int* cap, int n, size_t size)
+{
+    void* ret;
+    if (n <= *cap) return buf;
+    ret = realloc(buf, size * n);
+    if (ret == NULL) return buf; // The alloc functions will try again.
+    *cap = n;
+    return ret;
+}
+
+static void dknvg__recordPeaks(DKNVGcontext* dk)
+{
+    dk->peakCalls = dknvg__maxi(dk->peakCalls, dk->ncalls);
+    dk->peakPaths = dknvg__maxi(dk->peakPaths, dk->npaths);
+    dk->peakVerts = dknvg__maxi(dk->peakVerts, dk->nverts);
+    dk->peakUniforms = dknvg__maxi(dk->peakUniforms, dk->nuniforms);
+}
+
+// Grows the per frame buffers while they are empty to what earlier frames needed, plus some headroom.
+// Only a frame that sets a new peak has to grow (and copy) a buffer halfway through.
+static void dknvg__reserveFrame(DKNVGcontext* dk)
+{
+    dk->calls = (DKNVGcall*)dknvg__reserveBuffer(dk->calls, &dk->ccalls, dk->peakCalls + dk->peakCalls/4, sizeof(DKNVGcall));
+    dk->paths = (DKNVGpath*)dknvg__reserveBuffer(dk->paths, &dk->cpaths, dk->peakPaths + dk->peakPaths/4, sizeof(DKNVGpath));
+    dk->verts = (NVGvertex*)dknvg__reserveBuffer(dk->verts, &dk->cverts, dk->peakVerts + dk->peakVerts/4, sizeof(NVGvertex));
+    dk->uniforms = (unsigned char*)dknvg__reserveBuffer(dk->uniforms, &dk->cuniforms, dk->peakUniforms + dk->peakUniforms/4, dk->fragSize);
+}
+
 static void dknvg__renderViewport(void* uptr, float width, float height, float devicePixelRatio)
 {
     NVG_NOTUSED(devicePixelRatio);
     DKNVGcontext* dk = (DKNVGcontext*)uptr;
     dk->view[0] = width;
     dk->view[1] = height;
+    dknvg__reserveFrame(dk);
 }
 
 static void dknvg__renderCancel(void* uptr) {
     DKNVGcontext* dk = (DKNVGcontext*)uptr;
+    dknvg__recordPeaks(dk);
     dk->nverts = 0;
     dk->npaths = 0;
     dk->ncalls = 0;
@@ -197,6 +286,7 @@ static DKNVGblend dknvg__blendCompositeOperation(NVGcompositeOperationState op)
 
 static void dknvg__renderFlush(void* uptr) {
     DKNVGcontext *dk = (DKNVGcontext*)uptr;
+    dknvg__recordPeaks(dk);
     dk->renderer->Flush(*dk);
 }
 
@@ -286,6 +376,40 @@ static void dknvg__vset(NVGvertex* vtx, float x, float y, float u, float v)
     vtx->v = v;
 }
 
+// Draws a fill that nanovg triangulated as one triangle list, the half fringe strip is unrolled behind the fill triangles.
+static void dknvg__renderTriangulatedFill(DKNVGcontext* dk, DKNVGcall* call, NVGpaint* paint, NVGscissor* scissor, float fringe,
+                                          const NVGpath* path)
+{
+    NVGvertex* dst;
+    int i, nstrip = path->nstroke >= 3 ? path->nstroke - 2 : 0;
+
+    call->type = DKNVG_TRIANGLES;
+    call->triangleCount = path->nfill + nstrip * 3;
+    call->triangleOffset = dknvg__allocVerts(dk, call->triangleCount);
+    if (call->triangleOffset == -1) goto error;
+
+    dst = &dk->verts[call->triangleOffset];
+    memcpy(dst, path->fill, sizeof(NVGvertex) * path->nfill);
+    dst += path->nfill;
+    for (i = 0; i < nstrip; i++) {
+        // Every other strip triangle is flipped to keep the winding.
+        *dst++ = path->stroke[i + (i & 1)];
+        *dst++ = path->stroke[i + 1 - (i & 1)];
+        *dst++ = path->stroke[i + 2];
+    }
+
+    call->uniformOffset = dknvg__allocFragUniforms(dk, 1);
+    if (call->uniformOffset == -1) goto error;
+    dknvg__convertPaint(dk, nvg__fragUniformPtr(dk, call->uniformOffset), paint, scissor, fringe, fringe, -1.0f);
+
+    return;
+
+error:
+    // We get here if call alloc was ok, but something else is not.
+    // Roll back the last call to prevent drawing it.
+    if (dk->ncalls > 0) dk->ncalls--;
+}
+
 static void dknvg__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
                               const float* bounds, const NVGpath* paths, int npaths)
 {
@@ -297,13 +421,22 @@ static void dknvg__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperation
 
     if (call == NULL) return;
 
+    call->image = paint->image;
+    call->blendFunc = dknvg__blendCompositeOperation(compositeOperation);
+    dknvg__setCallScissor(dk, call, scissor, fringe);
+
+    if (npaths == 1 && paths[0].triangulated)
+    {
+        // Skips the stencil and cover passes entirely.
+        dknvg__renderTriangulatedFill(dk, call, paint, scissor, fringe, &paths[0]);
+        return;
+    }
+
     call->type = DKNVG_FILL;
     call->triangleCount = 4;
     call->pathOffset = dknvg__allocPaths(dk, npaths);
     if (call->pathOffset == -1) goto error;
     call->pathCount = npaths;
-    call->image = paint->image;
-    call->blendFunc = dknvg__blendCompositeOperation(compositeOperation);
 
     if (npaths == 1 && paths[0].convex)
     {
@@ -385,6 +518,7 @@ static void dknvg__renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperati
     call->pathCount = npaths;
     call->image = paint->image;
     call->blendFunc = dknvg__blendCompositeOperation(compositeOperation);
+    dknvg__setCallScissor(dk, call, scissor, fringe);
 
     // Allocate vertices for all the paths.
     maxverts = dknvg__maxVertCount(paths, npaths);
@@ -438,6 +572,7 @@ static void dknvg__renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOper
     call->type = DKNVG_TRIANGLES;
     call->image = paint->image;
     call->blendFunc = dknvg__blendCompositeOperation(compositeOperation);
+    dknvg__setCallScissor(dk, call, scissor, fringe);
 
     // Allocate vertices for all the paths.
     call->triangleOffset = dknvg__allocVerts(dk, nverts);
@@ -461,6 +596,61 @@ error:
     if (dk->ncalls > 0) dk->ncalls--;
 }
 
+static void dknvg__renderFillRect(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+                                  const float* rect)
+{
+    DKNVGcontext* dk = (DKNVGcontext*)uptr;
+    DKNVGcall* call = dk->ncalls > 0 ? &dk->calls[dk->ncalls - 1] : NULL;
+    DKNVGblend blend = dknvg__blendCompositeOperation(compositeOperation);
+    DKNVGfragUniforms frag;
+    DKNVGcall next;
+    NVGvertex* quad;
+    int offset;
+
+    dknvg__convertPaint(dk, &frag, paint, scissor, fringe, fringe, -1.0f);
+    dknvg__setCallScissor(dk, &next, scissor, fringe);
+
+    // Append to the previous rect if it is drawn with the exact same state and its vertices end the stream.
+    if (call == NULL || call->type != DKNVG_TRIANGLES || call->image != paint->image ||
+        memcmp(&call->blendFunc, &blend, sizeof(blend)) != 0 ||
+        memcmp(call->scissor, next.scissor, sizeof(next.scissor)) != 0 ||
+        call->triangleOffset + call->triangleCount != dk->nverts ||
+        memcmp(nvg__fragUniformPtr(dk, call->uniformOffset), &frag, sizeof(frag)) != 0)
+    {
+        call = dknvg__allocCall(dk);
+        if (call == NULL) return;
+
+        call->type = DKNVG_TRIANGLES;
+        call->image = paint->image;
+        call->blendFunc = blend;
+        memcpy(call->scissor, next.scissor, sizeof(next.scissor));
+        call->triangleOffset = dk->nverts;
+        call->uniformOffset = dknvg__allocFragUniforms(dk, 1);
+        if (call->uniformOffset == -1) goto error;
+        memcpy(nvg__fragUniformPtr(dk, call->uniformOffset), &frag, sizeof(frag));
+    }
+
+    offset = dknvg__allocVerts(dk, 6);
+    if (offset == -1) goto error;
+    call->triangleCount += 6;
+
+    // Same winding as text quads.
+    quad = &dk->verts[offset];
+    dknvg__vset(&quad[0], rect[0], rect[1], 0.5f, 1.0f);
+    dknvg__vset(&quad[1], rect[2], rect[3], 0.5f, 1.0f);
+    dknvg__vset(&quad[2], rect[2], rect[1], 0.5f, 1.0f);
+    dknvg__vset(&quad[3], rect[0], rect[1], 0.5f, 1.0f);
+    dknvg__vset(&quad[4], rect[0], rect[3], 0.5f, 1.0f);
+    dknvg__vset(&quad[5], rect[2], rect[3], 0.5f, 1.0f);
+
+    return;
+
+error:
+    // We get here if call alloc was ok, but something else is not.
+    // Roll back the last call to prevent drawing it.
+    if (call->triangleCount == 0 && dk->ncalls > 0) dk->ncalls--;
+}
+
 static void dknvg__renderDelete(void* uptr) {
     DKNVGcontext* dk = (DKNVGcontext*)uptr;
     if (dk == NULL) return;
@@ -483,6 +673,7 @@ NVGcontext* nvgCreateDk(nvg::DkRenderer *renderer, int flags) {
     memset(&params, 0, sizeof(params));
     params.renderCreate = dknvg__renderCreate;
     params.renderCreateTexture = dknvg__renderCreateTexture;
+    params.renderMapTexture = dknvg__renderMapTexture;
     params.renderDeleteTexture = dknvg__renderDeleteTexture;
     params.renderUpdateTexture = dknvg__renderUpdateTexture;
     params.renderGetTextureSize = dknvg__renderGetTextureSize;
@@ -492,6 +683,9 @@ NVGcontext* nvgCreateDk(nvg::DkRenderer *renderer, int flags) {
     params.renderFill = dknvg__renderFill;
     params.renderStroke = dknvg__renderStroke;
     params.renderTriangles = dknvg__renderTriangles;
+    params.renderFillRect = dknvg__renderFillRect;
+    params.triangulateFills = 1;
+    params.sdfText = flags & NVG_SDF_TEXT ? 1 : 0;
     params.renderDelete = dknvg__renderDelete;
     params.userPtr = dk;
     params.edgeAntiAlias = flags & NVG_ANTIALIAS ? 1 : 0;
@@ -2,7 +2,7 @@
 
 layout(binding = 0) uniform sampler2D tex;
 
-layout(std140, binding = 0) uniform frag {
+struct Frag {
     mat3 scissorMat;
     mat3 paintMat;
     vec4 innerCol;
@@ -18,8 +18,14 @@ layout(std140, binding = 0) uniform frag {
     int type;
 };
 
+// All paints of the frame, indexed by the paint of the vertex.
+layout(std430, binding = 0) readonly buffer Frags {
+    Frag frags[];
+};
+
 layout(location = 0) in vec2 ftcoord;
 layout(location = 1) in vec2 fpos;
+layout(location = 2) flat in uint fpaint;
 layout(location = 0) out vec4 outColor;
 
 float sdroundrect(vec2 pt, vec2 ext, float rad) {
@@ -29,54 +35,63 @@ float sdroundrect(vec2 pt, vec2 ext, float rad) {
 }
 
 // Scissoring
-float scissorMask(vec2 p) {
-    vec2 sc = (abs((scissorMat * vec3(p,1.0)).xy) - scissorExt);
-    sc = vec2(0.5,0.5) - sc * scissorScale;
+float scissorMask(Frag f, vec2 p) {
+    vec2 sc = (abs((f.scissorMat * vec3(p,1.0)).xy) - f.scissorExt);
+    sc = vec2(0.5,0.5) - sc * f.scissorScale;
     return clamp(sc.x,0.0,1.0) * clamp(sc.y,0.0,1.0);
 }
 
 // Stroke - from [0..1] to clipped pyramid, where the slope is 1px.
-float strokeMask() {
-    return min(1.0, (1.0-abs(ftcoord.x*2.0-1.0))*strokeMult) * min(1.0, ftcoord.y);
+float strokeMask(Frag f) {
+    return min(1.0, (1.0-abs(ftcoord.x*2.0-1.0))*f.strokeMult) * min(1.0, ftcoord.y);
+}
+
+// Coverage of a signed distance field texel, the edge at 0.5 is smoothed over one pixel at any scale.
+float sdfCoverage(float d) {
+    return clamp((d - 0.5) / max(fwidth(d), 1e-4) + 0.5, 0.0, 1.0);
 }
 
 void main(void) {
+    const Frag f = frags[fpaint];
     vec4 result;
-    float scissor = scissorMask(fpos);
-    float strokeAlpha = strokeMask();
+    // Axis-aligned scissors are clipped by the hardware and come with a negative extent.
+    float scissor = f.scissorExt.x < 0.0 ? 1.0 : scissorMask(f, fpos);
+    float strokeAlpha = strokeMask(f);
 
-    if (strokeAlpha < strokeThr) discard;
+    if (strokeAlpha < f.strokeThr) discard;
 
-    if (type == 0) {			// Gradient
+    if (f.type == 0) {			// Gradient
         // Calculate gradient color using box gradient
-        vec2 pt = (paintMat * vec3(fpos,1.0)).xy;
-        float d = clamp((sdroundrect(pt, extent, radius) + feather*0.5) / feather, 0.0, 1.0);
-        vec4 color = mix(innerCol,outerCol,d);
+        vec2 pt = (f.paintMat * vec3(fpos,1.0)).xy;
+        float d = clamp((sdroundrect(pt, f.extent, f.radius) + f.feather*0.5) / f.feather, 0.0, 1.0);
+        vec4 color = mix(f.innerCol,f.outerCol,d);
         // Combine alpha
         color *= strokeAlpha * scissor;
         result = color;
-    } else if (type == 1) {		// Image
+    } else if (f.type == 1) {		// Image
         // Calculate color fron texture
-        vec2 pt = (paintMat * vec3(fpos,1.0)).xy / extent;
+        vec2 pt = (f.paintMat * vec3(fpos,1.0)).xy / f.extent;
         vec4 color = texture(tex, pt);
 
-        if (texType == 1) color = vec4(color.xyz*color.w,color.w);
-        if (texType == 2) color = vec4(color.x);
+        if (f.texType == 1) color = vec4(color.xyz*color.w,color.w);
+        if (f.texType == 2) color = vec4(color.x);
+        if (f.texType == 3) color = vec4(sdfCoverage(color.x));
         // Apply color tint and alpha.
-        color *= innerCol;
+        color *= f.innerCol;
         // Combine alpha
         color *= strokeAlpha * scissor;
         result = color;
-    } else if (type == 2) {		// Stencil fill
+    } else if (f.type == 2) {		// Stencil fill
         result = vec4(1,1,1,1);
-    } else if (type == 3) {		// Textured tris
+    } else if (f.type == 3) {		// Textured tris
 
         vec4 color = texture(tex, ftcoord);
 
-        if (texType == 1) color = vec4(color.xyz*color.w,color.w);
-        if (texType == 2) color = vec4(color.x);
+        if (f.texType == 1) color = vec4(color.xyz*color.w,color.w);
+        if (f.texType == 2) color = vec4(color.x);
+        if (f.texType == 3) color = vec4(sdfCoverage(color.x));
         color *= scissor;
-        result = color * innerCol;
+        result = color * f.innerCol;
     }
 
     outColor = result;
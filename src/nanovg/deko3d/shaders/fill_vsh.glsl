@@ -2,16 +2,21 @@
 
 layout (location = 0) in vec2 vertex;
 layout (location = 1) in vec2 tcoord;
+layout (location = 2) in uint paint;
 layout (location = 0) out vec2 ftcoord;
 layout (location = 1) out vec2 fpos;
+layout (location = 2) flat out uint fpaint;
 
 layout (std140, binding = 0) uniform View
 {
     vec2 size;
+    // Paint used by the whole draw, or -1 to take it from the vertex.
+    int paint;
 } view;
 
 void main(void) {
     ftcoord = tcoord;
     fpos = vertex;
+    fpaint = view.paint >= 0 ? uint(view.paint) : paint;
     gl_Position = vec4(2.0*vertex.x/view.size.x - 1.0, 1.0 - 2.0*vertex.y/view.size.y, 0, 1);
-};
\ No newline at end of file
+};
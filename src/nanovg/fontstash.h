@@ -24,6 +24,9 @@
 enum FONSflags {
 	FONS_ZERO_TOPLEFT = 1,
 	FONS_ZERO_BOTTOMLEFT = 2,
+	// Rasterize each glyph once as a signed distance field and scale it to every size.
+	// The texture then holds distances, 128 being the outline, and needs an SDF aware shader.
+	FONS_SDF = 4,
 };
 
 enum FONSalign {
@@ -94,6 +97,11 @@ FONScontext* fonsCreateInternal(FONSparams* params);
 void fonsDeleteInternal(FONScontext* s);
 
 void fonsSetErrorCallback(FONScontext* s, void (*callback)(void* uptr, int error, int val), void* uptr);
+// Rasterizes new glyphs on other threads, run(uptr, func, arg) has to call func(arg) on another thread
+// and return without waiting for it. A glyph draws empty until its bitmap is copied into the atlas by a
+// later fonsValidateTexture(), every other function still has to be called from one thread.
+// Pass NULL to rasterize on the calling thread again. Not supported with FreeType.
+void fonsSetRasterizer(FONScontext* s, void (*run)(void* uptr, void (*func)(void* arg), void* arg), void* uptr);
 // Returns current atlas size.
 void fonsGetAtlasSize(FONScontext* s, int* width, int* height);
 // Expands the atlas size.
@@ -138,6 +146,11 @@ int fonsValidateTexture(FONScontext* s, int* dirty);
 // Draws the stash texture for debugging
 void fonsDrawDebug(FONScontext* s, float x, float y);
 
+// Atlas cache, saves the atlas with its glyphs and restores them on a later run.
+// Glyphs are only restored for fonts whose data and fallbacks match the saved ones.
+int fonsSaveAtlas(FONScontext* s, const char* path);
+int fonsLoadAtlas(FONScontext* s, const char* path);
+
 #endif // FONTSTASH_H
 
 
@@ -145,6 +158,9 @@ void fonsDrawDebug(FONScontext* s, float x, float y);
 
 #define FONS_NOTUSED(v)  (void)sizeof(v)
 
+#include <stdatomic.h>
+#include <threads.h>
+
 #ifdef FONS_USE_FREETYPE
 
 #include <ft2build.h>
@@ -245,6 +261,48 @@ void fons__tt_renderGlyphBitmap(FONSttFontImpl *font, unsigned char *output, int
 	}
 }
 
+int fons__tt_renderGlyphSDF(FONSttFontImpl *font, unsigned char *output, int outWidth, int outHeight, int outStride,
+							 float scale, int padding, int glyph)
+{
+	// Distance fields are only built with stb_truetype, the glyph is left empty.
+	FONS_NOTUSED(font);
+	FONS_NOTUSED(output);
+	FONS_NOTUSED(outWidth);
+	FONS_NOTUSED(outHeight);
+	FONS_NOTUSED(outStride);
+	FONS_NOTUSED(scale);
+	FONS_NOTUSED(padding);
+	FONS_NOTUSED(glyph);
+	return 0;
+}
+
+// FreeType loads and renders a glyph in one go, there is no outline to keep.
+struct FONSttOutline {
+	int unused;
+};
+typedef struct FONSttOutline FONSttOutline;
+
+int fons__tt_buildOutline(FONSttFontImpl *font, int glyph, float scale, FONSttOutline *outline)
+{
+	FONS_NOTUSED(font);
+	FONS_NOTUSED(glyph);
+	FONS_NOTUSED(scale);
+	FONS_NOTUSED(outline);
+	return 0;
+}
+
+void fons__tt_freeOutline(FONSttOutline *outline)
+{
+	FONS_NOTUSED(outline);
+}
+
+void fons__tt_renderOutline(FONSttFontImpl *font, const FONSttOutline *outline, unsigned char *output, int outWidth, int outHeight,
+							int outStride, float scale, int glyph)
+{
+	FONS_NOTUSED(outline);
+	fons__tt_renderGlyphBitmap(font, output, outWidth, outHeight, outStride, scale, scale, glyph);
+}
+
 int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 {
 	FT_Vector ftKerning;
@@ -323,6 +381,86 @@ void fons__tt_renderGlyphBitmap(FONSttFontImpl *font, unsigned char *output, int
 	stbtt_MakeGlyphBitmap(&font->font, output, outWidth, outHeight, outStride, scaleX, scaleY, glyph);
 }
 
+int fons__tt_renderGlyphSDF(FONSttFontImpl *font, unsigned char *output, int outWidth, int outHeight, int outStride,
+							 float scale, int padding, int glyph)
+{
+	int x, y, w, h, xoff, yoff;
+	unsigned char* sdf = stbtt_GetGlyphSDF(&font->font, scale, glyph, padding, 128, 128.0f/padding, &w, &h, &xoff, &yoff);
+	if (sdf == NULL) return 0;
+	// The field covers the bitmap box grown by the padding, same as the space reserved by the caller.
+	if (w > outWidth) w = outWidth;
+	if (h > outHeight) h = outHeight;
+	for (y = 0; y < h; y++) {
+		for (x = 0; x < w; x++) {
+			output[y*outStride + x] = sdf[y*w + x];
+		}
+	}
+	stbtt_FreeSDF(sdf, font->font.userdata);
+	return 1;
+}
+
+// Decoded shape of a glyph, shared by all sizes. The points are flattened for the scale the outline
+// was built at and serve that scale and smaller ones, larger scales flatten the vertices again.
+struct FONSttOutline {
+	stbtt_vertex* verts;
+	int nverts;
+	stbtt__point* points;
+	int* contours;
+	int ncontours;
+	float scale;
+};
+typedef struct FONSttOutline FONSttOutline;
+
+int fons__tt_buildOutline(FONSttFontImpl *font, int glyph, float scale, FONSttOutline *outline)
+{
+	// Outlines outlive the scratch buffer, allocate them from the heap.
+	stbtt_fontinfo info = font->font;
+	info.userdata = NULL;
+
+	memset(outline, 0, sizeof(*outline));
+	outline->nverts = stbtt_GetGlyphShape(&info, glyph, &outline->verts);
+	if (outline->nverts <= 0) {
+		STBTT_free(outline->verts, NULL);
+		return 0;
+	}
+	// Same tolerance as stbtt_MakeGlyphBitmap().
+	outline->points = stbtt_FlattenCurves(outline->verts, outline->nverts, 0.35f / scale, &outline->contours, &outline->ncontours, NULL);
+	if (outline->points == NULL) {
+		STBTT_free(outline->verts, NULL);
+		return 0;
+	}
+	outline->scale = scale;
+	return 1;
+}
+
+void fons__tt_freeOutline(FONSttOutline *outline)
+{
+	STBTT_free(outline->verts, NULL);
+	STBTT_free(outline->points, NULL);
+	STBTT_free(outline->contours, NULL);
+}
+
+void fons__tt_renderOutline(FONSttFontImpl *font, const FONSttOutline *outline, unsigned char *output, int outWidth, int outHeight,
+							int outStride, float scale, int glyph)
+{
+	int ix0, iy0;
+	stbtt__bitmap gbm;
+
+	stbtt_GetGlyphBitmapBox(&font->font, glyph, scale, scale, &ix0, &iy0, 0, 0);
+	gbm.pixels = output;
+	gbm.w = outWidth;
+	gbm.h = outHeight;
+	gbm.stride = outStride;
+	if (gbm.w == 0 || gbm.h == 0)
+		return;
+
+	if (scale <= outline->scale) {
+		stbtt__rasterize(&gbm, outline->points, outline->contours, outline->ncontours, scale, scale, 0, 0, ix0, iy0, 1, font->font.userdata);
+	} else {
+		stbtt_Rasterize(&gbm, 0.35f, outline->verts, outline->nverts, scale, scale, 0, 0, ix0, iy0, 1, font->font.userdata);
+	}
+}
+
 int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 {
 	return stbtt_GetGlyphKernAdvance(&font->font, glyph1, glyph2);
@@ -330,15 +468,28 @@ int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 
 #endif
 
+#ifndef FONS_SDF_SIZE
+// Pixel size the distance fields are rasterized at.
+#	define FONS_SDF_SIZE 32
+#endif
+#ifndef FONS_SDF_PADDING
+// Texels of distance kept around a distance field glyph.
+#	define FONS_SDF_PADDING 4
+#endif
 #ifndef FONS_SCRATCH_BUF_SIZE
 #	define FONS_SCRATCH_BUF_SIZE 96000
 #endif
-#ifndef FONS_HASH_LUT_SIZE
-#	define FONS_HASH_LUT_SIZE 256
+#ifndef FONS_OUTLINE_SIZE
+// Pixel size glyph outlines are flattened for, when rasterized at it or below it is not done again.
+#	define FONS_OUTLINE_SIZE 48
+#endif
+#ifndef FONS_OUTLINE_CACHE_SIZE
+#	define FONS_OUTLINE_CACHE_SIZE 256	// Must be power of two.
 #endif
 #ifndef FONS_INIT_FONTS
 #	define FONS_INIT_FONTS 4
 #endif
+#define FONS_ASCII_GLYPHS 95
 #ifndef FONS_INIT_GLYPHS
 #	define FONS_INIT_GLYPHS 256
 #endif
@@ -366,6 +517,11 @@ static unsigned int fons__hashint(unsigned int a)
 	return a;
 }
 
+static unsigned int fons__glyphHash(unsigned int codepoint, short size, short blur)
+{
+	return fons__hashint(codepoint ^ ((unsigned int)size << 11) ^ ((unsigned int)blur << 26));
+}
+
 static int fons__mini(int a, int b)
 {
 	return a < b ? a : b;
@@ -376,11 +532,22 @@ static int fons__maxi(int a, int b)
 	return a > b ? a : b;
 }
 
+// FNV-1a, identifies fonts in the atlas cache.
+static unsigned int fons__checksum(const unsigned char* data, int ndata)
+{
+	unsigned int h = 2166136261u;
+	int i;
+	for (i = 0; i < ndata; i++) {
+		h ^= data[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
 struct FONSglyph
 {
 	unsigned int codepoint;
 	int index;
-	int next;
 	short size, blur;
 	short x0,y0,x1,y1;
 	short xadv,xoff,yoff;
@@ -394,13 +561,18 @@ struct FONSfont
 	unsigned char* data;
 	int dataSize;
 	unsigned char freeData;
+	unsigned int checksum;
 	float ascender;
 	float descender;
 	float lineh;
 	FONSglyph* glyphs;
 	int cglyphs;
 	int nglyphs;
-	int lut[FONS_HASH_LUT_SIZE];
+	// Open addressing table of glyph indices, linear probing, at most half full.
+	int* table;
+	int ctable;
+	// Direct-mapped glyph indices of printable ASCII, the last size and blur looked up wins.
+	int ascii[FONS_ASCII_GLYPHS];
 	int fallbacks[FONS_MAX_FALLBACKS];
 	int nfallbacks;
 };
@@ -431,6 +603,38 @@ struct FONSatlas
 };
 typedef struct FONSatlas FONSatlas;
 
+// Glyph outline cache slot, keyed by font and glyph index.
+struct FONSoutline
+{
+	FONSfont* font;		// NULL for an empty slot.
+	int glyph;
+	int jobs;			// Raster jobs reading the outline, the slot is not reused until they are collected.
+	FONSttOutline outline;
+};
+typedef struct FONSoutline FONSoutline;
+
+// Bitmap of a glyph rasterized on another thread, copied into its atlas rect once done.
+struct FONSrasterJob
+{
+	FONSttFontImpl font;	// Copy without the stash scratch allocator.
+	FONSfont* renderFont;
+	FONSoutline* cached;	// Outline from the cache, or NULL.
+	float outlineScale;		// Builds an outline for the cache at this scale when not zero.
+	FONSttOutline built;
+	int hasBuilt;
+	int glyph;
+	float scale;
+	int sdf;
+	int pad, blur;
+	int gx, gy, gw, gh;
+	int atlasGen;
+	unsigned char* bitmap;
+	FONScontext* stash;		// Counts the job out of pendingJobs once done.
+	atomic_int done;
+	struct FONSrasterJob* next;
+};
+typedef struct FONSrasterJob FONSrasterJob;
+
 struct FONScontext
 {
 	FONSparams params;
@@ -451,6 +655,15 @@ struct FONScontext
 	int nstates;
 	void (*handleError)(void* uptr, int error, int val);
 	void* errorUptr;
+	void (*rasterize)(void* uptr, void (*func)(void* arg), void* arg);
+	void* rasterizeUptr;
+	FONSrasterJob* jobs;
+	int pendingJobs;		// Jobs not done yet, guarded by jobMutex.
+	int hasJobSync;			// jobMutex and jobsDone are set up by the first fonsSetRasterizer().
+	mtx_t jobMutex;
+	cnd_t jobsDone;			// Signalled when pendingJobs drops to zero.
+	FONSoutline outlines[FONS_OUTLINE_CACHE_SIZE];
+	int atlasGen;	// Bumped when the atlas rects of pending jobs may have been handed out again.
 };
 
 #ifdef STB_TRUETYPE_IMPLEMENTATION
@@ -460,6 +673,10 @@ static void* fons__tmpalloc(size_t size, void* up)
 	unsigned char* ptr;
 	FONScontext* stash = (FONScontext*)up;
 
+	// Glyphs rasterized on another thread allocate from the heap.
+	if (stash == NULL)
+		return malloc(size);
+
 	// 16-byte align the returned pointer
 	size = (size + 0xf) & ~0xf;
 
@@ -475,9 +692,8 @@ static void* fons__tmpalloc(size_t size, void* up)
 
 static void fons__tmpfree(void* ptr, void* up)
 {
-	(void)ptr;
-	(void)up;
-	// empty
+	if (up == NULL)
+		free(ptr);
 }
 
 #endif // STB_TRUETYPE_IMPLEMENTATION
@@ -703,6 +919,52 @@ static int fons__atlasAddRect(FONSatlas* atlas, int rw, int rh, int* rx, int* ry
 	return 1;
 }
 
+static void fons__insertGlyph(FONSfont* font, int i)
+{
+	FONSglyph* glyph = &font->glyphs[i];
+	unsigned int mask = (unsigned int)font->ctable-1;
+	unsigned int h = fons__glyphHash(glyph->codepoint, glyph->size, glyph->blur) & mask;
+	while (font->table[h] != -1)
+		h = (h+1) & mask;
+	font->table[h] = i;
+}
+
+static int fons__findGlyph(FONSfont* font, unsigned int codepoint, short isize, short iblur)
+{
+	unsigned int mask = (unsigned int)font->ctable-1;
+	unsigned int h = fons__glyphHash(codepoint, isize, iblur) & mask;
+	int i;
+	while ((i = font->table[h]) != -1) {
+		FONSglyph* glyph = &font->glyphs[i];
+		if (glyph->codepoint == codepoint && glyph->size == isize && glyph->blur == iblur)
+			return i;
+		h = (h+1) & mask;
+	}
+	return -1;
+}
+
+// Reallocates the table with 'ctable' slots, a power of two, and reinserts the glyphs.
+static int fons__resizeGlyphTable(FONSfont* font, int ctable)
+{
+	int i;
+	int* table = (int*)malloc(sizeof(int) * ctable);
+	if (table == NULL) return 0;
+	memset(table, 0xff, sizeof(int) * ctable);
+	if (font->table) free(font->table);
+	font->table = table;
+	font->ctable = ctable;
+	for (i = 0; i < font->nglyphs; i++)
+		fons__insertGlyph(font, i);
+	return 1;
+}
+
+static void fons__clearGlyphs(FONSfont* font)
+{
+	font->nglyphs = 0;
+	memset(font->table, 0xff, sizeof(int) * font->ctable);
+	memset(font->ascii, 0xff, sizeof(font->ascii));
+}
+
 static void fons__addWhiteRect(FONScontext* stash, int w, int h)
 {
 	int x, y, gx, gy;
@@ -799,13 +1061,9 @@ int fonsAddFallbackFont(FONScontext* stash, int base, int fallback)
 
 void fonsResetFallbackFont(FONScontext* stash, int base)
 {
-	int i;
-
 	FONSfont* baseFont = stash->fonts[base];
 	baseFont->nfallbacks = 0;
-	baseFont->nglyphs = 0;
-	for (i = 0; i < FONS_HASH_LUT_SIZE; i++)
-		baseFont->lut[i] = -1;
+	fons__clearGlyphs(baseFont);
 }
 
 void fonsSetSize(FONScontext* stash, float size)
@@ -875,6 +1133,7 @@ static void fons__freeFont(FONSfont* font)
 {
 	if (font == NULL) return;
 	if (font->glyphs) free(font->glyphs);
+	if (font->table) free(font->table);
 	if (font->freeData && font->data) free(font->data);
 	free(font);
 }
@@ -897,6 +1156,9 @@ static int fons__allocFont(FONScontext* stash)
 	font->cglyphs = FONS_INIT_GLYPHS;
 	font->nglyphs = 0;
 
+	if (!fons__resizeGlyphTable(font, FONS_INIT_GLYPHS*2)) goto error;
+	memset(font->ascii, 0xff, sizeof(font->ascii));
+
 	stash->fonts[stash->nfonts++] = font;
 	return stash->nfonts-1;
 
@@ -936,7 +1198,7 @@ error:
 
 int fonsAddFontMem(FONScontext* stash, const char* name, unsigned char* data, int dataSize, int freeData, int fontIndex)
 {
-	int i, ascent, descent, fh, lineGap;
+	int ascent, descent, fh, lineGap;
 	FONSfont* font;
 
 	int idx = fons__allocFont(stash);
@@ -948,14 +1210,11 @@ int fonsAddFontMem(FONScontext* stash, const char* name, unsigned char* data, in
 	strncpy(font->name, name, sizeof(font->name));
 	font->name[sizeof(font->name)-1] = '\0';
 
-	// Init hash lookup.
-	for (i = 0; i < FONS_HASH_LUT_SIZE; ++i)
-		font->lut[i] = -1;
-
 	// Read in the font data.
 	font->dataSize = dataSize;
 	font->data = data;
 	font->freeData = (unsigned char)freeData;
+	font->checksum = fons__checksum(data, dataSize);
 
 	// Init font
 	stash->nscratch = 0;
@@ -991,6 +1250,9 @@ int fonsGetFontByName(FONScontext* s, const char* name)
 
 static FONSglyph* fons__allocGlyph(FONSfont* font)
 {
+	if ((font->nglyphs+1)*2 > font->ctable) {
+		if (!fons__resizeGlyphTable(font, font->ctable*2)) return NULL;
+	}
 	if (font->nglyphs+1 > font->cglyphs) {
 		font->cglyphs = font->cglyphs == 0 ? 8 : font->cglyphs * 2;
 		font->glyphs = (FONSglyph*)realloc(font->glyphs, sizeof(FONSglyph) * font->cglyphs);
@@ -1066,39 +1328,206 @@ static void fons__blur(FONScontext* stash, unsigned char* dst, int w, int h, int
 //	fons__blurcols(dst, w, h, dstStride, alpha);
 }
 
+static FONSoutline* fons__outlineSlot(FONScontext* stash, FONSfont* font, int glyph)
+{
+	unsigned int h = fons__hashint((unsigned int)(size_t)font ^ ((unsigned int)glyph * 2654435761u));
+	return &stash->outlines[h & (FONS_OUTLINE_CACHE_SIZE-1)];
+}
+
+// Returns the cached outline of the glyph, building it in place of the slot's previous one if needed.
+// Returns NULL if the slot is still read by raster jobs or the glyph has no outline.
+static FONSoutline* fons__getOutline(FONScontext* stash, FONSfont* font, int glyph)
+{
+	FONSoutline* slot = fons__outlineSlot(stash, font, glyph);
+
+	if (slot->font == font && slot->glyph == glyph)
+		return slot;
+	if (slot->jobs > 0)
+		return NULL;
+	if (slot->font != NULL) {
+		fons__tt_freeOutline(&slot->outline);
+		slot->font = NULL;
+	}
+	if (!fons__tt_buildOutline(&font->font, glyph, fons__tt_getPixelHeightScale(&font->font, (float)FONS_OUTLINE_SIZE), &slot->outline))
+		return NULL;
+	slot->font = font;
+	slot->glyph = glyph;
+	return slot;
+}
+
+static void fons__rasterizeJob(void* arg)
+{
+	FONSrasterJob* job = (FONSrasterJob*)arg;
+	FONScontext* stash = job->stash;	// The job may be freed as soon as done is set, the stash outlives it.
+	int pad = job->pad;
+
+	// The border stays empty.
+	job->bitmap = (unsigned char*)calloc(job->gw * job->gh, 1);
+	if (job->bitmap != NULL) {
+		unsigned char* dst = &job->bitmap[pad + pad * job->gw];
+		if (job->sdf) {
+			if (job->gw > pad*2 && job->gh > pad*2)
+				fons__tt_renderGlyphSDF(&job->font, dst, job->gw-pad*2, job->gh-pad*2, job->gw, job->scale, FONS_SDF_PADDING, job->glyph);
+		} else if (job->cached != NULL) {
+			fons__tt_renderOutline(&job->font, &job->cached->outline, dst, job->gw-pad*2, job->gh-pad*2, job->gw, job->scale, job->glyph);
+		} else if (job->outlineScale > 0.0f && fons__tt_buildOutline(&job->font, job->glyph, job->outlineScale, &job->built)) {
+			// Handed to the cache when the job is collected.
+			job->hasBuilt = 1;
+			fons__tt_renderOutline(&job->font, &job->built, dst, job->gw-pad*2, job->gh-pad*2, job->gw, job->scale, job->glyph);
+		} else {
+			fons__tt_renderGlyphBitmap(&job->font, dst, job->gw-pad*2, job->gh-pad*2, job->gw, job->scale, job->scale, job->glyph);
+		}
+		if (job->blur > 0)
+			fons__blur(NULL, job->bitmap, job->gw, job->gh, job->gw, job->blur);
+	}
+
+	mtx_lock(&stash->jobMutex);
+	atomic_store_explicit(&job->done, 1, memory_order_release);
+	if (--stash->pendingJobs == 0)
+		cnd_signal(&stash->jobsDone);
+	mtx_unlock(&stash->jobMutex);
+}
+
+// Hands the bitmap of the glyph to the rasterizer, the atlas rect stays empty until the job is collected.
+static int fons__queueGlyph(FONScontext* stash, FONSfont* font, int g, float scale, int sdf, int pad, int iblur, FONSglyph* glyph)
+{
+	FONSrasterJob* job = (FONSrasterJob*)malloc(sizeof(FONSrasterJob));
+	if (job == NULL) return 0;
+	memset(job, 0, sizeof(FONSrasterJob));
+
+	job->font = font->font;
+#ifndef FONS_USE_FREETYPE
+	job->font.font.userdata = NULL;
+#endif
+	job->renderFont = font;
+	if (!sdf) {
+		FONSoutline* slot = fons__outlineSlot(stash, font, g);
+		if (slot->font == font && slot->glyph == g) {
+			job->cached = slot;
+			slot->jobs++;
+		} else {
+			job->outlineScale = fons__tt_getPixelHeightScale(&font->font, (float)FONS_OUTLINE_SIZE);
+		}
+	}
+	job->glyph = g;
+	job->scale = scale;
+	job->sdf = sdf;
+	job->pad = pad;
+	job->blur = iblur;
+	job->gx = glyph->x0;
+	job->gy = glyph->y0;
+	job->gw = glyph->x1 - glyph->x0;
+	job->gh = glyph->y1 - glyph->y0;
+	job->atlasGen = stash->atlasGen;
+	job->stash = stash;
+	atomic_init(&job->done, 0);
+	job->next = stash->jobs;
+	stash->jobs = job;
+
+	// The texture behind a fresh rect is undefined, upload it empty.
+	stash->dirtyRect[0] = fons__mini(stash->dirtyRect[0], glyph->x0);
+	stash->dirtyRect[1] = fons__mini(stash->dirtyRect[1], glyph->y0);
+	stash->dirtyRect[2] = fons__maxi(stash->dirtyRect[2], glyph->x1);
+	stash->dirtyRect[3] = fons__maxi(stash->dirtyRect[3], glyph->y1);
+
+	mtx_lock(&stash->jobMutex);
+	stash->pendingJobs++;
+	mtx_unlock(&stash->jobMutex);
+	stash->rasterize(stash->rasterizeUptr, fons__rasterizeJob, job);
+	return 1;
+}
+
+// Copies finished bitmaps into the atlas, wait first sleeps until every job is done.
+static void fons__collectJobs(FONScontext* stash, int wait)
+{
+	FONSrasterJob** prev = &stash->jobs;
+	int y;
+
+	if (wait && stash->jobs != NULL) {
+		mtx_lock(&stash->jobMutex);
+		while (stash->pendingJobs > 0)
+			cnd_wait(&stash->jobsDone, &stash->jobMutex);
+		mtx_unlock(&stash->jobMutex);
+	}
+
+	while (*prev != NULL) {
+		FONSrasterJob* job = *prev;
+		if (!atomic_load_explicit(&job->done, memory_order_acquire)) {
+			prev = &job->next;
+			continue;
+		}
+		// A reset atlas may have given the rect to another glyph.
+		if (job->bitmap != NULL && job->atlasGen == stash->atlasGen) {
+			for (y = 0; y < job->gh; y++)
+				memcpy(&stash->texData[job->gx + (job->gy + y) * stash->params.width], &job->bitmap[y * job->gw], job->gw);
+			stash->dirtyRect[0] = fons__mini(stash->dirtyRect[0], job->gx);
+			stash->dirtyRect[1] = fons__mini(stash->dirtyRect[1], job->gy);
+			stash->dirtyRect[2] = fons__maxi(stash->dirtyRect[2], job->gx + job->gw);
+			stash->dirtyRect[3] = fons__maxi(stash->dirtyRect[3], job->gy + job->gh);
+		}
+		if (job->cached != NULL)
+			job->cached->jobs--;
+		if (job->hasBuilt) {
+			FONSoutline* slot = fons__outlineSlot(stash, job->renderFont, job->glyph);
+			if ((slot->font == job->renderFont && slot->glyph == job->glyph) || slot->jobs > 0) {
+				fons__tt_freeOutline(&job->built);
+			} else {
+				if (slot->font != NULL)
+					fons__tt_freeOutline(&slot->outline);
+				slot->font = job->renderFont;
+				slot->glyph = job->glyph;
+				slot->outline = job->built;
+			}
+		}
+		*prev = job->next;
+		free(job->bitmap);
+		free(job);
+	}
+}
+
 static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned int codepoint,
 								 short isize, short iblur, int bitmapOption)
 {
 	int i, g, advance, lsb, x0, y0, x1, y1, gw, gh, gx, gy, x, y;
 	float scale;
 	FONSglyph* glyph = NULL;
-	unsigned int h;
 	float size = isize/10.0f;
 	int pad, added;
 	unsigned char* bdst;
 	unsigned char* dst;
 	FONSfont* renderFont = font;
+	FONSoutline* outline;
+	int sdf = (stash->params.flags & FONS_SDF) != 0;
 
 	if (isize < 2) return NULL;
+	if (sdf) {
+		// One distance field serves every size, blur has no meaning for it.
+		isize = FONS_SDF_SIZE*10;
+		size = (float)FONS_SDF_SIZE;
+		iblur = 0;
+	}
 	if (iblur > 20) iblur = 20;
-	pad = iblur+2;
+	pad = sdf ? 1 : iblur+2;
 
 	// Reset allocator.
 	stash->nscratch = 0;
 
-	// Find code point and size.
-	h = fons__hashint(codepoint) & (FONS_HASH_LUT_SIZE-1);
-	i = font->lut[h];
-	while (i != -1) {
-		if (font->glyphs[i].codepoint == codepoint && font->glyphs[i].size == isize && font->glyphs[i].blur == iblur) {
-			glyph = &font->glyphs[i];
-			if (bitmapOption == FONS_GLYPH_BITMAP_OPTIONAL || (glyph->x0 >= 0 && glyph->y0 >= 0)) {
-			  return glyph;
-			}
-			// At this point, glyph exists but the bitmap data is not yet created.
-			break;
+	// Find code point and size, printable ASCII at the last used size skips the hash table.
+	if (codepoint - 0x20u < FONS_ASCII_GLYPHS) {
+		i = font->ascii[codepoint - 0x20];
+		if (i == -1 || font->glyphs[i].size != isize || font->glyphs[i].blur != iblur) {
+			i = fons__findGlyph(font, codepoint, isize, iblur);
+			if (i != -1) font->ascii[codepoint - 0x20] = i;
 		}
-		i = font->glyphs[i].next;
+	} else {
+		i = fons__findGlyph(font, codepoint, isize, iblur);
+	}
+	if (i != -1) {
+		glyph = &font->glyphs[i];
+		if (bitmapOption == FONS_GLYPH_BITMAP_OPTIONAL || (glyph->x0 >= 0 && glyph->y0 >= 0)) {
+		  return glyph;
+		}
+		// At this point, glyph exists but the bitmap data is not yet created.
 	}
 
 	// Create a new glyph or rasterize bitmap data for a cached glyph.
@@ -1119,6 +1548,12 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 	}
 	scale = fons__tt_getPixelHeightScale(&renderFont->font, size);
 	fons__tt_buildGlyphBitmap(&renderFont->font, g, size, scale, &advance, &lsb, &x0, &y0, &x1, &y1);
+	if (sdf && x1 > x0 && y1 > y0) {
+		x0 -= FONS_SDF_PADDING;
+		y0 -= FONS_SDF_PADDING;
+		x1 += FONS_SDF_PADDING;
+		y1 += FONS_SDF_PADDING;
+	}
 	gw = x1-x0 + pad*2;
 	gh = y1-y0 + pad*2;
 
@@ -1141,14 +1576,15 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 	// Init glyph.
 	if (glyph == NULL) {
 		glyph = fons__allocGlyph(font);
+		if (glyph == NULL) return NULL;
 		glyph->codepoint = codepoint;
 		glyph->size = isize;
 		glyph->blur = iblur;
-		glyph->next = 0;
 
 		// Insert char to hash lookup.
-		glyph->next = font->lut[h];
-		font->lut[h] = font->nglyphs-1;
+		fons__insertGlyph(font, font->nglyphs-1);
+		if (codepoint - 0x20u < FONS_ASCII_GLYPHS)
+			font->ascii[codepoint - 0x20] = font->nglyphs-1;
 	}
 	glyph->index = g;
 	glyph->x0 = (short)gx;
@@ -1163,9 +1599,20 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 		return glyph;
 	}
 
-	// Rasterize
+	if (stash->rasterize != NULL && fons__queueGlyph(stash, renderFont, g, scale, sdf, pad, iblur, glyph))
+		return glyph;
+
+	// Rasterize, the outline of a glyph seen at another size or blur is not decoded again.
+	// A distance field is made once per glyph, it does not use the cache.
 	dst = &stash->texData[(glyph->x0+pad) + (glyph->y0+pad) * stash->params.width];
-	fons__tt_renderGlyphBitmap(&renderFont->font, dst, gw-pad*2,gh-pad*2, stash->params.width, scale, scale, g);
+	if (sdf) {
+		if (gw > pad*2 && gh > pad*2)
+			fons__tt_renderGlyphSDF(&renderFont->font, dst, gw-pad*2,gh-pad*2, stash->params.width, scale, FONS_SDF_PADDING, g);
+	} else if ((outline = fons__getOutline(stash, renderFont, g)) != NULL) {
+		fons__tt_renderOutline(&renderFont->font, &outline->outline, dst, gw-pad*2,gh-pad*2, stash->params.width, scale, g);
+	} else {
+		fons__tt_renderGlyphBitmap(&renderFont->font, dst, gw-pad*2,gh-pad*2, stash->params.width, scale, scale, g);
+	}
 
 	// Make sure there is one pixel empty border.
 	dst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
@@ -1204,10 +1651,12 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 }
 
 static void fons__getQuad(FONScontext* stash, FONSfont* font,
-						   int prevGlyphIndex, FONSglyph* glyph,
+						   int prevGlyphIndex, FONSglyph* glyph, short isize,
 						   float scale, float spacing, float* x, float* y, FONSquad* q)
 {
 	float rx,ry,xoff,yoff,x0,y0,x1,y1;
+	// Distance field glyphs are stored at one size and stretched to the requested one.
+	float ratio = (stash->params.flags & FONS_SDF) ? (float)isize / glyph->size : 1.0f;
 
 	if (prevGlyphIndex != -1) {
 		float adv = fons__tt_getGlyphKernAdvance(&font->font, prevGlyphIndex, glyph->index) * scale;
@@ -1217,8 +1666,8 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 	// Each glyph has 2px border to allow good interpolation,
 	// one pixel to prevent leaking, and one to allow good interpolation for rendering.
 	// Inset the texture region by one pixel for correct interpolation.
-	xoff = (short)(glyph->xoff+1);
-	yoff = (short)(glyph->yoff+1);
+	xoff = (short)(glyph->xoff+1) * ratio;
+	yoff = (short)(glyph->yoff+1) * ratio;
 	x0 = (float)(glyph->x0+1);
 	y0 = (float)(glyph->y0+1);
 	x1 = (float)(glyph->x1-1);
@@ -1230,8 +1679,8 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 
 		q->x0 = rx;
 		q->y0 = ry;
-		q->x1 = rx + x1 - x0;
-		q->y1 = ry + y1 - y0;
+		q->x1 = rx + (x1 - x0) * ratio;
+		q->y1 = ry + (y1 - y0) * ratio;
 
 		q->s0 = x0 * stash->itw;
 		q->t0 = y0 * stash->ith;
@@ -1243,8 +1692,8 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 
 		q->x0 = rx;
 		q->y0 = ry;
-		q->x1 = rx + x1 - x0;
-		q->y1 = ry - y1 + y0;
+		q->x1 = rx + (x1 - x0) * ratio;
+		q->y1 = ry - (y1 - y0) * ratio;
 
 		q->s0 = x0 * stash->itw;
 		q->t0 = y0 * stash->ith;
@@ -1252,7 +1701,7 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 		q->t1 = y1 * stash->ith;
 	}
 
-	*x += (int)(glyph->xadv / 10.0f + 0.5f);
+	*x += (int)(glyph->xadv / 10.0f * ratio + 0.5f);
 }
 
 static void fons__flush(FONScontext* stash)
@@ -1356,7 +1805,7 @@ float fonsDrawText(FONScontext* stash,
 			continue;
 		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur, FONS_GLYPH_BITMAP_REQUIRED);
 		if (glyph != NULL) {
-			fons__getQuad(stash, font, prevGlyphIndex, glyph, scale, state->spacing, &x, &y, &q);
+			fons__getQuad(stash, font, prevGlyphIndex, glyph, isize, scale, state->spacing, &x, &y, &q);
 
 			if (stash->nverts+6 > FONS_VERTEX_COUNT)
 				fons__flush(stash);
@@ -1441,7 +1890,7 @@ int fonsTextIterNext(FONScontext* stash, FONStextIter* iter, FONSquad* quad)
 		glyph = fons__getGlyph(stash, iter->font, iter->codepoint, iter->isize, iter->iblur, iter->bitmapOption);
 		// If the iterator was initialized with FONS_GLYPH_BITMAP_OPTIONAL, then the UV coordinates of the quad will be invalid.
 		if (glyph != NULL)
-			fons__getQuad(stash, iter->font, iter->prevGlyphIndex, glyph, iter->scale, iter->spacing, &iter->nextx, &iter->nexty, quad);
+			fons__getQuad(stash, iter->font, iter->prevGlyphIndex, glyph, iter->isize, iter->scale, iter->spacing, &iter->nextx, &iter->nexty, quad);
 		iter->prevGlyphIndex = glyph != NULL ? glyph->index : -1;
 		break;
 	}
@@ -1538,7 +1987,7 @@ float fonsTextBounds(FONScontext* stash,
 			continue;
 		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur, FONS_GLYPH_BITMAP_OPTIONAL);
 		if (glyph != NULL) {
-			fons__getQuad(stash, font, prevGlyphIndex, glyph, scale, state->spacing, &x, &y, &q);
+			fons__getQuad(stash, font, prevGlyphIndex, glyph, isize, scale, state->spacing, &x, &y, &q);
 			if (q.x0 < minx) minx = q.x0;
 			if (q.x1 > maxx) maxx = q.x1;
 			if (stash->params.flags & FONS_ZERO_TOPLEFT) {
@@ -1630,6 +2079,8 @@ const unsigned char* fonsGetTextureData(FONScontext* stash, int* width, int* hei
 
 int fonsValidateTexture(FONScontext* stash, int* dirty)
 {
+	if (stash->jobs != NULL)
+		fons__collectJobs(stash, 0);
 	if (stash->dirtyRect[0] < stash->dirtyRect[2] && stash->dirtyRect[1] < stash->dirtyRect[3]) {
 		dirty[0] = stash->dirtyRect[0];
 		dirty[1] = stash->dirtyRect[1];
@@ -1650,6 +2101,19 @@ void fonsDeleteInternal(FONScontext* stash)
 	int i;
 	if (stash == NULL) return;
 
+	// Jobs read the font data.
+	fons__collectJobs(stash, 1);
+
+	for (i = 0; i < FONS_OUTLINE_CACHE_SIZE; ++i) {
+		if (stash->outlines[i].font != NULL)
+			fons__tt_freeOutline(&stash->outlines[i].outline);
+	}
+
+	if (stash->hasJobSync) {
+		cnd_destroy(&stash->jobsDone);
+		mtx_destroy(&stash->jobMutex);
+	}
+
 	if (stash->params.renderDelete)
 		stash->params.renderDelete(stash->params.userPtr);
 
@@ -1671,6 +2135,28 @@ void fonsSetErrorCallback(FONScontext* stash, void (*callback)(void* uptr, int e
 	stash->errorUptr = uptr;
 }
 
+void fonsSetRasterizer(FONScontext* stash, void (*run)(void* uptr, void (*func)(void* arg), void* arg), void* uptr)
+{
+	if (stash == NULL) return;
+#ifdef FONS_USE_FREETYPE
+	// FreeType faces cannot be shared between threads.
+	run = NULL;
+#endif
+	if (run != NULL && !stash->hasJobSync) {
+		// Without them the glyphs keep being rasterized on the calling thread.
+		if (mtx_init(&stash->jobMutex, mtx_plain) == thrd_success) {
+			if (cnd_init(&stash->jobsDone) == thrd_success)
+				stash->hasJobSync = 1;
+			else
+				mtx_destroy(&stash->jobMutex);
+		}
+		if (!stash->hasJobSync)
+			run = NULL;
+	}
+	stash->rasterize = run;
+	stash->rasterizeUptr = run != NULL ? uptr : NULL;
+}
+
 void fonsGetAtlasSize(FONScontext* stash, int* width, int* height)
 {
 	if (stash == NULL) return;
@@ -1736,7 +2222,7 @@ int fonsExpandAtlas(FONScontext* stash, int width, int height)
 
 int fonsResetAtlas(FONScontext* stash, int width, int height)
 {
-	int i, j;
+	int i;
 	if (stash == NULL) return 0;
 
 	// Flush pending glyphs.
@@ -1750,6 +2236,7 @@ int fonsResetAtlas(FONScontext* stash, int width, int height)
 
 	// Reset atlas
 	fons__atlasReset(stash->atlas, width, height);
+	stash->atlasGen++;
 
 	// Clear texture data.
 	stash->texData = (unsigned char*)realloc(stash->texData, width * height);
@@ -1763,12 +2250,8 @@ int fonsResetAtlas(FONScontext* stash, int width, int height)
 	stash->dirtyRect[3] = 0;
 
 	// Reset cached glyphs
-	for (i = 0; i < stash->nfonts; i++) {
-		FONSfont* font = stash->fonts[i];
-		font->nglyphs = 0;
-		for (j = 0; j < FONS_HASH_LUT_SIZE; j++)
-			font->lut[j] = -1;
-	}
+	for (i = 0; i < stash->nfonts; i++)
+		fons__clearGlyphs(stash->fonts[i]);
 
 	stash->params.width = width;
 	stash->params.height = height;
@@ -1781,5 +2264,191 @@ int fonsResetAtlas(FONScontext* stash, int width, int height)
 	return 1;
 }
 
+#define FONS_ATLAS_MAGIC "FONA"
+#define FONS_ATLAS_VERSION 3
+
+static int fons__writeAtlasInts(FILE* fp, const int* v, int n)
+{
+	return fwrite(v, sizeof(int), n, fp) == (size_t)n;
+}
+
+static int fons__readAtlasInts(FILE* fp, int* v, int n)
+{
+	return fread(v, sizeof(int), n, fp) == (size_t)n;
+}
+
+// Fallbacks decide which font a glyph index belongs to, so they are part of the key.
+static int fons__fontMatches(FONScontext* stash, FONSfont* font, unsigned int checksum, const int* fallbacks, int nfallbacks)
+{
+	int i;
+	if (font->checksum != checksum || font->nfallbacks != nfallbacks)
+		return 0;
+	for (i = 0; i < nfallbacks; i++) {
+		if (stash->fonts[font->fallbacks[i]]->checksum != (unsigned int)fallbacks[i])
+			return 0;
+	}
+	return 1;
+}
+
+int fonsSaveAtlas(FONScontext* stash, const char* path)
+{
+	FILE* fp;
+	int i, j, ok, v[7];
+
+	if (stash == NULL) return 0;
+	// Glyphs still being rasterized would be saved empty.
+	fons__collectJobs(stash, 1);
+	fp = fopen(path, "wb");
+	if (fp == NULL) return 0;
+
+	v[0] = FONS_ATLAS_VERSION;
+	v[1] = stash->params.width;
+	v[2] = stash->params.height;
+	v[3] = stash->atlas->nnodes;
+	v[4] = stash->nfonts;
+	// Bitmaps and distance fields do not mix.
+	v[5] = stash->params.flags & FONS_SDF;
+	v[6] = FONS_SDF_SIZE;
+	ok = fwrite(FONS_ATLAS_MAGIC, 1, 4, fp) == 4 && fons__writeAtlasInts(fp, v, 7);
+	ok = ok && fwrite(stash->atlas->nodes, sizeof(FONSatlasNode), stash->atlas->nnodes, fp) == (size_t)stash->atlas->nnodes;
+	ok = ok && fwrite(stash->texData, 1, stash->params.width * stash->params.height, fp) == (size_t)(stash->params.width * stash->params.height);
+
+	for (i = 0; i < stash->nfonts && ok; i++) {
+		FONSfont* font = stash->fonts[i];
+		v[0] = (int)font->checksum;
+		v[1] = font->nfallbacks;
+		ok = fons__writeAtlasInts(fp, v, 2);
+		for (j = 0; j < font->nfallbacks && ok; j++) {
+			v[0] = (int)stash->fonts[font->fallbacks[j]]->checksum;
+			ok = fons__writeAtlasInts(fp, v, 1);
+		}
+		ok = ok && fons__writeAtlasInts(fp, &font->nglyphs, 1);
+		ok = ok && fwrite(font->glyphs, sizeof(FONSglyph), font->nglyphs, fp) == (size_t)font->nglyphs;
+	}
+
+	if (fclose(fp) != 0) ok = 0;
+	return ok;
+}
+
+int fonsLoadAtlas(FONScontext* stash, const char* path)
+{
+	FILE* fp;
+	char magic[4];
+	int i, j, k, n, v[7], width, height, nnodes, nfonts, maxy = 0, ok = 0;
+	int fallbacks[FONS_MAX_FALLBACKS];
+	FONSatlasNode* nodes = NULL;
+	unsigned char* texData = NULL;
+	FONSglyph** glyphs = NULL;
+	int* nglyphs = NULL;
+
+	if (stash == NULL) return 0;
+	fp = fopen(path, "rb");
+	if (fp == NULL) return 0;
+
+	if (fread(magic, 1, 4, fp) != 4 || memcmp(magic, FONS_ATLAS_MAGIC, 4) != 0 || !fons__readAtlasInts(fp, v, 7))
+		goto error;
+	width = v[1];
+	height = v[2];
+	nnodes = v[3];
+	nfonts = v[4];
+	if (v[0] != FONS_ATLAS_VERSION || v[5] != (stash->params.flags & FONS_SDF) || v[6] != FONS_SDF_SIZE || width <= 0 || height <= 0 || width > 0x7fff || height > 0x7fff ||
+		nnodes <= 0 || nnodes > width || nfonts < 0)
+		goto error;
+
+	nodes = (FONSatlasNode*)malloc(sizeof(FONSatlasNode) * nnodes);
+	texData = (unsigned char*)malloc(width * height);
+	glyphs = (FONSglyph**)calloc(stash->nfonts + 1, sizeof(FONSglyph*));
+	nglyphs = (int*)calloc(stash->nfonts + 1, sizeof(int));
+	if (nodes == NULL || texData == NULL || glyphs == NULL || nglyphs == NULL) goto error;
+	if (fread(nodes, sizeof(FONSatlasNode), nnodes, fp) != (size_t)nnodes) goto error;
+	if (fread(texData, 1, width * height, fp) != (size_t)(width * height)) goto error;
+
+	// Rects are packed against the skyline, a node outside the atlas would place glyphs outside it.
+	for (i = 0; i < nnodes; i++) {
+		if (nodes[i].x < 0 || nodes[i].width < 0 || nodes[i].x + nodes[i].width > width || nodes[i].y < 0 || nodes[i].y > height)
+			goto error;
+	}
+
+	// Read all fonts before touching the stash, a truncated cache leaves it as it was.
+	for (i = 0; i < nfonts; i++) {
+		FONSglyph* loaded = NULL;
+		if (!fons__readAtlasInts(fp, v, 2) || v[1] < 0 || v[1] > FONS_MAX_FALLBACKS) goto error;
+		if (!fons__readAtlasInts(fp, fallbacks, v[1]) || !fons__readAtlasInts(fp, &n, 1) || n < 0) goto error;
+		for (j = 0; j < stash->nfonts; j++) {
+			if (glyphs[j] == NULL && fons__fontMatches(stash, stash->fonts[j], (unsigned int)v[0], fallbacks, v[1]))
+				break;
+		}
+		if (n > 0) {
+			loaded = (FONSglyph*)malloc(sizeof(FONSglyph) * n);
+			if (loaded == NULL) goto error;
+			if (fread(loaded, sizeof(FONSglyph), n, fp) != (size_t)n) {
+				free(loaded);
+				goto error;
+			}
+			for (k = 0; k < n; k++) {
+				if (loaded[k].x0 >= 0 && (loaded[k].x1 > width || loaded[k].y1 > height || loaded[k].y0 < 0)) {
+					free(loaded);
+					goto error;
+				}
+			}
+		}
+		if (j < stash->nfonts && n > 0) {
+			glyphs[j] = loaded;
+			nglyphs[j] = n;
+		} else {
+			// Font is not loaded this run, its glyphs just keep their atlas space.
+			free(loaded);
+		}
+	}
+
+	if (!fonsResetAtlas(stash, width, height)) goto error;
+
+	if (nnodes > stash->atlas->cnodes) {
+		FONSatlasNode* grown = (FONSatlasNode*)realloc(stash->atlas->nodes, sizeof(FONSatlasNode) * nnodes);
+		if (grown == NULL) goto error;
+		stash->atlas->nodes = grown;
+		stash->atlas->cnodes = nnodes;
+	}
+	memcpy(stash->atlas->nodes, nodes, sizeof(FONSatlasNode) * nnodes);
+	stash->atlas->nnodes = nnodes;
+	memcpy(stash->texData, texData, width * height);
+
+	for (i = 0; i < stash->nfonts; i++) {
+		FONSfont* font = stash->fonts[i];
+		if (glyphs[i] == NULL) continue;
+		free(font->glyphs);
+		font->glyphs = glyphs[i];
+		font->nglyphs = font->cglyphs = nglyphs[i];
+		glyphs[i] = NULL;
+		// Rebuild the hash lookup, the glyphs are dropped if it cannot grow.
+		for (n = font->ctable; font->nglyphs*2 > n; n *= 2)
+			;
+		memset(font->ascii, 0xff, sizeof(font->ascii));
+		if (!fons__resizeGlyphTable(font, n))
+			fons__clearGlyphs(font);
+	}
+
+	// Upload everything under the skyline.
+	for (i = 0; i < nnodes; i++)
+		maxy = fons__maxi(maxy, nodes[i].y);
+	stash->dirtyRect[0] = 0;
+	stash->dirtyRect[1] = 0;
+	stash->dirtyRect[2] = width;
+	stash->dirtyRect[3] = maxy;
+	ok = 1;
+
+error:
+	if (glyphs != NULL) {
+		for (i = 0; i < stash->nfonts; i++)
+			free(glyphs[i]);
+	}
+	free(glyphs);
+	free(nglyphs);
+	free(texData);
+	free(nodes);
+	fclose(fp);
+	return ok;
+}
+
 
 #endif
@@ -26,6 +26,89 @@
 #include "fontstash.h"
 
 #ifndef NVG_NO_STB
+#ifdef _MSC_VER
+#define NVG_THREAD_LOCAL __declspec(thread)
+#else
+#define NVG_THREAD_LOCAL _Thread_local
+#endif
+
+// Decoder memory, from the buffers of the JPEG components to the output image, comes from an arena of the
+// decoding thread while nvgCreateImageMem() runs. It is dropped as a whole once the texture is created,
+// instead of a handful of large short-lived heap blocks per image. Blocks that do not fit use the heap.
+#define NVG_IMAGE_ARENA_SIZE (512*1024)
+
+struct NVGimageArena {
+	unsigned char* base;
+	size_t used;
+	int active;
+};
+typedef struct NVGimageArena NVGimageArena;
+
+static NVG_THREAD_LOCAL NVGimageArena nvg__imageArena;
+
+static int nvg__inImageArena(void* ptr)
+{
+	NVGimageArena* arena = &nvg__imageArena;
+	return arena->base != NULL && (size_t)((unsigned char*)ptr - arena->base) < NVG_IMAGE_ARENA_SIZE;
+}
+
+static void* nvg__imageMalloc(size_t size)
+{
+	NVGimageArena* arena = &nvg__imageArena;
+	void* ptr;
+	// SIMD loads of the decoder want 16 byte alignment.
+	size = (size + 15) & ~(size_t)15;
+	if (!arena->active || size > NVG_IMAGE_ARENA_SIZE - arena->used)
+		return malloc(size);
+	ptr = arena->base + arena->used;
+	arena->used += size;
+	return ptr;
+}
+
+static void nvg__imageFree(void* ptr)
+{
+	// Arena blocks go away with the decode.
+	if (ptr != NULL && !nvg__inImageArena(ptr))
+		free(ptr);
+}
+
+// Only the PNG and GIF decoders grow their buffers.
+#if !defined(STBI_ONLY_JPEG) || defined(STBI_ONLY_PNG) || defined(STBI_ONLY_GIF)
+#define NVG_IMAGE_REALLOC
+static void* nvg__imageRealloc(void* ptr, size_t oldSize, size_t newSize)
+{
+	void* out;
+	if (ptr != NULL && !nvg__inImageArena(ptr))
+		return realloc(ptr, newSize);
+	out = nvg__imageMalloc(newSize);
+	if (out != NULL && ptr != NULL)
+		memcpy(out, ptr, oldSize < newSize ? oldSize : newSize);
+	return out;
+}
+#endif
+
+static void nvg__beginImageArena(void)
+{
+	NVGimageArena* arena = &nvg__imageArena;
+	if (arena->base == NULL)
+		arena->base = (unsigned char*)malloc(NVG_IMAGE_ARENA_SIZE);
+	arena->used = 0;
+	arena->active = arena->base != NULL;
+}
+
+static void nvg__endImageArena(void)
+{
+	nvg__imageArena.used = 0;
+	nvg__imageArena.active = 0;
+}
+
+#define STBI_MALLOC(size)	nvg__imageMalloc(size)
+#ifdef NVG_IMAGE_REALLOC
+#define STBI_REALLOC_SIZED(ptr, oldSize, newSize)	nvg__imageRealloc(ptr, oldSize, newSize)
+#else
+#define STBI_REALLOC_SIZED(ptr, oldSize, newSize)	realloc(ptr, newSize)
+#endif
+#define STBI_FREE(ptr)	nvg__imageFree(ptr)
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #endif 
@@ -46,6 +129,11 @@
 #define NVG_INIT_PATHS_SIZE 16
 #define NVG_INIT_VERTS_SIZE 256
 #define NVG_MAX_STATES 32
+#define NVG_GEOMCACHE_SIZE 64				// Must be power of two.
+#define NVG_GEOMCACHE_MAX_COMMANDS 256		// Larger paths are always tessellated.
+#define NVG_TRIANGULATE_MAX_VERTS 64		// Larger concave fills are always stenciled.
+#define NVG_TEXTCACHE_SIZE 64
+#define NVG_TEXTCACHE_MAX_CHARS 128			// Longer strings are always laid out.
 
 #define NVG_KAPPA90 0.5522847493f	// Length proportional to radius of a cubic bezier handle for 90deg arcs.
 
@@ -112,6 +200,85 @@ struct NVGpathCache {
 };
 typedef struct NVGpathCache NVGpathCache;
 
+// What tessellating a path reads and writes. Taken from the context for each path, so workers
+// tessellating deferred paths need no state of their own.
+struct NVGtessContext {
+	const NVGparams* params;	// Only triangulateFills is read.
+	float tessTol;
+	float distTol;
+	float fringeWidth;
+	NVGpathCache* cache;
+	const float* commands;
+	int ncommands;
+};
+typedef struct NVGtessContext NVGtessContext;
+
+// Tessellated fill of a path, stored relative to the path's first point.
+struct NVGgeomCacheEntry {
+	unsigned int hash;
+	float fringe;
+	float fringeWidth;
+	float* commands;
+	int ncommands;
+	int ccommands;
+	NVGpath* paths;
+	int npaths;
+	int cpaths;
+	NVGvertex* verts;
+	int nverts;
+	int cverts;
+	float bounds[4];
+};
+typedef struct NVGgeomCacheEntry NVGgeomCacheEntry;
+
+enum NVGjobType {
+	NVG_JOB_FILL = 0,
+	NVG_JOB_STROKE = 1,
+};
+
+// A recorded fill or stroke waiting for deferred tessellation.
+struct NVGjob {
+	int type;
+	float* commands;
+	int ncommands;
+	int ccommands;
+	NVGpathCache* cache;
+	NVGpaint paint;
+	NVGcompositeOperationState compositeOperation;
+	NVGscissor scissor;
+	float fringe;
+	float strokeWidth;
+	int lineCap;
+	int lineJoin;
+	float miterLimit;
+	int tessellate;		// Cleared for fills expected to come from the geometry cache.
+};
+typedef struct NVGjob NVGjob;
+
+// Laid out text, stored relative to the pixel its origin falls in.
+// Glyphs are snapped to whole pixels, so a run only matches the same subpixel offset.
+struct NVGtextRun {
+	unsigned int hash;
+	char string[NVG_TEXTCACHE_MAX_CHARS];
+	int len;
+	int fontId;
+	int align;
+	float size;
+	float spacing;
+	float blur;
+	float fracx, fracy;
+	unsigned int lastUsed;	// Zero for a free slot.
+	int hasBounds;
+	float width;
+	float bounds[4];
+	int atlasGen;		// Quads are only valid for the atlas they were laid out in.
+	float nextx;
+	FONSquad* quads;
+	int nquads;			// -1 if the quads have not been laid out.
+	int cquads;
+};
+typedef struct NVGtextRun NVGtextRun;
+
 struct NVGcontext {
 	NVGparams params;
 	float* commands;
@@ -121,6 +288,11 @@ struct NVGcontext {
 	NVGstate states[NVG_MAX_STATES];
 	int nstates;
 	NVGpathCache* cache;
+	NVGgeomCacheEntry geomCache[NVG_GEOMCACHE_SIZE];
+	NVGworkers workers;
+	NVGjob* jobs;
+	int njobs;
+	int cjobs;
 	float tessTol;
 	float distTol;
 	float fringeWidth;
@@ -128,6 +300,9 @@ struct NVGcontext {
 	struct FONScontext* fs;
 	int fontImages[NVG_MAX_FONTIMAGES];
 	int fontImageIdx;
+	NVGtextRun textRuns[NVG_TEXTCACHE_SIZE];
+	unsigned int textRunTick;
+	int atlasGen;
 	int drawCallCount;
 	int fillTriCount;
 	int strokeTriCount;
@@ -208,6 +383,19 @@ static void nvg__setDevicePixelRatio(NVGcontext* ctx, float ratio)
 	ctx->devicePxRatio = ratio;
 }
 
+static NVGtessContext nvg__tessContext(NVGcontext* ctx, NVGpathCache* cache, const float* commands, int ncommands)
+{
+	NVGtessContext tess;
+	tess.params = &ctx->params;
+	tess.tessTol = ctx->tessTol;
+	tess.distTol = ctx->distTol;
+	tess.fringeWidth = ctx->fringeWidth;
+	tess.cache = cache;
+	tess.commands = commands;
+	tess.ncommands = ncommands;
+	return tess;
+}
+
 static NVGcompositeOperationState nvg__compositeOperationState(int op)
 {
 	int sfactor, dfactor;
@@ -286,6 +474,14 @@ static NVGstate* nvg__getState(NVGcontext* ctx)
 	return &ctx->states[ctx->nstates-1];
 }
 
+static void nvg__flushJobs(NVGcontext* ctx);
+static void nvg__deleteJobs(NVGcontext* ctx);
+
+static int nvg__fontImageFlags(NVGcontext* ctx)
+{
+	return ctx->params.sdfText ? NVG_IMAGE_SDF : 0;
+}
+
 NVGcontext* nvgCreateInternal(NVGparams* params)
 {
 	FONSparams fontParams;
@@ -318,6 +514,8 @@ NVGcontext* nvgCreateInternal(NVGparams* params)
 	fontParams.width = NVG_INIT_FONTIMAGE_SIZE;
 	fontParams.height = NVG_INIT_FONTIMAGE_SIZE;
 	fontParams.flags = FONS_ZERO_TOPLEFT;
+	if (ctx->params.sdfText)
+		fontParams.flags |= FONS_SDF;
 	fontParams.renderCreate = NULL;
 	fontParams.renderUpdate = NULL;
 	fontParams.renderDraw = NULL;
@@ -327,7 +525,7 @@ NVGcontext* nvgCreateInternal(NVGparams* params)
 	if (ctx->fs == NULL) goto error;
 
 	// Create font texture
-	ctx->fontImages[0] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, fontParams.width, fontParams.height, 0, NULL);
+	ctx->fontImages[0] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, fontParams.width, fontParams.height, nvg__fontImageFlags(ctx), NULL);
 	if (ctx->fontImages[0] == 0) goto error;
 	ctx->fontImageIdx = 0;
 
@@ -350,6 +548,19 @@ void nvgDeleteInternal(NVGcontext* ctx)
 	if (ctx->commands != NULL) free(ctx->commands);
 	if (ctx->cache != NULL) nvg__deletePathCache(ctx->cache);
 
+	nvg__deleteJobs(ctx);
+
+	for (i = 0; i < NVG_GEOMCACHE_SIZE; i++) {
+		NVGgeomCacheEntry* entry = &ctx->geomCache[i];
+		if (entry->commands != NULL) free(entry->commands);
+		if (entry->paths != NULL) free(entry->paths);
+		if (entry->verts != NULL) free(entry->verts);
+	}
+
+	for (i = 0; i < NVG_TEXTCACHE_SIZE; i++) {
+		if (ctx->textRuns[i].quads != NULL) free(ctx->textRuns[i].quads);
+	}
+
 	if (ctx->fs)
 		fonsDeleteInternal(ctx->fs);
 
@@ -388,11 +599,13 @@ void nvgBeginFrame(NVGcontext* ctx, float windowWidth, float windowHeight, float
 
 void nvgCancelFrame(NVGcontext* ctx)
 {
+	ctx->njobs = 0;
 	ctx->params.renderCancel(ctx->params.userPtr);
 }
 
 void nvgEndFrame(NVGcontext* ctx)
 {
+	nvg__flushJobs(ctx);
 	ctx->params.renderFlush(ctx->params.userPtr);
 	if (ctx->fontImageIdx != 0) {
 		int fontImage = ctx->fontImages[ctx->fontImageIdx];
@@ -808,18 +1021,54 @@ int nvgCreateImage(NVGcontext* ctx, const char* filename, int imageFlags)
 	return image;
 }
 
+struct NVGimageDecode {
+	NVGcontext* ctx;
+	int mapped;
+};
+typedef struct NVGimageDecode NVGimageDecode;
+
+// Hands stb_image the back-end's upload memory, or heap memory for images the back-end does not map.
+static unsigned char* nvg__allocImage(void* uptr, int w, int h, int comp)
+{
+	NVGimageDecode* decode = (NVGimageDecode*)uptr;
+	NVGparams* params = &decode->ctx->params;
+	unsigned char* pixels = params->renderMapTexture(params->userPtr, NVG_TEXTURE_RGBA, w, h);
+	decode->mapped = pixels != NULL;
+	return pixels != NULL ? pixels : (unsigned char*)nvg__imageMalloc((size_t)w * h * comp);
+}
+
 int nvgCreateImageMem(NVGcontext* ctx, int imageFlags, const unsigned char* data, int ndata)
 {
-	int w, h, n, image;
-	unsigned char* img = stbi_load_from_memory(data, ndata, &w, &h, &n, 4);
-	if (img == NULL) {
-//		printf("Failed to load %s - %s\n", filename, stbi_failure_reason());
-		return 0;
+	int w, h, n, image = 0;
+	unsigned char* img;
+
+	nvg__beginImageArena();
+	if (ctx->params.renderMapTexture != NULL) {
+		// Decoded rows land where the back-end uploads them from.
+		NVGimageDecode decode = { ctx, 0 };
+		img = stbi_load_from_memory_into(data, ndata, &w, &h, &n, 4, nvg__allocImage, &decode);
+		if (img != NULL) {
+			image = nvgCreateImageRGBA(ctx, w, h, imageFlags, img);
+			if (!decode.mapped)
+				nvg__imageFree(img);
+		}
+	} else {
+		img = stbi_load_from_memory(data, ndata, &w, &h, &n, 4);
+		if (img != NULL) {
+			image = nvgCreateImageRGBA(ctx, w, h, imageFlags, img);
+			stbi_image_free(img);
+		}
+//		else printf("Failed to load %s - %s\n", filename, stbi_failure_reason());
 	}
-	image = nvgCreateImageRGBA(ctx, w, h, imageFlags, img);
-	stbi_image_free(img);
+	nvg__endImageArena();
 	return image;
 }
+
+void nvgFreeImageArena(void)
+{
+	free(nvg__imageArena.base);
+	memset(&nvg__imageArena, 0, sizeof(nvg__imageArena));
+}
 #endif
 
 int nvgCreateImageRGBA(NVGcontext* ctx, int w, int h, int imageFlags, const unsigned char* data)
@@ -1135,82 +1384,82 @@ static void nvg__clearPathCache(NVGcontext* ctx)
 	ctx->cache->npaths = 0;
 }
 
-static NVGpath* nvg__lastPath(NVGcontext* ctx)
+static NVGpath* nvg__lastPath(NVGtessContext* tess)
 {
-	if (ctx->cache->npaths > 0)
-		return &ctx->cache->paths[ctx->cache->npaths-1];
+	if (tess->cache->npaths > 0)
+		return &tess->cache->paths[tess->cache->npaths-1];
 	return NULL;
 }
 
-static void nvg__addPath(NVGcontext* ctx)
+static void nvg__addPath(NVGtessContext* tess)
 {
 	NVGpath* path;
-	if (ctx->cache->npaths+1 > ctx->cache->cpaths) {
+	if (tess->cache->npaths+1 > tess->cache->cpaths) {
 		NVGpath* paths;
-		int cpaths = ctx->cache->npaths+1 + ctx->cache->cpaths/2;
-		paths = (NVGpath*)realloc(ctx->cache->paths, sizeof(NVGpath)*cpaths);
+		int cpaths = tess->cache->npaths+1 + tess->cache->cpaths/2;
+		paths = (NVGpath*)realloc(tess->cache->paths, sizeof(NVGpath)*cpaths);
 		if (paths == NULL) return;
-		ctx->cache->paths = paths;
-		ctx->cache->cpaths = cpaths;
+		tess->cache->paths = paths;
+		tess->cache->cpaths = cpaths;
 	}
-	path = &ctx->cache->paths[ctx->cache->npaths];
+	path = &tess->cache->paths[tess->cache->npaths];
 	memset(path, 0, sizeof(*path));
-	path->first = ctx->cache->npoints;
+	path->first = tess->cache->npoints;
 	path->winding = NVG_CCW;
 
-	ctx->cache->npaths++;
+	tess->cache->npaths++;
 }
 
-static NVGpoint* nvg__lastPoint(NVGcontext* ctx)
+static NVGpoint* nvg__lastPoint(NVGtessContext* tess)
 {
-	if (ctx->cache->npoints > 0)
-		return &ctx->cache->points[ctx->cache->npoints-1];
+	if (tess->cache->npoints > 0)
+		return &tess->cache->points[tess->cache->npoints-1];
 	return NULL;
 }
 
-static void nvg__addPoint(NVGcontext* ctx, float x, float y, int flags)
+static void nvg__addPoint(NVGtessContext* tess, float x, float y, int flags)
 {
-	NVGpath* path = nvg__lastPath(ctx);
+	NVGpath* path = nvg__lastPath(tess);
 	NVGpoint* pt;
 	if (path == NULL) return;
 
-	if (path->count > 0 && ctx->cache->npoints > 0) {
-		pt = nvg__lastPoint(ctx);
-		if (nvg__ptEquals(pt->x,pt->y, x,y, ctx->distTol)) {
+	if (path->count > 0 && tess->cache->npoints > 0) {
+		pt = nvg__lastPoint(tess);
+		if (nvg__ptEquals(pt->x,pt->y, x,y, tess->distTol)) {
 			pt->flags |= flags;
 			return;
 		}
 	}
 
-	if (ctx->cache->npoints+1 > ctx->cache->cpoints) {
+	if (tess->cache->npoints+1 > tess->cache->cpoints) {
 		NVGpoint* points;
-		int cpoints = ctx->cache->npoints+1 + ctx->cache->cpoints/2;
-		points = (NVGpoint*)realloc(ctx->cache->points, sizeof(NVGpoint)*cpoints);
+		int cpoints = tess->cache->npoints+1 + tess->cache->cpoints/2;
+		points = (NVGpoint*)realloc(tess->cache->points, sizeof(NVGpoint)*cpoints);
 		if (points == NULL) return;
-		ctx->cache->points = points;
-		ctx->cache->cpoints = cpoints;
+		tess->cache->points = points;
+		tess->cache->cpoints = cpoints;
 	}
 
-	pt = &ctx->cache->points[ctx->cache->npoints];
+	pt = &tess->cache->points[tess->cache->npoints];
 	memset(pt, 0, sizeof(*pt));
 	pt->x = x;
 	pt->y = y;
 	pt->flags = (unsigned char)flags;
 
-	ctx->cache->npoints++;
+	tess->cache->npoints++;
 	path->count++;
 }
 
-static void nvg__closePath(NVGcontext* ctx)
+static void nvg__closePath(NVGtessContext* tess)
 {
-	NVGpath* path = nvg__lastPath(ctx);
+	NVGpath* path = nvg__lastPath(tess);
 	if (path == NULL) return;
 	path->closed = 1;
 }
 
-static void nvg__pathWinding(NVGcontext* ctx, int winding)
+static void nvg__pathWinding(NVGtessContext* tess, int winding)
 {
-	NVGpath* path = nvg__lastPath(ctx);
+	NVGpath* path = nvg__lastPath(tess);
 	if (path == NULL) return;
 	path->winding = winding;
 }
@@ -1222,18 +1471,18 @@ static float nvg__getAverageScale(float *t)
 	return (sx + sy) * 0.5f;
 }
 
-static NVGvertex* nvg__allocTempVerts(NVGcontext* ctx, int nverts)
+static NVGvertex* nvg__allocTempVerts(NVGpathCache* cache, int nverts)
 {
-	if (nverts > ctx->cache->cverts) {
+	if (nverts > cache->cverts) {
 		NVGvertex* verts;
 		int cverts = (nverts + 0xff) & ~0xff; // Round up to prevent allocations when things change just slightly.
-		verts = (NVGvertex*)realloc(ctx->cache->verts, sizeof(NVGvertex)*cverts);
+		verts = (NVGvertex*)realloc(cache->verts, sizeof(NVGvertex)*cverts);
 		if (verts == NULL) return NULL;
-		ctx->cache->verts = verts;
-		ctx->cache->cverts = cverts;
+		cache->verts = verts;
+		cache->cverts = cverts;
 	}
 
-	return ctx->cache->verts;
+	return cache->verts;
 }
 
 static float nvg__triarea2(float ax, float ay, float bx, float by, float cx, float cy)
@@ -1280,7 +1529,7 @@ static void nvg__vset(NVGvertex* vtx, float x, float y, float u, float v)
 	vtx->v = v;
 }
 
-static void nvg__tesselateBezier(NVGcontext* ctx,
+static void nvg__tesselateBezier(NVGtessContext* tess,
 								 float x1, float y1, float x2, float y2,
 								 float x3, float y3, float x4, float y4,
 								 int level, int type)
@@ -1304,13 +1553,13 @@ static void nvg__tesselateBezier(NVGcontext* ctx,
 	d2 = nvg__absf(((x2 - x4) * dy - (y2 - y4) * dx));
 	d3 = nvg__absf(((x3 - x4) * dy - (y3 - y4) * dx));
 
-	if ((d2 + d3)*(d2 + d3) < ctx->tessTol * (dx*dx + dy*dy)) {
-		nvg__addPoint(ctx, x4, y4, type);
+	if ((d2 + d3)*(d2 + d3) < tess->tessTol * (dx*dx + dy*dy)) {
+		nvg__addPoint(tess, x4, y4, type);
 		return;
 	}
 
-/*	if (nvg__absf(x1+x3-x2-x2) + nvg__absf(y1+y3-y2-y2) + nvg__absf(x2+x4-x3-x3) + nvg__absf(y2+y4-y3-y3) < ctx->tessTol) {
-		nvg__addPoint(ctx, x4, y4, type);
+/*	if (nvg__absf(x1+x3-x2-x2) + nvg__absf(y1+y3-y2-y2) + nvg__absf(x2+x4-x3-x3) + nvg__absf(y2+y4-y3-y3) < tess->tessTol) {
+		nvg__addPoint(tess, x4, y4, type);
 		return;
 	}*/
 
@@ -1319,13 +1568,13 @@ static void nvg__tesselateBezier(NVGcontext* ctx,
 	x1234 = (x123+x234)*0.5f;
 	y1234 = (y123+y234)*0.5f;
 
-	nvg__tesselateBezier(ctx, x1,y1, x12,y12, x123,y123, x1234,y1234, level+1, 0);
-	nvg__tesselateBezier(ctx, x1234,y1234, x234,y234, x34,y34, x4,y4, level+1, type);
+	nvg__tesselateBezier(tess, x1,y1, x12,y12, x123,y123, x1234,y1234, level+1, 0);
+	nvg__tesselateBezier(tess, x1234,y1234, x234,y234, x34,y34, x4,y4, level+1, type);
 }
 
-static void nvg__flattenPaths(NVGcontext* ctx)
+static void nvg__flattenPaths(NVGtessContext* tess)
 {
-	NVGpathCache* cache = ctx->cache;
+	NVGpathCache* cache = tess->cache;
 //	NVGstate* state = nvg__getState(ctx);
 	NVGpoint* last;
 	NVGpoint* p0;
@@ -1333,9 +1582,9 @@ static void nvg__flattenPaths(NVGcontext* ctx)
 	NVGpoint* pts;
 	NVGpath* path;
 	int i, j;
-	float* cp1;
-	float* cp2;
-	float* p;
+	const float* cp1;
+	const float* cp2;
+	const float* p;
 	float area;
 
 	if (cache->npaths > 0)
@@ -1343,36 +1592,36 @@ static void nvg__flattenPaths(NVGcontext* ctx)
 
 	// Flatten
 	i = 0;
-	while (i < ctx->ncommands) {
-		int cmd = (int)ctx->commands[i];
+	while (i < tess->ncommands) {
+		int cmd = (int)tess->commands[i];
 		switch (cmd) {
 		case NVG_MOVETO:
-			nvg__addPath(ctx);
-			p = &ctx->commands[i+1];
-			nvg__addPoint(ctx, p[0], p[1], NVG_PT_CORNER);
+			nvg__addPath(tess);
+			p = &tess->commands[i+1];
+			nvg__addPoint(tess, p[0], p[1], NVG_PT_CORNER);
 			i += 3;
 			break;
 		case NVG_LINETO:
-			p = &ctx->commands[i+1];
-			nvg__addPoint(ctx, p[0], p[1], NVG_PT_CORNER);
+			p = &tess->commands[i+1];
+			nvg__addPoint(tess, p[0], p[1], NVG_PT_CORNER);
 			i += 3;
 			break;
 		case NVG_BEZIERTO:
-			last = nvg__lastPoint(ctx);
+			last = nvg__lastPoint(tess);
 			if (last != NULL) {
-				cp1 = &ctx->commands[i+1];
-				cp2 = &ctx->commands[i+3];
-				p = &ctx->commands[i+5];
-				nvg__tesselateBezier(ctx, last->x,last->y, cp1[0],cp1[1], cp2[0],cp2[1], p[0],p[1], 0, NVG_PT_CORNER);
+				cp1 = &tess->commands[i+1];
+				cp2 = &tess->commands[i+3];
+				p = &tess->commands[i+5];
+				nvg__tesselateBezier(tess, last->x,last->y, cp1[0],cp1[1], cp2[0],cp2[1], p[0],p[1], 0, NVG_PT_CORNER);
 			}
 			i += 7;
 			break;
 		case NVG_CLOSE:
-			nvg__closePath(ctx);
+			nvg__closePath(tess);
 			i++;
 			break;
 		case NVG_WINDING:
-			nvg__pathWinding(ctx, (int)ctx->commands[i+1]);
+			nvg__pathWinding(tess, (int)tess->commands[i+1]);
 			i += 2;
 			break;
 		default:
@@ -1391,7 +1640,7 @@ static void nvg__flattenPaths(NVGcontext* ctx)
 		// If the first and last points are the same, remove the last, mark as closed path.
 		p0 = &pts[path->count-1];
 		p1 = &pts[0];
-		if (nvg__ptEquals(p0->x,p0->y, p1->x,p1->y, ctx->distTol)) {
+		if (nvg__ptEquals(p0->x,p0->y, p1->x,p1->y, tess->distTol)) {
 			path->count--;
 			p0 = &pts[path->count-1];
 			path->closed = 1;
@@ -1652,9 +1901,9 @@ static NVGvertex* nvg__roundCapEnd(NVGvertex* dst, NVGpoint* p,
 }
 
 
-static void nvg__calculateJoins(NVGcontext* ctx, float w, int lineJoin, float miterLimit)
+static void nvg__calculateJoins(NVGtessContext* tess, float w, int lineJoin, float miterLimit)
 {
-	NVGpathCache* cache = ctx->cache;
+	NVGpathCache* cache = tess->cache;
 	int i, j;
 	float iw = 0.0f;
 
@@ -1722,15 +1971,15 @@ static void nvg__calculateJoins(NVGcontext* ctx, float w, int lineJoin, float mi
 }
 
 
-static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap, int lineJoin, float miterLimit)
+static int nvg__expandStroke(NVGtessContext* tess, float w, float fringe, int lineCap, int lineJoin, float miterLimit)
 {
-	NVGpathCache* cache = ctx->cache;
+	NVGpathCache* cache = tess->cache;
 	NVGvertex* verts;
 	NVGvertex* dst;
 	int cverts, i, j;
-	float aa = fringe;//ctx->fringeWidth;
+	float aa = fringe;//tess->fringeWidth;
 	float u0 = 0.0f, u1 = 1.0f;
-	int ncap = nvg__curveDivs(w, NVG_PI, ctx->tessTol);	// Calculate divisions per half circle.
+	int ncap = nvg__curveDivs(w, NVG_PI, tess->tessTol);	// Calculate divisions per half circle.
 
 	w += aa * 0.5f;
 
@@ -1740,7 +1989,7 @@ static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap
 		u1 = 0.5f;
 	}
 
-	nvg__calculateJoins(ctx, w, lineJoin, miterLimit);
+	nvg__calculateJoins(tess, w, lineJoin, miterLimit);
 
 	// Calculate max vertex usage.
 	cverts = 0;
@@ -1761,7 +2010,7 @@ static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap
 		}
 	}
 
-	verts = nvg__allocTempVerts(ctx, cverts);
+	verts = nvg__allocTempVerts(cache, cverts);
 	if (verts == NULL) return 0;
 
 	for (i = 0; i < cache->npaths; i++) {
@@ -1774,6 +2023,7 @@ static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap
 
 		path->fill = 0;
 		path->nfill = 0;
+		path->triangulated = 0;
 
 		// Calculate fringe or stroke
 		loop = (path->closed == 0) ? 0 : 1;
@@ -1846,16 +2096,129 @@ static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap
 	return 1;
 }
 
-static int nvg__expandFill(NVGcontext* ctx, float w, int lineJoin, float miterLimit)
+// Returns 1 if segments ab and cd touch or cross.
+static int nvg__segmentsTouch(const NVGvertex* a, const NVGvertex* b, const NVGvertex* c, const NVGvertex* d)
 {
-	NVGpathCache* cache = ctx->cache;
+	float d0 = nvg__triarea2(a->x,a->y, b->x,b->y, c->x,c->y), d1 = nvg__triarea2(a->x,a->y, b->x,b->y, d->x,d->y);
+	float d2 = nvg__triarea2(c->x,c->y, d->x,d->y, a->x,a->y), d3 = nvg__triarea2(c->x,c->y, d->x,d->y, b->x,b->y);
+	if (((d0 > 0 && d1 > 0) || (d0 < 0 && d1 < 0)) || ((d2 > 0 && d3 > 0) || (d2 < 0 && d3 < 0)))
+		return 0;
+	if (d0 == 0 && d1 == 0) {
+		// Collinear, check if the projections overlap.
+		return nvg__minf(a->x, b->x) <= nvg__maxf(c->x, d->x) && nvg__minf(c->x, d->x) <= nvg__maxf(a->x, b->x) &&
+			   nvg__minf(a->y, b->y) <= nvg__maxf(c->y, d->y) && nvg__minf(c->y, d->y) <= nvg__maxf(a->y, b->y);
+	}
+	return 1;
+}
+
+// Returns 1 if p lies inside or on the edges of triangle abc with the given orientation.
+static int nvg__pointInTriangle(const NVGvertex* p, const NVGvertex* a, const NVGvertex* b, const NVGvertex* c, float sign)
+{
+	return nvg__triarea2(a->x,a->y, b->x,b->y, p->x,p->y)*sign >= 0 &&
+		   nvg__triarea2(b->x,b->y, c->x,c->y, p->x,p->y)*sign >= 0 &&
+		   nvg__triarea2(c->x,c->y, a->x,a->y, p->x,p->y)*sign >= 0;
+}
+
+// Triangulates a simple polygon by ear clipping into a triangle list of the same winding.
+// Returns the number of vertices written to dst, or 0 if the polygon self intersects
+// and has to go through the stencil path.
+static int nvg__triangulate(const NVGvertex* pts, int npts, NVGvertex* dst)
+{
+	int idx[NVG_TRIANGULATE_MAX_VERTS];
+	const NVGvertex *a, *b, *c;
+	float area = 0, sign;
+	int i, j, n, miss, nverts = 0;
+
+	if (npts < 3 || npts > NVG_TRIANGULATE_MAX_VERTS)
+		return 0;
+
+	// The stencil path fills by non-zero winding, which matches plain coverage only for simple polygons.
+	for (i = 0; i < npts; i++) {
+		for (j = i+2; j < npts; j++) {
+			if (i == 0 && j == npts-1)
+				continue;
+			if (nvg__segmentsTouch(&pts[i], &pts[i+1], &pts[j], &pts[(j+1) % npts]))
+				return 0;
+		}
+	}
+
+	for (i = 0; i < npts; i++) {
+		if (i >= 2)
+			area += nvg__triarea2(pts[0].x,pts[0].y, pts[i-1].x,pts[i-1].y, pts[i].x,pts[i].y);
+		idx[i] = i;
+	}
+	if (area == 0)
+		return 0;
+	sign = area > 0 ? 1.0f : -1.0f;
+
+	n = npts;
+	i = miss = 0;
+	while (n > 3) {
+		float turn;
+		int ear;
+
+		a = &pts[idx[(i+n-1) % n]];
+		b = &pts[idx[i]];
+		c = &pts[idx[(i+1) % n]];
+		turn = nvg__triarea2(a->x,a->y, b->x,b->y, c->x,c->y)*sign;
+		ear = turn >= 0;
+
+		// No other remaining vertex may lie in the ear, duplicates of its corners aside.
+		for (j = 0; ear && turn > 0 && j < n; j++) {
+			const NVGvertex* p = &pts[idx[j]];
+			if (p == a || p == b || p == c)
+				continue;
+			if ((p->x == a->x && p->y == a->y) || (p->x == b->x && p->y == b->y) || (p->x == c->x && p->y == c->y))
+				continue;
+			ear = !nvg__pointInTriangle(p, a, b, c, sign);
+		}
+
+		if (!ear) {
+			// Went all the way around without finding an ear.
+			if (++miss > n)
+				return 0;
+			i = (i+1) % n;
+			continue;
+		}
+
+		// Collinear corners are dropped without emitting a degenerate triangle.
+		if (turn > 0) {
+			dst[nverts++] = *a;
+			dst[nverts++] = *b;
+			dst[nverts++] = *c;
+		}
+		for (j = i; j < n-1; j++)
+			idx[j] = idx[j+1];
+		n--;
+		if (i >= n)
+			i = 0;
+		miss = 0;
+	}
+
+	a = &pts[idx[0]];
+	b = &pts[idx[1]];
+	c = &pts[idx[2]];
+	if (nvg__triarea2(a->x,a->y, b->x,b->y, c->x,c->y)*sign > 0) {
+		dst[nverts++] = *a;
+		dst[nverts++] = *b;
+		dst[nverts++] = *c;
+	}
+	return nverts;
+}
+
+static int nvg__expandFill(NVGtessContext* tess, float w, int lineJoin, float miterLimit)
+{
+	NVGpathCache* cache = tess->cache;
 	NVGvertex* verts;
 	NVGvertex* dst;
-	int cverts, convex, i, j;
-	float aa = ctx->fringeWidth;
+	int cverts, convex, triangulate, i, j;
+	float aa = tess->fringeWidth;
 	int fringe = w > 0.0f;
 
-	nvg__calculateJoins(ctx, w, lineJoin, miterLimit);
+	nvg__calculateJoins(tess, w, lineJoin, miterLimit);
+
+	convex = cache->npaths == 1 && cache->paths[0].convex;
+	triangulate = tess->params->triangulateFills && cache->npaths == 1 && !convex;
 
 	// Calculate max vertex usage.
 	cverts = 0;
@@ -1864,13 +2227,13 @@ static int nvg__expandFill(NVGcontext* ctx, float w, int lineJoin, float miterLi
 		cverts += path->count + path->nbevel + 1;
 		if (fringe)
 			cverts += (path->count + path->nbevel*5 + 1) * 2; // plus one for loop
+		if (triangulate)
+			cverts += (path->count + path->nbevel) * 3;
 	}
 
-	verts = nvg__allocTempVerts(ctx, cverts);
+	verts = nvg__allocTempVerts(cache, cverts);
 	if (verts == NULL) return 0;
 
-	convex = cache->npaths == 1 && cache->paths[0].convex;
-
 	for (i = 0; i < cache->npaths; i++) {
 		NVGpath* path = &cache->paths[i];
 		NVGpoint* pts = &cache->points[path->first];
@@ -1921,6 +2284,18 @@ static int nvg__expandFill(NVGcontext* ctx, float w, int lineJoin, float miterLi
 		path->nfill = (int)(dst - verts);
 		verts = dst;
 
+		// Small concave fills are cut into triangles, so they can be drawn like convex ones.
+		path->triangulated = 0;
+		if (triangulate) {
+			int ntris = nvg__triangulate(path->fill, path->nfill, verts);
+			if (ntris > 0) {
+				path->fill = verts;
+				path->nfill = ntris;
+				path->triangulated = 1;
+				verts += ntris;
+			}
+		}
+
 		// Calculate fringe
 		if (fringe) {
 			lw = w + woff;
@@ -1932,7 +2307,7 @@ static int nvg__expandFill(NVGcontext* ctx, float w, int lineJoin, float miterLi
 
 			// Create only half a fringe for convex shapes so that
 			// the shape can be rendered without stenciling.
-			if (convex) {
+			if (convex || path->triangulated) {
 				lw = woff;	// This should generate the same vertex as fill inset above.
 				lu = 0.5f;	// Set outline fade at middle.
 			}
@@ -1943,7 +2318,7 @@ static int nvg__expandFill(NVGcontext* ctx, float w, int lineJoin, float miterLi
 
 			for (j = 0; j < path->count; ++j) {
 				if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0) {
-					dst = nvg__bevelJoin(dst, p0, p1, lw, rw, lu, ru, ctx->fringeWidth);
+					dst = nvg__bevelJoin(dst, p0, p1, lw, rw, lu, ru, tess->fringeWidth);
 				} else {
 					nvg__vset(dst, p1->x + (p1->dmx * lw), p1->y + (p1->dmy * lw), lu,1); dst++;
 					nvg__vset(dst, p1->x - (p1->dmx * rw), p1->y - (p1->dmy * rw), ru,1); dst++;
@@ -1966,6 +2341,432 @@ static int nvg__expandFill(NVGcontext* ctx, float w, int lineJoin, float miterLi
 	return 1;
 }
 
+// Copies the commands of the current path into dst with every coordinate made relative to the
+// first point, so that translated copies of a shape produce the same commands.
+// Returns 0 if the path is not worth caching.
+static int nvg__normalizeCommands(NVGcontext* ctx, float* dst, float* ox, float* oy)
+{
+	int i = 0, j;
+
+	if (ctx->ncommands == 0 || ctx->ncommands > NVG_GEOMCACHE_MAX_COMMANDS || (int)ctx->commands[0] != NVG_MOVETO)
+		return 0;
+
+	*ox = ctx->commands[1];
+	*oy = ctx->commands[2];
+
+	while (i < ctx->ncommands) {
+		int cmd = (int)ctx->commands[i];
+		int npts = 0;
+		dst[i] = ctx->commands[i];
+		switch (cmd) {
+		case NVG_MOVETO:
+		case NVG_LINETO:
+			npts = 1;
+			break;
+		case NVG_BEZIERTO:
+			npts = 3;
+			break;
+		case NVG_WINDING:
+			dst[i+1] = ctx->commands[i+1];
+			i++;
+			break;
+		}
+		for (j = 0; j < npts; j++) {
+			dst[i+1+j*2] = ctx->commands[i+1+j*2] - *ox;
+			dst[i+2+j*2] = ctx->commands[i+2+j*2] - *oy;
+		}
+		i += 1 + npts*2;
+	}
+
+	return 1;
+}
+
+static unsigned int nvg__hashCommands(const float* commands, int ncommands, float fringe, float fringeWidth)
+{
+	// FNV-1a over the bit patterns.
+	unsigned int h = 2166136261u, bits;
+	int i;
+	for (i = 0; i < ncommands; i++) {
+		memcpy(&bits, &commands[i], sizeof(bits));
+		h = (h ^ bits) * 16777619u;
+	}
+	memcpy(&bits, &fringe, sizeof(bits));
+	h = (h ^ bits) * 16777619u;
+	memcpy(&bits, &fringeWidth, sizeof(bits));
+	h = (h ^ bits) * 16777619u;
+	return h;
+}
+
+static int nvg__geomCacheMatch(NVGcontext* ctx, NVGgeomCacheEntry* entry, unsigned int hash, const float* commands, float fringe)
+{
+	return entry->ncommands == ctx->ncommands && entry->hash == hash &&
+		entry->fringe == fringe && entry->fringeWidth == ctx->fringeWidth &&
+		memcmp(entry->commands, commands, sizeof(float)*ctx->ncommands) == 0;
+}
+
+static int nvg__geomCacheStore(NVGcontext* ctx, NVGgeomCacheEntry* entry, unsigned int hash, const float* commands, float fringe, float ox, float oy)
+{
+	NVGpathCache* cache = ctx->cache;
+	NVGvertex* end = cache->verts;
+	int i, nverts;
+
+	// Expanded vertices are packed at the start of the temp buffer.
+	for (i = 0; i < cache->npaths; i++) {
+		NVGpath* path = &cache->paths[i];
+		if (path->fill != NULL && path->fill + path->nfill > end) end = path->fill + path->nfill;
+		if (path->stroke != NULL && path->stroke + path->nstroke > end) end = path->stroke + path->nstroke;
+	}
+	nverts = (int)(end - cache->verts);
+
+	entry->ncommands = 0;
+	if (ctx->ncommands > entry->ccommands) {
+		float* buf = (float*)realloc(entry->commands, sizeof(float)*ctx->ncommands);
+		if (buf == NULL) return 0;
+		entry->commands = buf;
+		entry->ccommands = ctx->ncommands;
+	}
+	if (cache->npaths > entry->cpaths) {
+		NVGpath* buf = (NVGpath*)realloc(entry->paths, sizeof(NVGpath)*cache->npaths);
+		if (buf == NULL) return 0;
+		entry->paths = buf;
+		entry->cpaths = cache->npaths;
+	}
+	if (nverts > entry->cverts) {
+		int cverts = (nverts + 0xff) & ~0xff;
+		NVGvertex* buf = (NVGvertex*)realloc(entry->verts, sizeof(NVGvertex)*cverts);
+		if (buf == NULL) return 0;
+		entry->verts = buf;
+		entry->cverts = cverts;
+	}
+
+	for (i = 0; i < nverts; i++) {
+		entry->verts[i] = cache->verts[i];
+		entry->verts[i].x -= ox;
+		entry->verts[i].y -= oy;
+	}
+	for (i = 0; i < cache->npaths; i++) {
+		NVGpath* path = &entry->paths[i];
+		*path = cache->paths[i];
+		if (path->fill != NULL) path->fill = entry->verts + (path->fill - cache->verts);
+		if (path->stroke != NULL) path->stroke = entry->verts + (path->stroke - cache->verts);
+	}
+	memcpy(entry->commands, commands, sizeof(float)*ctx->ncommands);
+
+	entry->hash = hash;
+	entry->fringe = fringe;
+	entry->fringeWidth = ctx->fringeWidth;
+	entry->ncommands = ctx->ncommands;
+	entry->npaths = cache->npaths;
+	entry->nverts = nverts;
+	entry->bounds[0] = cache->bounds[0] - ox;
+	entry->bounds[1] = cache->bounds[1] - oy;
+	entry->bounds[2] = cache->bounds[2] - ox;
+	entry->bounds[3] = cache->bounds[3] - oy;
+	return 1;
+}
+
+// Fills the path cache with the entry's paths and vertices moved to (ox,oy).
+// The points are not restored, so the path cache must be cleared after use.
+static int nvg__geomCacheRestore(NVGcontext* ctx, NVGgeomCacheEntry* entry, float ox, float oy)
+{
+	NVGpathCache* cache = ctx->cache;
+	NVGvertex* verts;
+	int i;
+
+	if (entry->npaths > cache->cpaths) {
+		NVGpath* paths = (NVGpath*)realloc(cache->paths, sizeof(NVGpath)*entry->npaths);
+		if (paths == NULL) return 0;
+		cache->paths = paths;
+		cache->cpaths = entry->npaths;
+	}
+	verts = nvg__allocTempVerts(cache, entry->nverts);
+	if (verts == NULL) return 0;
+
+	for (i = 0; i < entry->nverts; i++) {
+		verts[i] = entry->verts[i];
+		verts[i].x += ox;
+		verts[i].y += oy;
+	}
+	for (i = 0; i < entry->npaths; i++) {
+		NVGpath* path = &cache->paths[i];
+		*path = entry->paths[i];
+		if (path->fill != NULL) path->fill = verts + (path->fill - entry->verts);
+		if (path->stroke != NULL) path->stroke = verts + (path->stroke - entry->verts);
+	}
+	cache->npaths = entry->npaths;
+	cache->bounds[0] = entry->bounds[0] + ox;
+	cache->bounds[1] = entry->bounds[1] + oy;
+	cache->bounds[2] = entry->bounds[2] + ox;
+	cache->bounds[3] = entry->bounds[3] + oy;
+	return 1;
+}
+
+// Returns 1 if bounds [minx,miny,maxx,maxy] lie fully outside the current scissor.
+static int nvg__outsideScissor(NVGcontext* ctx, const float* bounds)
+{
+	NVGscissor* scissor = &nvg__getState(ctx)->scissor;
+	const float* t = scissor->xform;
+	float ex, ey;
+
+	if (scissor->extent[0] < -0.5f || scissor->extent[1] < -0.5f)
+		return 0;
+
+	// Axis aligned bounds of the (possibly rotated) scissor rect.
+	ex = nvg__absf(t[0])*scissor->extent[0] + nvg__absf(t[2])*scissor->extent[1];
+	ey = nvg__absf(t[1])*scissor->extent[0] + nvg__absf(t[3])*scissor->extent[1];
+	return bounds[2] < t[4]-ex || bounds[0] > t[4]+ex || bounds[3] < t[5]-ey || bounds[1] > t[5]+ey;
+}
+
+// Returns 1 if the current path, grown by pad, cannot touch the current scissor.
+// Bezier control points are included, so the test is conservative.
+static int nvg__pathOutsideScissor(NVGcontext* ctx, float pad)
+{
+	float bounds[4] = { 1e6f, 1e6f, -1e6f, -1e6f };
+	int i = 0, j, npts;
+
+	while (i < ctx->ncommands) {
+		int cmd = (int)ctx->commands[i];
+		switch (cmd) {
+		case NVG_MOVETO:
+		case NVG_LINETO:
+			npts = 1;
+			break;
+		case NVG_BEZIERTO:
+			npts = 3;
+			break;
+		case NVG_WINDING:
+			i += 2;
+			continue;
+		default:
+			i++;
+			continue;
+		}
+		for (j = 0; j < npts; j++) {
+			float x = ctx->commands[i+1+j*2], y = ctx->commands[i+2+j*2];
+			bounds[0] = nvg__minf(bounds[0], x);
+			bounds[1] = nvg__minf(bounds[1], y);
+			bounds[2] = nvg__maxf(bounds[2], x);
+			bounds[3] = nvg__maxf(bounds[3], y);
+		}
+		i += 1 + npts*2;
+	}
+
+	if (bounds[0] > bounds[2])
+		return 0;
+
+	bounds[0] -= pad;
+	bounds[1] -= pad;
+	bounds[2] += pad;
+	bounds[3] += pad;
+	return nvg__outsideScissor(ctx, bounds);
+}
+
+// Returns the geometry cache slot of the current path, or NULL if it is not cached.
+// hit is set if the slot already holds the path.
+static NVGgeomCacheEntry* nvg__geomCacheFind(NVGcontext* ctx, float* commands, float fringe, float* ox, float* oy, unsigned int* hash, int* hit)
+{
+	NVGgeomCacheEntry* entry;
+
+	*hit = 0;
+	if (!nvg__normalizeCommands(ctx, commands, ox, oy))
+		return NULL;
+
+	*hash = nvg__hashCommands(commands, ctx->ncommands, fringe, ctx->fringeWidth);
+	entry = &ctx->geomCache[*hash & (NVG_GEOMCACHE_SIZE-1)];
+	*hit = nvg__geomCacheMatch(ctx, entry, *hash, commands, fringe);
+	return entry;
+}
+
+// Tessellates the current path unless already done, and renders it as a fill.
+static void nvg__fill(NVGcontext* ctx, NVGpaint* fillPaint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+					  float fringe, int tessellated)
+{
+	const NVGpath* path;
+	NVGgeomCacheEntry* entry;
+	float commands[NVG_GEOMCACHE_MAX_COMMANDS];
+	float ox = 0, oy = 0;
+	unsigned int hash = 0;
+	int i, hit, cached = 0;
+
+	// Small paths are looked up in the geometry cache,
+	// translated copies of the same shape then reuse the tessellation.
+	entry = nvg__geomCacheFind(ctx, commands, fringe, &ox, &oy, &hash, &hit);
+	if (hit)
+		cached = nvg__geomCacheRestore(ctx, entry, ox, oy);
+
+	if (!cached) {
+		if (!tessellated) {
+			NVGtessContext tess = nvg__tessContext(ctx, ctx->cache, ctx->commands, ctx->ncommands);
+			nvg__flattenPaths(&tess);
+			nvg__expandFill(&tess, fringe, NVG_MITER, 2.4f);
+		}
+		if (entry != NULL)
+			nvg__geomCacheStore(ctx, entry, hash, commands, fringe, ox, oy);
+	}
+
+	ctx->params.renderFill(ctx->params.userPtr, fillPaint, compositeOperation, scissor, ctx->fringeWidth,
+						   ctx->cache->bounds, ctx->cache->paths, ctx->cache->npaths);
+
+	// Count triangles
+	for (i = 0; i < ctx->cache->npaths; i++) {
+		path = &ctx->cache->paths[i];
+		ctx->fillTriCount += path->triangulated ? path->nfill/3 : path->nfill-2;
+		ctx->fillTriCount += path->nstroke-2;
+		ctx->drawCallCount += 2;
+	}
+
+	// Restored paths have no points behind them, so nvgStroke() has to flatten again.
+	if (cached)
+		nvg__clearPathCache(ctx);
+}
+
+// Tessellates the current path unless already done, and renders it as a stroke.
+static void nvg__stroke(NVGcontext* ctx, NVGpaint* strokePaint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+						float strokeWidth, float fringe, int lineCap, int lineJoin, float miterLimit, int tessellated)
+{
+	const NVGpath* path;
+	int i;
+
+	if (!tessellated) {
+		NVGtessContext tess = nvg__tessContext(ctx, ctx->cache, ctx->commands, ctx->ncommands);
+		nvg__flattenPaths(&tess);
+		nvg__expandStroke(&tess, strokeWidth*0.5f, fringe, lineCap, lineJoin, miterLimit);
+	}
+
+	ctx->params.renderStroke(ctx->params.userPtr, strokePaint, compositeOperation, scissor, ctx->fringeWidth,
+							 strokeWidth, ctx->cache->paths, ctx->cache->npaths);
+
+	// Count triangles
+	for (i = 0; i < ctx->cache->npaths; i++) {
+		path = &ctx->cache->paths[i];
+		ctx->strokeTriCount += path->nstroke-2;
+		ctx->drawCallCount++;
+	}
+}
+
+static void nvg__deleteJobs(NVGcontext* ctx)
+{
+	int i;
+	for (i = 0; i < ctx->cjobs; i++) {
+		if (ctx->jobs[i].commands != NULL) free(ctx->jobs[i].commands);
+		if (ctx->jobs[i].cache != NULL) nvg__deletePathCache(ctx->jobs[i].cache);
+	}
+	if (ctx->jobs != NULL) free(ctx->jobs);
+	ctx->jobs = NULL;
+	ctx->njobs = ctx->cjobs = 0;
+}
+
+// Records the current path as a job, returns NULL if deferred tessellation is off or out of memory.
+static NVGjob* nvg__allocJob(NVGcontext* ctx, int type)
+{
+	NVGjob* job;
+
+	if (ctx->workers.parallelFor == NULL)
+		return NULL;
+
+	if (ctx->njobs+1 > ctx->cjobs) {
+		NVGjob* jobs;
+		int cjobs = ctx->njobs+1 + ctx->cjobs/2;
+		jobs = (NVGjob*)realloc(ctx->jobs, sizeof(NVGjob)*cjobs);
+		if (jobs == NULL) return NULL;
+		memset(&jobs[ctx->cjobs], 0, sizeof(NVGjob)*(cjobs - ctx->cjobs));
+		ctx->jobs = jobs;
+		ctx->cjobs = cjobs;
+	}
+
+	job = &ctx->jobs[ctx->njobs];
+	if (job->cache == NULL) {
+		job->cache = nvg__allocPathCache();
+		if (job->cache == NULL) return NULL;
+	}
+	// Sized like the context's command buffer, so the slot of a job only grows when that one does
+	// and not each time a longer path lands in it.
+	if (ctx->ncommands > job->ccommands) {
+		float* commands = (float*)realloc(job->commands, sizeof(float)*ctx->ccommands);
+		if (commands == NULL) return NULL;
+		job->commands = commands;
+		job->ccommands = ctx->ccommands;
+	}
+
+	memcpy(job->commands, ctx->commands, sizeof(float)*ctx->ncommands);
+	job->ncommands = ctx->ncommands;
+	job->cache->npoints = 0;
+	job->cache->npaths = 0;
+	job->type = type;
+	job->tessellate = 1;
+
+	ctx->njobs++;
+	return job;
+}
+
+static void nvg__runJob(void* arg, int index, int worker)
+{
+	NVGcontext* ctx = (NVGcontext*)arg;
+	NVGjob* job = &ctx->jobs[index];
+	NVGtessContext tess;
+	NVG_NOTUSED(worker);
+
+	if (!job->tessellate)
+		return;
+
+	// The context is only read while the workers run.
+	tess = nvg__tessContext(ctx, job->cache, job->commands, job->ncommands);
+	nvg__flattenPaths(&tess);
+	if (job->type == NVG_JOB_FILL)
+		nvg__expandFill(&tess, job->fringe, NVG_MITER, 2.4f);
+	else
+		nvg__expandStroke(&tess, job->strokeWidth*0.5f, job->fringe, job->lineCap, job->lineJoin, job->miterLimit);
+}
+
+// Tessellates the recorded jobs and renders them in submission order.
+static void nvg__flushJobs(NVGcontext* ctx)
+{
+	NVGpathCache* cache = ctx->cache;
+	float* commands = ctx->commands;
+	int ncommands = ctx->ncommands;
+	int i;
+
+	if (ctx->njobs == 0)
+		return;
+
+	// Waking the workers is not worth it for a single job.
+	if (ctx->njobs == 1)
+		nvg__runJob(ctx, 0, 0);
+	else
+		ctx->workers.parallelFor(ctx->workers.userPtr, ctx->njobs, nvg__runJob, ctx);
+
+	// Render with the job's path in place of the current one.
+	for (i = 0; i < ctx->njobs; i++) {
+		NVGjob* job = &ctx->jobs[i];
+		ctx->cache = job->cache;
+		ctx->commands = job->commands;
+		ctx->ncommands = job->ncommands;
+		if (job->type == NVG_JOB_FILL)
+			nvg__fill(ctx, &job->paint, job->compositeOperation, &job->scissor, job->fringe, job->tessellate);
+		else
+			nvg__stroke(ctx, &job->paint, job->compositeOperation, &job->scissor, job->strokeWidth, job->fringe,
+						job->lineCap, job->lineJoin, job->miterLimit, 1);
+	}
+
+	ctx->cache = cache;
+	ctx->commands = commands;
+	ctx->ncommands = ncommands;
+	ctx->njobs = 0;
+}
+
+void nvgSetWorkers(NVGcontext* ctx, const NVGworkers* workers)
+{
+	nvg__flushJobs(ctx);
+
+	memset(&ctx->workers, 0, sizeof(ctx->workers));
+	fonsSetRasterizer(ctx->fs, NULL, NULL);
+
+	if (workers == NULL || workers->parallelFor == NULL || workers->count < 1)
+		return;
+
+	fonsSetRasterizer(ctx->fs, workers->async, workers->userPtr);
+	ctx->workers = *workers;
+}
 
 // Draw
 void nvgBeginPath(NVGcontext* ctx)
@@ -2224,30 +3025,37 @@ void nvgDebugDumpPathCache(NVGcontext* ctx)
 void nvgFill(NVGcontext* ctx)
 {
 	NVGstate* state = nvg__getState(ctx);
-	const NVGpath* path;
 	NVGpaint fillPaint = state->fill;
-	int i;
+	float fringe = (ctx->params.edgeAntiAlias && state->shapeAntiAlias) ? ctx->fringeWidth : 0.0f;
+	NVGjob* job;
 
-	nvg__flattenPaths(ctx);
-	if (ctx->params.edgeAntiAlias && state->shapeAntiAlias)
-		nvg__expandFill(ctx, ctx->fringeWidth, NVG_MITER, 2.4f);
-	else
-		nvg__expandFill(ctx, 0.0f, NVG_MITER, 2.4f);
+	// Skip tessellating paths clipped away by the scissor, the fringe reaches 1.5 fringe widths out.
+	if (nvg__pathOutsideScissor(ctx, ctx->fringeWidth*2.0f))
+		return;
 
 	// Apply global alpha
 	fillPaint.innerColor.a *= state->alpha;
 	fillPaint.outerColor.a *= state->alpha;
 
-	ctx->params.renderFill(ctx->params.userPtr, &fillPaint, state->compositeOperation, &state->scissor, ctx->fringeWidth,
-						   ctx->cache->bounds, ctx->cache->paths, ctx->cache->npaths);
-
-	// Count triangles
-	for (i = 0; i < ctx->cache->npaths; i++) {
-		path = &ctx->cache->paths[i];
-		ctx->fillTriCount += path->nfill-2;
-		ctx->fillTriCount += path->nstroke-2;
-		ctx->drawCallCount += 2;
+	job = nvg__allocJob(ctx, NVG_JOB_FILL);
+	if (job != NULL) {
+		float commands[NVG_GEOMCACHE_MAX_COMMANDS];
+		float ox, oy;
+		unsigned int hash;
+		int hit;
+		job->paint = fillPaint;
+		job->compositeOperation = state->compositeOperation;
+		job->scissor = state->scissor;
+		job->fringe = fringe;
+		// Likely restored from the geometry cache, if not it is tessellated when rendered.
+		nvg__geomCacheFind(ctx, commands, fringe, &ox, &oy, &hash, &hit);
+		job->tessellate = !hit;
+		return;
 	}
+
+	// Keep submission order if recording failed.
+	nvg__flushJobs(ctx);
+	nvg__fill(ctx, &fillPaint, state->compositeOperation, &state->scissor, fringe, 0);
 }
 
 void nvgStroke(NVGcontext* ctx)
@@ -2255,10 +3063,9 @@ void nvgStroke(NVGcontext* ctx)
 	NVGstate* state = nvg__getState(ctx);
 	float scale = nvg__getAverageScale(state->xform);
 	float strokeWidth = nvg__clampf(state->strokeWidth * scale, 0.0f, 200.0f);
+	float fringe = (ctx->params.edgeAntiAlias && state->shapeAntiAlias) ? ctx->fringeWidth : 0.0f;
 	NVGpaint strokePaint = state->stroke;
-	const NVGpath* path;
-	int i;
-
+	NVGjob* job;
 
 	if (strokeWidth < ctx->fringeWidth) {
 		// If the stroke width is less than pixel size, use alpha to emulate coverage.
@@ -2269,26 +3076,83 @@ void nvgStroke(NVGcontext* ctx)
 		strokeWidth = ctx->fringeWidth;
 	}
 
+	// Skip tessellating paths clipped away by the scissor, miter joins reach furthest out.
+	if (nvg__pathOutsideScissor(ctx, strokeWidth*0.5f*nvg__maxf(state->miterLimit, 1.5f) + ctx->fringeWidth*2.0f))
+		return;
+
 	// Apply global alpha
 	strokePaint.innerColor.a *= state->alpha;
 	strokePaint.outerColor.a *= state->alpha;
 
-	nvg__flattenPaths(ctx);
+	job = nvg__allocJob(ctx, NVG_JOB_STROKE);
+	if (job != NULL) {
+		job->paint = strokePaint;
+		job->compositeOperation = state->compositeOperation;
+		job->scissor = state->scissor;
+		job->fringe = fringe;
+		job->strokeWidth = strokeWidth;
+		job->lineCap = state->lineCap;
+		job->lineJoin = state->lineJoin;
+		job->miterLimit = state->miterLimit;
+		return;
+	}
 
-	if (ctx->params.edgeAntiAlias && state->shapeAntiAlias)
-		nvg__expandStroke(ctx, strokeWidth*0.5f, ctx->fringeWidth, state->lineCap, state->lineJoin, state->miterLimit);
-	else
-		nvg__expandStroke(ctx, strokeWidth*0.5f, 0.0f, state->lineCap, state->lineJoin, state->miterLimit);
+	// Keep submission order if recording failed.
+	nvg__flushJobs(ctx);
+	nvg__stroke(ctx, &strokePaint, state->compositeOperation, &state->scissor, strokeWidth, fringe,
+				state->lineCap, state->lineJoin, state->miterLimit, 0);
+}
 
-	ctx->params.renderStroke(ctx->params.userPtr, &strokePaint, state->compositeOperation, &state->scissor, ctx->fringeWidth,
-							 strokeWidth, ctx->cache->paths, ctx->cache->npaths);
+static int nvg__isPixelAligned(float a, float ratio)
+{
+	a *= ratio;
+	return a == floorf(a);
+}
 
-	// Count triangles
-	for (i = 0; i < ctx->cache->npaths; i++) {
-		path = &ctx->cache->paths[i];
-		ctx->strokeTriCount += path->nstroke-2;
-		ctx->drawCallCount++;
+void nvgFillRect(NVGcontext* ctx, float x, float y, float w, float h)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGpaint fillPaint = state->fill;
+	const float* t = state->xform;
+	float rect[4], tmp;
+
+	// Rotated and skewed rects, or back-ends without rect support take the path route.
+	if (ctx->params.renderFillRect == NULL || t[1] != 0.0f || t[2] != 0.0f)
+		goto path;
+
+	nvgTransformPoint(&rect[0], &rect[1], t, x, y);
+	nvgTransformPoint(&rect[2], &rect[3], t, x+w, y+h);
+	if (rect[0] > rect[2]) { tmp = rect[0]; rect[0] = rect[2]; rect[2] = tmp; }
+	if (rect[1] > rect[3]) { tmp = rect[1]; rect[1] = rect[3]; rect[3] = tmp; }
+
+	// Edges off the pixel grid need the anti-aliasing fringe.
+	if (ctx->params.edgeAntiAlias && state->shapeAntiAlias) {
+		if (!nvg__isPixelAligned(rect[0], ctx->devicePxRatio) || !nvg__isPixelAligned(rect[1], ctx->devicePxRatio) ||
+			!nvg__isPixelAligned(rect[2], ctx->devicePxRatio) || !nvg__isPixelAligned(rect[3], ctx->devicePxRatio))
+			goto path;
 	}
+
+	nvgBeginPath(ctx);
+
+	// Nothing to cover.
+	if (rect[0] == rect[2] || rect[1] == rect[3] || nvg__outsideScissor(ctx, rect))
+		return;
+
+	// Apply global alpha
+	fillPaint.innerColor.a *= state->alpha;
+	fillPaint.outerColor.a *= state->alpha;
+
+	nvg__flushJobs(ctx);
+	ctx->params.renderFillRect(ctx->params.userPtr, &fillPaint, state->compositeOperation, &state->scissor, ctx->fringeWidth, rect);
+
+	ctx->fillTriCount += 2;
+	ctx->drawCallCount++;
+	return;
+
+path:
+	nvgBeginPath(ctx);
+	nvgRect(ctx, x, y, w, h);
+	nvgFill(ctx);
 }
 
 // Add fonts
@@ -2319,9 +3183,18 @@ int nvgFindFont(NVGcontext* ctx, const char* name)
 }
 
 
+// Fallbacks change which font a glyph comes from, all runs have to be laid out again.
+static void nvg__clearTextRuns(NVGcontext* ctx)
+{
+	int i;
+	for (i = 0; i < NVG_TEXTCACHE_SIZE; i++)
+		ctx->textRuns[i].lastUsed = 0;
+}
+
 int nvgAddFallbackFontId(NVGcontext* ctx, int baseFont, int fallbackFont)
 {
 	if(baseFont == -1 || fallbackFont == -1) return 0;
+	nvg__clearTextRuns(ctx);
 	return fonsAddFallbackFont(ctx->fs, baseFont, fallbackFont);
 }
 
@@ -2332,6 +3205,7 @@ int nvgAddFallbackFont(NVGcontext* ctx, const char* baseFont, const char* fallba
 
 void nvgResetFallbackFontsId(NVGcontext* ctx, int baseFont)
 {
+	nvg__clearTextRuns(ctx);
 	fonsResetFallbackFont(ctx->fs, baseFont);
 }
 
@@ -2340,6 +3214,37 @@ void nvgResetFallbackFonts(NVGcontext* ctx, const char* baseFont)
 	nvgResetFallbackFontsId(ctx, nvgFindFont(ctx, baseFont));
 }
 
+int nvgSaveFontAtlas(NVGcontext* ctx, const char* path)
+{
+	return fonsSaveAtlas(ctx->fs, path);
+}
+
+int nvgLoadFontAtlas(NVGcontext* ctx, const char* path)
+{
+	int fontImage = ctx->fontImages[ctx->fontImageIdx];
+	int w = 0, h = 0, iw = 0, ih = 0;
+
+	if (fontImage == 0 || !fonsLoadAtlas(ctx->fs, path))
+		return 0;
+	ctx->atlasGen++;
+
+	// The atlas may have been saved after it grew, the font texture has to match it.
+	fonsGetAtlasSize(ctx->fs, &w, &h);
+	nvgImageSize(ctx, fontImage, &iw, &ih);
+	if (iw != w || ih != h) {
+		int image = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, w, h, nvg__fontImageFlags(ctx), NULL);
+		if (image == 0) {
+			fonsResetAtlas(ctx->fs, iw, ih);
+			return 0;
+		}
+		nvgDeleteImage(ctx, fontImage);
+		ctx->fontImages[ctx->fontImageIdx] = image;
+	}
+
+	// The glyphs are uploaded with the next text draw.
+	return 1;
+}
+
 // State setting
 void nvgFontSize(NVGcontext* ctx, float size)
 {
@@ -2429,10 +3334,11 @@ static int nvg__allocTextAtlas(NVGcontext* ctx)
 			iw *= 2;
 		if (iw > NVG_MAX_FONTIMAGE_SIZE || ih > NVG_MAX_FONTIMAGE_SIZE)
 			iw = ih = NVG_MAX_FONTIMAGE_SIZE;
-		ctx->fontImages[ctx->fontImageIdx+1] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, iw, ih, 0, NULL);
+		ctx->fontImages[ctx->fontImageIdx+1] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, iw, ih, nvg__fontImageFlags(ctx), NULL);
 	}
 	++ctx->fontImageIdx;
 	fonsResetAtlas(ctx->fs, iw, ih);
+	ctx->atlasGen++;
 	return 1;
 }
 
@@ -2448,28 +3354,116 @@ static void nvg__renderText(NVGcontext* ctx, NVGvertex* verts, int nverts)
 	paint.innerColor.a *= state->alpha;
 	paint.outerColor.a *= state->alpha;
 
+	nvg__flushJobs(ctx);
 	ctx->params.renderTriangles(ctx->params.userPtr, &paint, state->compositeOperation, &state->scissor, verts, nverts, ctx->fringeWidth);
 
 	ctx->drawCallCount++;
 	ctx->textTriCount += nverts/3;
 }
 
+// Returns the cached run of the string in the current text state, or a slot to store it in.
+// x and y are the position in font pixels. NULL if the string is too long to be cached.
+static NVGtextRun* nvg__findTextRun(NVGcontext* ctx, float x, float y, float scale, const char* string, const char* end)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGtextRun* run = NULL;
+	float fracx = x - floorf(x), fracy = y - floorf(y);
+	float size = state->fontSize*scale, spacing = state->letterSpacing*scale, blur = state->fontBlur*scale;
+	unsigned int hash = 2166136261u;
+	int i, len = (int)(end - string);
+
+	if (len > NVG_TEXTCACHE_MAX_CHARS)
+		return NULL;
+
+	// FNV-1a over the bytes.
+	for (i = 0; i < len; i++)
+		hash = (hash ^ (unsigned char)string[i]) * 16777619u;
+
+	ctx->textRunTick++;
+	for (i = 0; i < NVG_TEXTCACHE_SIZE; i++) {
+		NVGtextRun* r = &ctx->textRuns[i];
+		if (r->lastUsed != 0 && r->hash == hash && r->len == len && r->fontId == state->fontId &&
+			r->align == state->textAlign && r->size == size && r->spacing == spacing && r->blur == blur &&
+			r->fracx == fracx && r->fracy == fracy && memcmp(r->string, string, len) == 0) {
+			r->lastUsed = ctx->textRunTick;
+			return r;
+		}
+		if (run == NULL || r->lastUsed < run->lastUsed)
+			run = r;
+	}
+
+	// Evict the least recently used run.
+	run->hash = hash;
+	memcpy(run->string, string, len);
+	run->len = len;
+	run->fontId = state->fontId;
+	run->align = state->textAlign;
+	run->size = size;
+	run->spacing = spacing;
+	run->blur = blur;
+	run->fracx = fracx;
+	run->fracy = fracy;
+	run->lastUsed = ctx->textRunTick;
+	run->hasBounds = 0;
+	run->nquads = -1;
+	return run;
+}
+
+// Transforms a glyph quad in font pixels and writes its two triangles.
+static void nvg__textQuadVerts(NVGstate* state, NVGvertex* verts, const FONSquad* q, float invscale)
+{
+	float c[4*2];
+	// Transform corners.
+	nvgTransformPoint(&c[0],&c[1], state->xform, q->x0*invscale, q->y0*invscale);
+	nvgTransformPoint(&c[2],&c[3], state->xform, q->x1*invscale, q->y0*invscale);
+	nvgTransformPoint(&c[4],&c[5], state->xform, q->x1*invscale, q->y1*invscale);
+	nvgTransformPoint(&c[6],&c[7], state->xform, q->x0*invscale, q->y1*invscale);
+	// Create triangles
+	nvg__vset(&verts[0], c[0], c[1], q->s0, q->t0);
+	nvg__vset(&verts[1], c[4], c[5], q->s1, q->t1);
+	nvg__vset(&verts[2], c[2], c[3], q->s1, q->t0);
+	nvg__vset(&verts[3], c[0], c[1], q->s0, q->t0);
+	nvg__vset(&verts[4], c[6], c[7], q->s0, q->t1);
+	nvg__vset(&verts[5], c[4], c[5], q->s1, q->t1);
+}
+
 float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char* end)
 {
 	NVGstate* state = nvg__getState(ctx);
 	FONStextIter iter, prevIter;
 	FONSquad q;
 	NVGvertex* verts;
+	NVGtextRun* run;
 	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
 	float invscale = 1.0f / scale;
+	float ox = floorf(x*scale), oy = floorf(y*scale);
+	int atlasGen = ctx->atlasGen;
 	int cverts = 0;
 	int nverts = 0;
+	int nquads = 0;
+	int i;
 
 	if (end == NULL)
 		end = string + strlen(string);
 
 	if (state->fontId == FONS_INVALID) return x;
 
+	run = nvg__findTextRun(ctx, x*scale, y*scale, scale, string, end);
+	if (run != NULL && run->nquads >= 0 && run->atlasGen == ctx->atlasGen) {
+		verts = nvg__allocTempVerts(ctx->cache, nvg__maxi(1, run->nquads) * 6);
+		if (verts == NULL) return x;
+		for (i = 0; i < run->nquads; i++) {
+			q = run->quads[i];
+			q.x0 += ox; q.y0 += oy;
+			q.x1 += ox; q.y1 += oy;
+			nvg__textQuadVerts(state, &verts[nverts], &q, invscale);
+			nverts += 6;
+		}
+		nvg__flushTextTexture(ctx);
+		nvg__renderText(ctx, verts, nverts);
+		return (run->nextx + ox) / scale;
+	}
+
 	fonsSetSize(ctx->fs, state->fontSize*scale);
 	fonsSetSpacing(ctx->fs, state->letterSpacing*scale);
 	fonsSetBlur(ctx->fs, state->fontBlur*scale);
@@ -2477,40 +3471,59 @@ float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char*
 	fonsSetFont(ctx->fs, state->fontId);
 
 	cverts = nvg__maxi(2, (int)(end - string)) * 6; // conservative estimate.
-	verts = nvg__allocTempVerts(ctx, cverts);
+	verts = nvg__allocTempVerts(ctx->cache, cverts);
 	if (verts == NULL) return x;
 
-	fonsTextIterInit(ctx->fs, &iter, x*scale, y*scale, string, end, FONS_GLYPH_BITMAP_REQUIRED);
+	// Every glyph takes at least one byte.
+	if (run != NULL && (int)(end - string) > run->cquads) {
+		int cquads = nvg__maxi(16, (int)(end - string));
+		FONSquad* quads = (FONSquad*)realloc(run->quads, sizeof(FONSquad)*cquads);
+		if (quads != NULL) {
+			run->quads = quads;
+			run->cquads = cquads;
+		} else {
+			run = NULL;
+		}
+	}
+
+	if (!fonsTextIterInit(ctx->fs, &iter, x*scale, y*scale, string, end, FONS_GLYPH_BITMAP_REQUIRED))
+		run = NULL;
 	prevIter = iter;
 	while (fonsTextIterNext(ctx->fs, &iter, &q)) {
-		float c[4*2];
 		if (iter.prevGlyphIndex == -1) { // can not retrieve glyph?
 			if (nverts != 0) {
 				nvg__renderText(ctx, verts, nverts);
 				nverts = 0;
 			}
-			if (!nvg__allocTextAtlas(ctx))
+			if (!nvg__allocTextAtlas(ctx)) {
+				nquads = -1;
 				break; // no memory :(
+			}
 			iter = prevIter;
 			fonsTextIterNext(ctx->fs, &iter, &q); // try again
-			if (iter.prevGlyphIndex == -1) // still can not find glyph?
+			if (iter.prevGlyphIndex == -1) { // still can not find glyph?
+				nquads = -1;
 				break;
+			}
 		}
 		prevIter = iter;
-		// Transform corners.
-		nvgTransformPoint(&c[0],&c[1], state->xform, q.x0*invscale, q.y0*invscale);
-		nvgTransformPoint(&c[2],&c[3], state->xform, q.x1*invscale, q.y0*invscale);
-		nvgTransformPoint(&c[4],&c[5], state->xform, q.x1*invscale, q.y1*invscale);
-		nvgTransformPoint(&c[6],&c[7], state->xform, q.x0*invscale, q.y1*invscale);
-		// Create triangles
 		if (nverts+6 <= cverts) {
-			nvg__vset(&verts[nverts], c[0], c[1], q.s0, q.t0); nverts++;
-			nvg__vset(&verts[nverts], c[4], c[5], q.s1, q.t1); nverts++;
-			nvg__vset(&verts[nverts], c[2], c[3], q.s1, q.t0); nverts++;
-			nvg__vset(&verts[nverts], c[0], c[1], q.s0, q.t0); nverts++;
-			nvg__vset(&verts[nverts], c[6], c[7], q.s0, q.t1); nverts++;
-			nvg__vset(&verts[nverts], c[4], c[5], q.s1, q.t1); nverts++;
+			nvg__textQuadVerts(state, &verts[nverts], &q, invscale);
+			nverts += 6;
 		}
+		if (run != NULL && nquads >= 0) {
+			FONSquad* rq = &run->quads[nquads++];
+			*rq = q;
+			rq->x0 -= ox; rq->y0 -= oy;
+			rq->x1 -= ox; rq->y1 -= oy;
+		}
+	}
+
+	// Runs split across two atlases are laid out again next time.
+	if (run != NULL && nquads >= 0 && ctx->atlasGen == atlasGen) {
+		run->nquads = nquads;
+		run->atlasGen = atlasGen;
+		run->nextx = iter.nextx - ox;
 	}
 
 	// TODO: add back-end bit to do this just once per frame.
@@ -2813,26 +3826,51 @@ int nvgTextBreakLines(NVGcontext* ctx, const char* string, const char* end, floa
 float nvgTextBounds(NVGcontext* ctx, float x, float y, const char* string, const char* end, float* bounds)
 {
 	NVGstate* state = nvg__getState(ctx);
+	NVGtextRun* run;
 	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
 	float invscale = 1.0f / scale;
+	float ox = floorf(x*scale), oy = floorf(y*scale);
+	float b[4];
 	float width;
 
 	if (state->fontId == FONS_INVALID) return 0;
 
+	if (end == NULL)
+		end = string + strlen(string);
+
 	fonsSetSize(ctx->fs, state->fontSize*scale);
 	fonsSetSpacing(ctx->fs, state->letterSpacing*scale);
 	fonsSetBlur(ctx->fs, state->fontBlur*scale);
 	fonsSetAlign(ctx->fs, state->textAlign);
 	fonsSetFont(ctx->fs, state->fontId);
 
-	width = fonsTextBounds(ctx->fs, x*scale, y*scale, string, end, bounds);
+	run = nvg__findTextRun(ctx, x*scale, y*scale, scale, string, end);
+	if (run != NULL && run->hasBounds) {
+		width = run->width;
+		b[0] = run->bounds[0] + ox;
+		b[1] = run->bounds[1] + oy;
+		b[2] = run->bounds[2] + ox;
+		b[3] = run->bounds[3] + oy;
+	} else {
+		b[0] = b[2] = x*scale;
+		b[1] = b[3] = y*scale;
+		width = fonsTextBounds(ctx->fs, x*scale, y*scale, string, end, b);
+		if (run != NULL) {
+			run->hasBounds = 1;
+			run->width = width;
+			run->bounds[0] = b[0] - ox;
+			run->bounds[1] = b[1] - oy;
+			run->bounds[2] = b[2] - ox;
+			run->bounds[3] = b[3] - oy;
+		}
+	}
 	if (bounds != NULL) {
 		// Use line bounds for height.
-		fonsLineBounds(ctx->fs, y*scale, &bounds[1], &bounds[3]);
-		bounds[0] *= invscale;
-		bounds[1] *= invscale;
-		bounds[2] *= invscale;
-		bounds[3] *= invscale;
+		fonsLineBounds(ctx->fs, y*scale, &b[1], &b[3]);
+		bounds[0] = b[0] * invscale;
+		bounds[1] = b[1] * invscale;
+		bounds[2] = b[2] * invscale;
+		bounds[3] = b[3] * invscale;
 	}
 	return width * invscale;
 }
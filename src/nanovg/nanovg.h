@@ -142,6 +142,7 @@ enum NVGimageFlags {
 	NVG_IMAGE_FLIPY				= 1<<3,		// Flips (inverses) image in Y direction when rendered.
 	NVG_IMAGE_PREMULTIPLIED		= 1<<4,		// Image data has premultiplied alpha.
 	NVG_IMAGE_NEAREST			= 1<<5,		// Image interpolation is Nearest instead Linear
+	NVG_IMAGE_SDF				= 1<<6,		// Alpha image holds signed distances, 0.5 being the edge, see NVGparams::sdfText.
 };
 
 // Begin drawing a new frame
@@ -160,6 +161,31 @@ void nvgCancelFrame(NVGcontext* ctx);
 // Ends drawing flushing remaining render state.
 void nvgEndFrame(NVGcontext* ctx);
 
+//
+// Deferred tessellation
+//
+// With a worker pool set, nvgFill() and nvgStroke() only record the path and its render state.
+// The recorded calls are tessellated in parallel on the workers and handed to the back-end in
+// submission order before the next text or nvgFillRect() draw, and at nvgEndFrame().
+// The output is the same as when tessellating on the calling thread.
+
+struct NVGworkers {
+	void* userPtr;
+	// Number of workers, the worker index passed to func is below this.
+	int count;
+	// Runs func(arg, index, worker) for every index in [0..n) and returns when all have finished.
+	void (*parallelFor)(void* uptr, int n, void (*func)(void* arg, int index, int worker), void* arg);
+	// Optional, runs func(arg) on a thread other than the calling one and returns without waiting.
+	// New glyphs are then rasterized in the background and drawn empty until their bitmap is done,
+	// usually for a frame or two.
+	void (*async)(void* uptr, void (*func)(void* arg), void* arg);
+};
+typedef struct NVGworkers NVGworkers;
+
+// Sets the worker pool used for deferred tessellation and glyph rasterization, pass NULL to do both immediately.
+// The pool must stay valid until it is replaced or the context is deleted.
+void nvgSetWorkers(NVGcontext* ctx, const NVGworkers* workers);
+
 //
 // Composite operation
 //
@@ -375,6 +401,10 @@ int nvgCreateImage(NVGcontext* ctx, const char* filename, int imageFlags);
 // Returns handle to the image.
 int nvgCreateImageMem(NVGcontext* ctx, int imageFlags, const unsigned char* data, int ndata);
 
+// Frees the memory the calling thread decodes images in, kept from one nvgCreateImageMem() to the next.
+// Call it when a thread is done loading images.
+void nvgFreeImageArena(void);
+
 // Creates image from specified image data.
 // Returns handle to the image.
 int nvgCreateImageRGBA(NVGcontext* ctx, int w, int h, int imageFlags, const unsigned char* data);
@@ -508,6 +538,12 @@ void nvgFill(NVGcontext* ctx);
 // Fills the current path with current stroke style.
 void nvgStroke(NVGcontext* ctx);
 
+// Fills an axis-aligned rectangle with current fill style, same as nvgBeginPath(), nvgRect() and nvgFill().
+// When the rectangle is not rotated or skewed and its edges lie on the pixel grid (or anti-aliasing is off),
+// the quad is handed to the back-end directly, skipping tessellation and the anti-aliasing fringe.
+// Like nvgBeginPath(), this clears the current path.
+void nvgFillRect(NVGcontext* ctx, float x, float y, float w, float h);
+
 
 //
 // Text
@@ -571,6 +607,14 @@ void nvgResetFallbackFontsId(NVGcontext* ctx, int baseFont);
 // Resets fallback fonts by name.
 void nvgResetFallbackFonts(NVGcontext* ctx, const char* baseFont);
 
+// Saves the font atlas and its rasterized glyphs to a file, so a later run can skip rasterizing them.
+// Returns 1 on success.
+int nvgSaveFontAtlas(NVGcontext* ctx, const char* path);
+
+// Restores a font atlas saved by nvgSaveFontAtlas(), call it once the fonts and their fallbacks are created.
+// Glyphs of fonts whose data changed are dropped and rasterized again. Returns 1 on success.
+int nvgLoadFontAtlas(NVGcontext* ctx, const char* path);
+
 // Sets the font size of current text style.
 void nvgFontSize(NVGcontext* ctx, float size);
 
@@ -654,6 +698,7 @@ struct NVGpath {
 	int nstroke;
 	int winding;
 	int convex;
+	int triangulated;	// fill is a triangle list and stroke a half fringe, see NVGparams::triangulateFills.
 };
 typedef struct NVGpath NVGpath;
 
@@ -662,6 +707,10 @@ struct NVGparams {
 	int edgeAntiAlias;
 	int (*renderCreate)(void* uptr);
 	int (*renderCreateTexture)(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data);
+	// Optional, returns memory to decode the tightly packed pixels of a new texture into, or NULL. Passed as the data of
+	// the next renderCreateTexture() call, it is not copied again. The memory is only valid until that call.
+	// A non-NULL return is always followed by that call on the same thread, the back-end may hold the memory back from the GPU meanwhile.
+	unsigned char* (*renderMapTexture)(void* uptr, int type, int w, int h);
 	int (*renderDeleteTexture)(void* uptr, int image);
 	int (*renderUpdateTexture)(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data);
 	int (*renderGetTextureSize)(void* uptr, int image, int* w, int* h);
@@ -671,6 +720,12 @@ struct NVGparams {
 	void (*renderFill)(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe, const float* bounds, const NVGpath* paths, int npaths);
 	void (*renderStroke)(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe, float strokeWidth, const NVGpath* paths, int npaths);
 	void (*renderTriangles)(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, const NVGvertex* verts, int nverts, float fringe);
+	// Optional, rect is [minx,miny,maxx,maxy] in window space and needs no anti-aliasing.
+	void (*renderFillRect)(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe, const float* rect);
+	// Set if renderFill() accepts small concave fills as a triangle list instead of stenciling them.
+	int triangulateFills;
+	// Set if the back-end renders NVG_IMAGE_SDF textures, text then uses one distance field glyph for all sizes.
+	int sdfText;
 	void (*renderDelete)(void* uptr);
 };
 typedef struct NVGparams NVGparams;
@@ -0,0 +1,317 @@
+#pragma once
+
+// Back-end that draws nothing and counts what a frame asks of the renderer.
+//
+// With rasterization out of the way, the time between nvgBeginFrame() and nvgEndFrame()
+// is the cost of the nanovg front-end alone: path tessellation, text layout and glyph
+// rasterization. The counters let a host benchmark hold a frame to a budget:
+//
+//   NVGcontext* vg = nvgCreateNull(NVGNULL_ANTIALIAS | NVGNULL_STENCIL_STROKES);
+//   ... draw a frame ...
+//   const NVGnullStats* stats = nvgNullStats(vg);
+//   assert(stats->calls <= 40);
+//
+// Like the nvgSw functions, nvgNullStats() reads the back-end from the context parameters
+// and cannot be used while nvgTraceBegin() has wrapped them.
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "nanovg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum NVGnullCreateFlags {
+    // Same meaning as for the deko3d back-end, changes the geometry and uniforms nanovg produces.
+    NVGNULL_ANTIALIAS       = 1<<0,
+    NVGNULL_STENCIL_STROKES = 1<<1,
+    NVGNULL_SDF_TEXT        = 1<<2,
+};
+
+// Size of one fragment uniform block in the deko3d back-end, DKNVGfragUniforms rounded to 16 bytes.
+#define NVGNULL_UNIFORM_SIZE 176
+
+// Counters of one frame, from nvgBeginFrame() to nvgEndFrame().
+struct NVGnullStats {
+    int frame;
+    double cpuTime;     // Seconds of process CPU time spent building the frame.
+    int calls;          // Fill, stroke, triangle and rect calls.
+    int fills;          // Stenciled fills.
+    int convexFills;    // Convex and triangulated fills, drawn without the stencil.
+    int strokes;
+    int triangles;      // Triangle calls, mostly text.
+    int rects;
+    int paths;
+    int verts;
+    int uniformBytes;   // Fragment uniforms as allocated by the deko3d back-end.
+    int uploads;        // Texture creations and updates.
+    int uploadBytes;
+    int imageChanges;   // Calls binding a different texture than the previous call.
+    int blendChanges;   // Calls with a different composite operation than the previous call.
+    int scissorChanges; // Calls with a different scissor than the previous call.
+};
+typedef struct NVGnullStats NVGnullStats;
+
+struct NVGnullTexture {
+    int id;
+    int type;
+    int width;
+    int height;
+};
+typedef struct NVGnullTexture NVGnullTexture;
+
+struct NVGnullContext {
+    int flags;
+    NVGnullStats current;
+    NVGnullStats last;
+    clock_t frameStart;
+    // State of the previous call, to count the changes a GPU back-end would have to bind.
+    int image;
+    NVGcompositeOperationState blend;
+    NVGscissor scissor;
+    NVGnullTexture* textures;
+    int ntextures;
+    int ctextures;
+    int textureId;
+};
+typedef struct NVGnullContext NVGnullContext;
+
+static NVGnullTexture* nvgnull__findTexture(NVGnullContext* null, int id) {
+    int i;
+    for (i = 0; i < null->ntextures; i++) {
+        if (null->textures[i].id == id) return &null->textures[i];
+    }
+    return NULL;
+}
+
+static int nvgnull__texelSize(int type) {
+    return type == NVG_TEXTURE_RGBA ? 4 : 1;
+}
+
+static void nvgnull__resetFrame(NVGnullContext* null) {
+    int frame = null->current.frame;
+    memset(&null->current, 0, sizeof(null->current));
+    null->current.frame = frame;
+    // The first call of a frame always binds its state.
+    null->image = -1;
+    memset(&null->blend, 0xff, sizeof(null->blend));
+    memset(&null->scissor, 0xff, sizeof(null->scissor));
+    null->frameStart = clock();
+}
+
+static void nvgnull__countCall(NVGnullContext* null, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+                               int uniforms) {
+    NVGnullStats* stats = &null->current;
+    stats->calls++;
+    stats->uniformBytes += uniforms * NVGNULL_UNIFORM_SIZE;
+    if (paint->image != null->image) stats->imageChanges++;
+    if (memcmp(&compositeOperation, &null->blend, sizeof(null->blend)) != 0) stats->blendChanges++;
+    if (memcmp(scissor, &null->scissor, sizeof(null->scissor)) != 0) stats->scissorChanges++;
+    null->image = paint->image;
+    null->blend = compositeOperation;
+    null->scissor = *scissor;
+}
+
+static void nvgnull__countPaths(NVGnullContext* null, const NVGpath* paths, int npaths, int fill) {
+    int i;
+    null->current.paths += npaths;
+    for (i = 0; i < npaths; i++) {
+        if (fill) null->current.verts += paths[i].nfill;
+        null->current.verts += paths[i].nstroke;
+    }
+}
+
+static int nvgnull__renderCreate(void* uptr) {
+    (void)uptr;
+    return 1;
+}
+
+static int nvgnull__renderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data) {
+    NVGnullContext* null = (NVGnullContext*)uptr;
+    NVGnullTexture* tex;
+    (void)imageFlags;
+
+    if (null->ntextures + 1 > null->ctextures) {
+        int ctextures = null->ctextures > 0 ? null->ctextures * 2 : 16;
+        NVGnullTexture* textures = (NVGnullTexture*)realloc(null->textures, sizeof(NVGnullTexture) * ctextures);
+        if (textures == NULL) return 0;
+        null->textures = textures;
+        null->ctextures = ctextures;
+    }
+
+    tex = &null->textures[null->ntextures++];
+    tex->id = ++null->textureId;
+    tex->type = type;
+    tex->width = w;
+    tex->height = h;
+
+    if (data != NULL) {
+        null->current.uploads++;
+        null->current.uploadBytes += w * h * nvgnull__texelSize(type);
+    }
+    return tex->id;
+}
+
+static int nvgnull__renderDeleteTexture(void* uptr, int image) {
+    NVGnullContext* null = (NVGnullContext*)uptr;
+    NVGnullTexture* tex = nvgnull__findTexture(null, image);
+    if (tex == NULL) return 0;
+    *tex = null->textures[--null->ntextures];
+    return 1;
+}
+
+static int nvgnull__renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data) {
+    NVGnullContext* null = (NVGnullContext*)uptr;
+    NVGnullTexture* tex = nvgnull__findTexture(null, image);
+    (void)x;
+    (void)y;
+    (void)data;
+
+    if (tex == NULL) return 0;
+    // The deko3d back-end stages the dirty rectangle alone.
+    null->current.uploads++;
+    null->current.uploadBytes += w * h * nvgnull__texelSize(tex->type);
+    return 1;
+}
+
+static int nvgnull__renderGetTextureSize(void* uptr, int image, int* w, int* h) {
+    NVGnullContext* null = (NVGnullContext*)uptr;
+    NVGnullTexture* tex = nvgnull__findTexture(null, image);
+    if (tex == NULL) return 0;
+    *w = tex->width;
+    *h = tex->height;
+    return 1;
+}
+
+static void nvgnull__renderViewport(void* uptr, float width, float height, float devicePixelRatio) {
+    (void)width;
+    (void)height;
+    (void)devicePixelRatio;
+    nvgnull__resetFrame((NVGnullContext*)uptr);
+}
+
+static void nvgnull__renderCancel(void* uptr) {
+    nvgnull__resetFrame((NVGnullContext*)uptr);
+}
+
+static void nvgnull__renderFlush(void* uptr) {
+    NVGnullContext* null = (NVGnullContext*)uptr;
+    null->current.cpuTime = (double)(clock() - null->frameStart) / CLOCKS_PER_SEC;
+    null->last = null->current;
+    null->current.frame++;
+    nvgnull__resetFrame(null);
+}
+
+static void nvgnull__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+                                const float* bounds, const NVGpath* paths, int npaths) {
+    NVGnullContext* null = (NVGnullContext*)uptr;
+    (void)fringe;
+    (void)bounds;
+
+    if (npaths == 1 && (paths[0].convex || paths[0].triangulated)) {
+        null->current.convexFills++;
+        nvgnull__countCall(null, paint, compositeOperation, scissor, 1);
+    } else {
+        // Plus the bounding box quad of the cover pass.
+        null->current.fills++;
+        null->current.verts += 4;
+        nvgnull__countCall(null, paint, compositeOperation, scissor, 2);
+    }
+    nvgnull__countPaths(null, paths, npaths, 1);
+}
+
+static void nvgnull__renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+                                  float strokeWidth, const NVGpath* paths, int npaths) {
+    NVGnullContext* null = (NVGnullContext*)uptr;
+    (void)fringe;
+    (void)strokeWidth;
+
+    null->current.strokes++;
+    nvgnull__countCall(null, paint, compositeOperation, scissor, null->flags & NVGNULL_STENCIL_STROKES ? 2 : 1);
+    nvgnull__countPaths(null, paths, npaths, 0);
+}
+
+static void nvgnull__renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+                                     const NVGvertex* verts, int nverts, float fringe) {
+    NVGnullContext* null = (NVGnullContext*)uptr;
+    (void)verts;
+    (void)fringe;
+
+    null->current.triangles++;
+    null->current.verts += nverts;
+    nvgnull__countCall(null, paint, compositeOperation, scissor, 1);
+}
+
+static void nvgnull__renderFillRect(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+                                    const float* rect) {
+    NVGnullContext* null = (NVGnullContext*)uptr;
+    (void)fringe;
+    (void)rect;
+
+    null->current.rects++;
+    null->current.verts += 6;
+    nvgnull__countCall(null, paint, compositeOperation, scissor, 1);
+}
+
+static void nvgnull__renderDelete(void* uptr) {
+    NVGnullContext* null = (NVGnullContext*)uptr;
+    if (null == NULL) return;
+    free(null->textures);
+    free(null);
+}
+
+NVGcontext* nvgCreateNull(int flags) {
+    NVGparams params;
+    NVGcontext* ctx = NULL;
+    NVGnullContext* null = (NVGnullContext*)malloc(sizeof(NVGnullContext));
+    if (null == NULL) goto error;
+    memset(null, 0, sizeof(NVGnullContext));
+    null->flags = flags;
+    nvgnull__resetFrame(null);
+
+    memset(&params, 0, sizeof(params));
+    params.renderCreate = nvgnull__renderCreate;
+    params.renderCreateTexture = nvgnull__renderCreateTexture;
+    params.renderDeleteTexture = nvgnull__renderDeleteTexture;
+    params.renderUpdateTexture = nvgnull__renderUpdateTexture;
+    params.renderGetTextureSize = nvgnull__renderGetTextureSize;
+    params.renderViewport = nvgnull__renderViewport;
+    params.renderCancel = nvgnull__renderCancel;
+    params.renderFlush = nvgnull__renderFlush;
+    params.renderFill = nvgnull__renderFill;
+    params.renderStroke = nvgnull__renderStroke;
+    params.renderTriangles = nvgnull__renderTriangles;
+    params.renderFillRect = nvgnull__renderFillRect;
+    // Same front-end work as with the deko3d back-end.
+    params.triangulateFills = 1;
+    params.sdfText = flags & NVGNULL_SDF_TEXT ? 1 : 0;
+    params.renderDelete = nvgnull__renderDelete;
+    params.userPtr = null;
+    params.edgeAntiAlias = flags & NVGNULL_ANTIALIAS ? 1 : 0;
+
+    ctx = nvgCreateInternal(&params);
+    if (ctx == NULL) goto error;
+
+    return ctx;
+
+error:
+    // 'null' is freed by nvgDeleteInternal.
+    if (ctx != NULL) nvgDeleteInternal(ctx);
+    return NULL;
+}
+
+void nvgDeleteNull(NVGcontext* ctx) {
+    nvgDeleteInternal(ctx);
+}
+
+// Returns the counters of the last frame ended with nvgEndFrame().
+const NVGnullStats* nvgNullStats(NVGcontext* ctx) {
+    return &((NVGnullContext*)nvgInternalParams(ctx)->userPtr)->last;
+}
+
+#ifdef __cplusplus
+}
+#endif
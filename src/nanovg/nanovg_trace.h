@@ -0,0 +1,635 @@
+#pragma once
+
+// Records the render back-end calls of a nanovg context to a binary trace,
+// and replays such a trace into any back-end to profile it on a host.
+//
+// Recording wraps the NVGparams of a live context, so it works with every back-end:
+//
+//   nvgTraceBegin(vg, "sdmc:/frames.nvgtrace");
+//   ... frames ...
+//   nvgTraceEnd(vg); // or let nvgDelete*() close the trace
+//
+// Textures created before nvgTraceBegin() are unknown to the trace, the ones
+// nanovg updates later (the font atlas) are recorded as alpha textures on first use.
+// Traces store raw little-endian structs, they are portable between the Switch and x86-64/arm64 hosts.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "nanovg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NVGTRACE_MAGIC "NVGT"
+#define NVGTRACE_VERSION 1
+
+enum NVGtraceOp {
+    NVGTRACE_VIEWPORT = 1,
+    NVGTRACE_CANCEL,
+    NVGTRACE_FLUSH,
+    NVGTRACE_CREATE_TEXTURE,
+    NVGTRACE_DELETE_TEXTURE,
+    NVGTRACE_UPDATE_TEXTURE,
+    NVGTRACE_FILL,
+    NVGTRACE_STROKE,
+    NVGTRACE_TRIANGLES,
+    NVGTRACE_FILL_RECT,
+};
+
+// Per path header, followed by the fill and stroke vertices.
+struct NVGtracePath {
+    int nfill;
+    int nstroke;
+    int count;
+    int nbevel;
+    int winding;
+    int convex;
+    int triangulated;
+    int closed;
+};
+typedef struct NVGtracePath NVGtracePath;
+
+struct NVGtraceTexture {
+    int image;
+    int type;
+    int width;
+    int height;
+    int replayImage;        // Replay only, id of the texture in the replaying back-end.
+    unsigned char* data;    // Replay only, updates address the whole image like in nanovg.
+};
+typedef struct NVGtraceTexture NVGtraceTexture;
+
+struct NVGtrace {
+    NVGparams inner;
+    FILE* fp;
+    NVGtraceTexture* textures;
+    int ntextures;
+    int ctextures;
+};
+typedef struct NVGtrace NVGtrace;
+
+// Statistics of one replayed frame, reported at every flush.
+struct NVGtraceFrame {
+    int frame;
+    double cpuTime;     // Seconds of process CPU time spent in the back-end, worker threads included.
+    double wallTime;    // Seconds of wall time spent in the back-end.
+    int calls;          // Fill, stroke, triangle and rect calls.
+    int paths;
+    int verts;
+    int uniforms;       // Fragment uniforms as allocated by the deko3d back-end without stencil strokes.
+    int uploads;        // Bytes of texture data created or updated.
+};
+typedef struct NVGtraceFrame NVGtraceFrame;
+
+static int nvgtrace__texelSize(int type) {
+    return type == NVG_TEXTURE_RGBA ? 4 : 1;
+}
+
+static NVGtraceTexture* nvgtrace__findTexture(NVGtraceTexture* textures, int ntextures, int image) {
+    int i;
+    for (i = 0; i < ntextures; i++) {
+        if (textures[i].image == image) return &textures[i];
+    }
+    return NULL;
+}
+
+static NVGtraceTexture* nvgtrace__addTexture(NVGtraceTexture** textures, int* ntextures, int* ctextures, int image) {
+    NVGtraceTexture* tex;
+    if (*ntextures + 1 > *ctextures) {
+        int ctex = *ctextures ? *ctextures * 2 : 16;
+        NVGtraceTexture* buf = (NVGtraceTexture*)realloc(*textures, sizeof(NVGtraceTexture) * ctex);
+        if (buf == NULL) return NULL;
+        *textures = buf;
+        *ctextures = ctex;
+    }
+    tex = &(*textures)[(*ntextures)++];
+    memset(tex, 0, sizeof(*tex));
+    tex->image = image;
+    return tex;
+}
+
+static void nvgtrace__removeTexture(NVGtraceTexture* textures, int* ntextures, int image) {
+    NVGtraceTexture* tex = nvgtrace__findTexture(textures, *ntextures, image);
+    if (tex == NULL) return;
+    free(tex->data);
+    *tex = textures[--(*ntextures)];
+}
+
+static void nvgtrace__write(NVGtrace* trace, const void* data, size_t size) {
+    if (trace->fp != NULL && size > 0) fwrite(data, 1, size, trace->fp);
+}
+
+static void nvgtrace__writeOp(NVGtrace* trace, int op) {
+    unsigned char b = (unsigned char)op;
+    nvgtrace__write(trace, &b, 1);
+}
+
+static void nvgtrace__writeInt(NVGtrace* trace, int v) {
+    nvgtrace__write(trace, &v, sizeof(v));
+}
+
+static void nvgtrace__writeFloat(NVGtrace* trace, float v) {
+    nvgtrace__write(trace, &v, sizeof(v));
+}
+
+static void nvgtrace__writeState(NVGtrace* trace, int op, NVGpaint* paint, NVGcompositeOperationState compositeOperation,
+                                 NVGscissor* scissor, float fringe) {
+    nvgtrace__writeOp(trace, op);
+    nvgtrace__write(trace, paint, sizeof(*paint));
+    nvgtrace__write(trace, &compositeOperation, sizeof(compositeOperation));
+    nvgtrace__write(trace, scissor, sizeof(*scissor));
+    nvgtrace__writeFloat(trace, fringe);
+}
+
+static void nvgtrace__writePaths(NVGtrace* trace, const NVGpath* paths, int npaths) {
+    int i;
+    nvgtrace__writeInt(trace, npaths);
+    for (i = 0; i < npaths; i++) {
+        const NVGpath* path = &paths[i];
+        NVGtracePath info;
+        info.nfill = path->nfill;
+        info.nstroke = path->nstroke;
+        info.count = path->count;
+        info.nbevel = path->nbevel;
+        info.winding = path->winding;
+        info.convex = path->convex;
+        info.triangulated = path->triangulated;
+        info.closed = path->closed;
+        nvgtrace__write(trace, &info, sizeof(info));
+        nvgtrace__write(trace, path->fill, sizeof(NVGvertex) * path->nfill);
+        nvgtrace__write(trace, path->stroke, sizeof(NVGvertex) * path->nstroke);
+    }
+}
+
+// Records a texture the trace has not seen created, so replay can update it.
+static NVGtraceTexture* nvgtrace__adoptTexture(NVGtrace* trace, int image) {
+    NVGtraceTexture* tex = nvgtrace__findTexture(trace->textures, trace->ntextures, image);
+    int w = 0, h = 0;
+    unsigned char hasData = 0;
+
+    if (tex != NULL) return tex;
+    if (trace->inner.renderGetTextureSize(trace->inner.userPtr, image, &w, &h) == 0) return NULL;
+
+    tex = nvgtrace__addTexture(&trace->textures, &trace->ntextures, &trace->ctextures, image);
+    if (tex == NULL) return NULL;
+    tex->type = NVG_TEXTURE_ALPHA;
+    tex->width = w;
+    tex->height = h;
+
+    nvgtrace__writeOp(trace, NVGTRACE_CREATE_TEXTURE);
+    nvgtrace__writeInt(trace, image);
+    nvgtrace__writeInt(trace, tex->type);
+    nvgtrace__writeInt(trace, w);
+    nvgtrace__writeInt(trace, h);
+    nvgtrace__writeInt(trace, 0);
+    nvgtrace__write(trace, &hasData, 1);
+    return tex;
+}
+
+static int nvgtrace__renderCreate(void* uptr) {
+    NVGtrace* trace = (NVGtrace*)uptr;
+    return trace->inner.renderCreate(trace->inner.userPtr);
+}
+
+static int nvgtrace__renderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data) {
+    NVGtrace* trace = (NVGtrace*)uptr;
+    int image = trace->inner.renderCreateTexture(trace->inner.userPtr, type, w, h, imageFlags, data);
+    NVGtraceTexture* tex;
+    unsigned char hasData = data != NULL;
+
+    if (image == 0) return 0;
+    tex = nvgtrace__addTexture(&trace->textures, &trace->ntextures, &trace->ctextures, image);
+    if (tex == NULL) return image;
+    tex->type = type;
+    tex->width = w;
+    tex->height = h;
+
+    nvgtrace__writeOp(trace, NVGTRACE_CREATE_TEXTURE);
+    nvgtrace__writeInt(trace, image);
+    nvgtrace__writeInt(trace, type);
+    nvgtrace__writeInt(trace, w);
+    nvgtrace__writeInt(trace, h);
+    nvgtrace__writeInt(trace, imageFlags);
+    nvgtrace__write(trace, &hasData, 1);
+    if (hasData) nvgtrace__write(trace, data, (size_t)w * h * nvgtrace__texelSize(type));
+    return image;
+}
+
+static unsigned char* nvgtrace__renderMapTexture(void* uptr, int type, int w, int h) {
+    NVGtrace* trace = (NVGtrace*)uptr;
+    // The mapped pixels reach renderCreateTexture() and are recorded there.
+    return trace->inner.renderMapTexture(trace->inner.userPtr, type, w, h);
+}
+
+static int nvgtrace__renderDeleteTexture(void* uptr, int image) {
+    NVGtrace* trace = (NVGtrace*)uptr;
+    nvgtrace__removeTexture(trace->textures, &trace->ntextures, image);
+    nvgtrace__writeOp(trace, NVGTRACE_DELETE_TEXTURE);
+    nvgtrace__writeInt(trace, image);
+    return trace->inner.renderDeleteTexture(trace->inner.userPtr, image);
+}
+
+static int nvgtrace__renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data) {
+    NVGtrace* trace = (NVGtrace*)uptr;
+    NVGtraceTexture* tex = nvgtrace__adoptTexture(trace, image);
+
+    if (tex != NULL && y >= 0 && h >= 0 && y + h <= tex->height) {
+        // Whole rows are stored, the same rows the deko3d back-end uploads.
+        size_t stride = (size_t)tex->width * nvgtrace__texelSize(tex->type);
+        nvgtrace__writeOp(trace, NVGTRACE_UPDATE_TEXTURE);
+        nvgtrace__writeInt(trace, image);
+        nvgtrace__writeInt(trace, x);
+        nvgtrace__writeInt(trace, y);
+        nvgtrace__writeInt(trace, w);
+        nvgtrace__writeInt(trace, h);
+        nvgtrace__write(trace, data + stride * y, stride * h);
+    }
+    return trace->inner.renderUpdateTexture(trace->inner.userPtr, image, x, y, w, h, data);
+}
+
+static int nvgtrace__renderGetTextureSize(void* uptr, int image, int* w, int* h) {
+    NVGtrace* trace = (NVGtrace*)uptr;
+    return trace->inner.renderGetTextureSize(trace->inner.userPtr, image, w, h);
+}
+
+static void nvgtrace__renderViewport(void* uptr, float width, float height, float devicePixelRatio) {
+    NVGtrace* trace = (NVGtrace*)uptr;
+    nvgtrace__writeOp(trace, NVGTRACE_VIEWPORT);
+    nvgtrace__writeFloat(trace, width);
+    nvgtrace__writeFloat(trace, height);
+    nvgtrace__writeFloat(trace, devicePixelRatio);
+    trace->inner.renderViewport(trace->inner.userPtr, width, height, devicePixelRatio);
+}
+
+static void nvgtrace__renderCancel(void* uptr) {
+    NVGtrace* trace = (NVGtrace*)uptr;
+    nvgtrace__writeOp(trace, NVGTRACE_CANCEL);
+    trace->inner.renderCancel(trace->inner.userPtr);
+}
+
+static void nvgtrace__renderFlush(void* uptr) {
+    NVGtrace* trace = (NVGtrace*)uptr;
+    nvgtrace__writeOp(trace, NVGTRACE_FLUSH);
+    trace->inner.renderFlush(trace->inner.userPtr);
+}
+
+static void nvgtrace__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+                                 const float* bounds, const NVGpath* paths, int npaths) {
+    NVGtrace* trace = (NVGtrace*)uptr;
+    nvgtrace__writeState(trace, NVGTRACE_FILL, paint, compositeOperation, scissor, fringe);
+    nvgtrace__write(trace, bounds, sizeof(float) * 4);
+    nvgtrace__writePaths(trace, paths, npaths);
+    trace->inner.renderFill(trace->inner.userPtr, paint, compositeOperation, scissor, fringe, bounds, paths, npaths);
+}
+
+static void nvgtrace__renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+                                   float strokeWidth, const NVGpath* paths, int npaths) {
+    NVGtrace* trace = (NVGtrace*)uptr;
+    nvgtrace__writeState(trace, NVGTRACE_STROKE, paint, compositeOperation, scissor, fringe);
+    nvgtrace__writeFloat(trace, strokeWidth);
+    nvgtrace__writePaths(trace, paths, npaths);
+    trace->inner.renderStroke(trace->inner.userPtr, paint, compositeOperation, scissor, fringe, strokeWidth, paths, npaths);
+}
+
+static void nvgtrace__renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+                                      const NVGvertex* verts, int nverts, float fringe) {
+    NVGtrace* trace = (NVGtrace*)uptr;
+    nvgtrace__writeState(trace, NVGTRACE_TRIANGLES, paint, compositeOperation, scissor, fringe);
+    nvgtrace__writeInt(trace, nverts);
+    nvgtrace__write(trace, verts, sizeof(NVGvertex) * nverts);
+    trace->inner.renderTriangles(trace->inner.userPtr, paint, compositeOperation, scissor, verts, nverts, fringe);
+}
+
+static void nvgtrace__renderFillRect(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+                                     const float* rect) {
+    NVGtrace* trace = (NVGtrace*)uptr;
+    nvgtrace__writeState(trace, NVGTRACE_FILL_RECT, paint, compositeOperation, scissor, fringe);
+    nvgtrace__write(trace, rect, sizeof(float) * 4);
+    trace->inner.renderFillRect(trace->inner.userPtr, paint, compositeOperation, scissor, fringe, rect);
+}
+
+static void nvgtrace__close(NVGtrace* trace) {
+    int i;
+    if (trace->fp != NULL) fclose(trace->fp);
+    for (i = 0; i < trace->ntextures; i++) free(trace->textures[i].data);
+    free(trace->textures);
+    free(trace);
+}
+
+static void nvgtrace__renderDelete(void* uptr) {
+    NVGtrace* trace = (NVGtrace*)uptr;
+    if (trace->inner.renderDelete != NULL) trace->inner.renderDelete(trace->inner.userPtr);
+    nvgtrace__close(trace);
+}
+
+// Starts recording every back-end call of ctx to the file at path. Returns 1 on success.
+int nvgTraceBegin(NVGcontext* ctx, const char* path) {
+    NVGparams* params = nvgInternalParams(ctx);
+    NVGtrace* trace;
+    int version = NVGTRACE_VERSION;
+
+    if (params->renderDelete == nvgtrace__renderDelete) return 0;
+
+    trace = (NVGtrace*)malloc(sizeof(NVGtrace));
+    if (trace == NULL) return 0;
+    memset(trace, 0, sizeof(NVGtrace));
+
+    trace->fp = fopen(path, "wb");
+    if (trace->fp == NULL) {
+        free(trace);
+        return 0;
+    }
+    // Frames write many small records.
+    setvbuf(trace->fp, NULL, _IOFBF, 256 * 1024);
+
+    nvgtrace__write(trace, NVGTRACE_MAGIC, 4);
+    nvgtrace__writeInt(trace, version);
+    nvgtrace__writeInt(trace, params->edgeAntiAlias);
+
+    trace->inner = *params;
+    params->userPtr = trace;
+    params->renderCreate = nvgtrace__renderCreate;
+    params->renderCreateTexture = nvgtrace__renderCreateTexture;
+    params->renderMapTexture = trace->inner.renderMapTexture != NULL ? nvgtrace__renderMapTexture : NULL;
+    params->renderDeleteTexture = nvgtrace__renderDeleteTexture;
+    params->renderUpdateTexture = nvgtrace__renderUpdateTexture;
+    params->renderGetTextureSize = nvgtrace__renderGetTextureSize;
+    params->renderViewport = nvgtrace__renderViewport;
+    params->renderCancel = nvgtrace__renderCancel;
+    params->renderFlush = nvgtrace__renderFlush;
+    params->renderFill = nvgtrace__renderFill;
+    params->renderStroke = nvgtrace__renderStroke;
+    params->renderTriangles = nvgtrace__renderTriangles;
+    params->renderFillRect = trace->inner.renderFillRect != NULL ? nvgtrace__renderFillRect : NULL;
+    params->renderDelete = nvgtrace__renderDelete;
+    return 1;
+}
+
+// Stops recording and hands ctx back to its back-end.
+void nvgTraceEnd(NVGcontext* ctx) {
+    NVGparams* params = nvgInternalParams(ctx);
+    NVGtrace* trace;
+
+    if (params->renderDelete != nvgtrace__renderDelete) return;
+    trace = (NVGtrace*)params->userPtr;
+    *params = trace->inner;
+    nvgtrace__close(trace);
+}
+
+static int nvgtrace__read(FILE* fp, void* data, size_t size) {
+    return size == 0 || fread(data, 1, size, fp) == size;
+}
+
+static void* nvgtrace__readArray(FILE* fp, void** buf, int* cap, int n, size_t size) {
+    if (n < 0) return NULL;
+    if (n > *cap) {
+        void* mem = realloc(*buf, size * n);
+        if (mem == NULL) return NULL;
+        *buf = mem;
+        *cap = n;
+    }
+    return nvgtrace__read(fp, *buf, size * n) ? *buf : NULL;
+}
+
+static double nvgtrace__wallTime(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Maps image ids of the trace to the ones the replaying back-end created.
+static int nvgtrace__mapImage(NVGtraceTexture* textures, int ntextures, int image) {
+    NVGtraceTexture* tex = nvgtrace__findTexture(textures, ntextures, image);
+    return tex != NULL ? tex->replayImage : 0;
+}
+
+static int nvgtrace__readPaths(FILE* fp, NVGpath** paths, int* cpaths, NVGvertex** verts, int* cverts, NVGtraceFrame* frame) {
+    NVGtracePath info;
+    int i, npaths, nverts = 0;
+
+    if (!nvgtrace__read(fp, &npaths, sizeof(int)) || npaths < 0) return -1;
+    if (npaths > *cpaths) {
+        NVGpath* buf = (NVGpath*)realloc(*paths, sizeof(NVGpath) * npaths);
+        if (buf == NULL) return -1;
+        *paths = buf;
+        *cpaths = npaths;
+    }
+
+    // Vertices of all paths go into one buffer, which can move while it grows,
+    // so the pointers are set up once everything is read.
+    for (i = 0; i < npaths; i++) {
+        NVGpath* path = &(*paths)[i];
+        if (!nvgtrace__read(fp, &info, sizeof(info)) || info.nfill < 0 || info.nstroke < 0) return -1;
+        if (nverts + info.nfill + info.nstroke > *cverts) {
+            int cap = (nverts + info.nfill + info.nstroke) * 2;
+            NVGvertex* buf = (NVGvertex*)realloc(*verts, sizeof(NVGvertex) * cap);
+            if (buf == NULL) return -1;
+            *verts = buf;
+            *cverts = cap;
+        }
+        if (!nvgtrace__read(fp, *verts + nverts, sizeof(NVGvertex) * (info.nfill + info.nstroke))) return -1;
+
+        memset(path, 0, sizeof(*path));
+        path->count = info.count;
+        path->closed = (unsigned char)info.closed;
+        path->nbevel = info.nbevel;
+        path->nfill = info.nfill;
+        path->nstroke = info.nstroke;
+        path->winding = info.winding;
+        path->convex = info.convex;
+        path->triangulated = info.triangulated;
+        nverts += info.nfill + info.nstroke;
+    }
+
+    nverts = 0;
+    for (i = 0; i < npaths; i++) {
+        NVGpath* path = &(*paths)[i];
+        path->fill = path->nfill > 0 ? *verts + nverts : NULL;
+        path->stroke = path->nstroke > 0 ? *verts + nverts + path->nfill : NULL;
+        nverts += path->nfill + path->nstroke;
+    }
+
+    frame->paths += npaths;
+    frame->verts += nverts;
+    return npaths;
+}
+
+// Replays the trace at path into the back-end behind params, frameDone is called after every flush.
+// Returns the number of frames replayed, or -1 if the trace could not be read.
+int nvgTraceReplay(const char* path, NVGparams* params, void (*frameDone)(void* uptr, const NVGtraceFrame* frame), void* uptr) {
+    FILE* fp = fopen(path, "rb");
+    NVGtraceTexture* textures = NULL;
+    int ntextures = 0, ctextures = 0;
+    NVGpath* paths = NULL;
+    int cpaths = 0;
+    NVGvertex* verts = NULL;
+    int cverts = 0;
+    NVGtraceFrame frame;
+    char magic[4];
+    int i, version = 0, edgeAntiAlias = 0, ok = 0;
+    clock_t cpuStart;
+    double wallStart;
+
+    if (fp == NULL) return -1;
+    if (!nvgtrace__read(fp, magic, 4) || memcmp(magic, NVGTRACE_MAGIC, 4) != 0 ||
+        !nvgtrace__read(fp, &version, sizeof(int)) || version != NVGTRACE_VERSION ||
+        !nvgtrace__read(fp, &edgeAntiAlias, sizeof(int))) {
+        fclose(fp);
+        return -1;
+    }
+
+    memset(&frame, 0, sizeof(frame));
+    cpuStart = clock();
+    wallStart = nvgtrace__wallTime();
+
+    while (1) {
+        unsigned char op;
+        NVGpaint paint;
+        NVGcompositeOperationState compositeOperation;
+        NVGscissor scissor;
+        float fringe, values[4];
+        int n, args[6];
+
+        if (!nvgtrace__read(fp, &op, 1)) {
+            ok = feof(fp);
+            break;
+        }
+
+        // Draw calls share their leading state.
+        if (op >= NVGTRACE_FILL) {
+            if (!nvgtrace__read(fp, &paint, sizeof(paint)) ||
+                !nvgtrace__read(fp, &compositeOperation, sizeof(compositeOperation)) ||
+                !nvgtrace__read(fp, &scissor, sizeof(scissor)) ||
+                !nvgtrace__read(fp, &fringe, sizeof(fringe))) break;
+            paint.image = nvgtrace__mapImage(textures, ntextures, paint.image);
+            frame.calls++;
+        }
+
+        if (op == NVGTRACE_VIEWPORT) {
+            if (!nvgtrace__read(fp, values, sizeof(float) * 3)) break;
+            params->renderViewport(params->userPtr, values[0], values[1], values[2]);
+        } else if (op == NVGTRACE_CANCEL) {
+            params->renderCancel(params->userPtr);
+            n = frame.frame;
+            memset(&frame, 0, sizeof(frame));
+            frame.frame = n;
+            cpuStart = clock();
+            wallStart = nvgtrace__wallTime();
+        } else if (op == NVGTRACE_FLUSH) {
+            params->renderFlush(params->userPtr);
+            frame.cpuTime = (double)(clock() - cpuStart) / CLOCKS_PER_SEC;
+            frame.wallTime = nvgtrace__wallTime() - wallStart;
+            if (frameDone != NULL) frameDone(uptr, &frame);
+            n = frame.frame + 1;
+            memset(&frame, 0, sizeof(frame));
+            frame.frame = n;
+            cpuStart = clock();
+            wallStart = nvgtrace__wallTime();
+        } else if (op == NVGTRACE_CREATE_TEXTURE) {
+            NVGtraceTexture* tex;
+            unsigned char hasData;
+            size_t size;
+            if (!nvgtrace__read(fp, args, sizeof(int) * 5) || !nvgtrace__read(fp, &hasData, 1)) break;
+            if (args[2] <= 0 || args[3] <= 0) break;
+            tex = nvgtrace__addTexture(&textures, &ntextures, &ctextures, args[0]);
+            if (tex == NULL) break;
+            tex->type = args[1];
+            tex->width = args[2];
+            tex->height = args[3];
+            size = (size_t)tex->width * tex->height * nvgtrace__texelSize(tex->type);
+            tex->data = (unsigned char*)calloc(size, 1);
+            if (tex->data == NULL) break;
+            if (hasData) {
+                if (!nvgtrace__read(fp, tex->data, size)) break;
+                frame.uploads += (int)size;
+            }
+            tex->replayImage = params->renderCreateTexture(params->userPtr, tex->type, tex->width, tex->height, args[4],
+                                                           hasData ? tex->data : NULL);
+        } else if (op == NVGTRACE_DELETE_TEXTURE) {
+            NVGtraceTexture* tex;
+            if (!nvgtrace__read(fp, args, sizeof(int))) break;
+            tex = nvgtrace__findTexture(textures, ntextures, args[0]);
+            if (tex != NULL && tex->replayImage != 0) params->renderDeleteTexture(params->userPtr, tex->replayImage);
+            nvgtrace__removeTexture(textures, &ntextures, args[0]);
+        } else if (op == NVGTRACE_UPDATE_TEXTURE) {
+            NVGtraceTexture* tex;
+            size_t stride;
+            if (!nvgtrace__read(fp, args, sizeof(int) * 5)) break;
+            tex = nvgtrace__findTexture(textures, ntextures, args[0]);
+            if (tex == NULL || args[2] < 0 || args[4] < 0 || args[2] + args[4] > tex->height) break;
+            stride = (size_t)tex->width * nvgtrace__texelSize(tex->type);
+            if (!nvgtrace__read(fp, tex->data + stride * args[2], stride * args[4])) break;
+            frame.uploads += (int)(stride * args[4]);
+            if (tex->replayImage != 0)
+                params->renderUpdateTexture(params->userPtr, tex->replayImage, args[1], args[2], args[3], args[4], tex->data);
+        } else if (op == NVGTRACE_FILL) {
+            if (!nvgtrace__read(fp, values, sizeof(float) * 4)) break;
+            n = nvgtrace__readPaths(fp, &paths, &cpaths, &verts, &cverts, &frame);
+            if (n < 0) break;
+            // Stencil fills take a second uniform for the stencil pass.
+            if (!(n == 1 && (paths[0].convex || paths[0].triangulated))) frame.uniforms++;
+            frame.uniforms++;
+            params->renderFill(params->userPtr, &paint, compositeOperation, &scissor, fringe, values, paths, n);
+        } else if (op == NVGTRACE_STROKE) {
+            if (!nvgtrace__read(fp, values, sizeof(float))) break;
+            n = nvgtrace__readPaths(fp, &paths, &cpaths, &verts, &cverts, &frame);
+            if (n < 0) break;
+            frame.uniforms++;
+            params->renderStroke(params->userPtr, &paint, compositeOperation, &scissor, fringe, values[0], paths, n);
+        } else if (op == NVGTRACE_TRIANGLES) {
+            if (!nvgtrace__read(fp, &n, sizeof(int))) break;
+            if (nvgtrace__readArray(fp, (void**)&verts, &cverts, n, sizeof(NVGvertex)) == NULL) break;
+            frame.verts += n;
+            frame.uniforms++;
+            params->renderTriangles(params->userPtr, &paint, compositeOperation, &scissor, verts, n, fringe);
+        } else if (op == NVGTRACE_FILL_RECT) {
+            if (!nvgtrace__read(fp, values, sizeof(float) * 4)) break;
+            frame.verts += 6;
+            frame.uniforms++;
+            // Back-ends without the rect fast path get it as a convex fill, which draws with the
+            // same shader as nvgFillRect() does on them. The rect is pixel aligned and needs no fringe.
+            if (params->renderFillRect != NULL) {
+                params->renderFillRect(params->userPtr, &paint, compositeOperation, &scissor, fringe, values);
+            } else {
+                NVGvertex quad[4];
+                NVGpath rect;
+                const float xs[4] = { values[0], values[0], values[2], values[2] };
+                const float ys[4] = { values[1], values[3], values[3], values[1] };
+                for (n = 0; n < 4; n++) {
+                    quad[n].x = xs[n];
+                    quad[n].y = ys[n];
+                    quad[n].u = 0.5f;
+                    quad[n].v = 1.0f;
+                }
+                memset(&rect, 0, sizeof(rect));
+                rect.count = 4;
+                rect.closed = 1;
+                rect.fill = quad;
+                rect.nfill = 4;
+                rect.winding = NVG_CCW;
+                rect.convex = 1;
+                params->renderFill(params->userPtr, &paint, compositeOperation, &scissor, fringe, values, &rect, 1);
+            }
+        } else {
+            break;
+        }
+    }
+
+    for (i = 0; i < ntextures; i++) {
+        if (textures[i].replayImage != 0) params->renderDeleteTexture(params->userPtr, textures[i].replayImage);
+        free(textures[i].data);
+    }
+    free(textures);
+    free(paths);
+    free(verts);
+    fclose(fp);
+    return ok ? frame.frame : -1;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -392,6 +392,12 @@ typedef struct
 STBIDEF stbi_uc *stbi_load_from_memory   (stbi_uc           const *buffer, int len   , int *x, int *y, int *channels_in_file, int desired_channels);
 STBIDEF stbi_uc *stbi_load_from_callbacks(stbi_io_callbacks const *clbk  , void *user, int *x, int *y, int *channels_in_file, int desired_channels);
 
+// Same as stbi_load_from_memory, but the pixels go to memory returned by alloc(alloc_user, x, y, desired_channels)
+// instead of a buffer from STBI_MALLOC; alloc may return NULL to fail the load. Returns that memory, which the
+// caller owns, or NULL. desired_channels must not be 0. JPEG decodes straight into it, other formats are copied.
+STBIDEF stbi_uc *stbi_load_from_memory_into(stbi_uc const *buffer, int len, int *x, int *y, int *channels_in_file, int desired_channels,
+                                            stbi_uc *(*alloc)(void *alloc_user, int x, int y, int comp), void *alloc_user);
+
 #ifndef STBI_NO_STDIO
 STBIDEF stbi_uc *stbi_load            (char const *filename, int *x, int *y, int *channels_in_file, int desired_channels);
 STBIDEF stbi_uc *stbi_load_from_file  (FILE *f, int *x, int *y, int *channels_in_file, int desired_channels);
@@ -781,6 +787,11 @@ typedef struct
 
    stbi_uc *img_buffer, *img_buffer_end;
    stbi_uc *img_buffer_original, *img_buffer_original_end;
+
+   // output memory from stbi_load_from_memory_into
+   stbi_uc *(*alloc_out)(void *user, int x, int y, int comp);
+   void *alloc_out_user;
+   int out_allocated;
 } stbi__context;
 
 
@@ -794,6 +805,8 @@ static void stbi__start_mem(stbi__context *s, stbi_uc const *buffer, int len)
    s->callback_already_read = 0;
    s->img_buffer = s->img_buffer_original = (stbi_uc *) buffer;
    s->img_buffer_end = s->img_buffer_original_end = (stbi_uc *) buffer+len;
+   s->alloc_out = NULL;
+   s->out_allocated = 0;
 }
 
 // initialize a callback-based context
@@ -807,6 +820,8 @@ static void stbi__start_callbacks(stbi__context *s, stbi_io_callbacks *c, void *
    s->img_buffer = s->img_buffer_original = s->buffer_start;
    stbi__refill_buffer(s);
    s->img_buffer_original_end = s->img_buffer_end;
+   s->alloc_out = NULL;
+   s->out_allocated = 0;
 }
 
 #ifndef STBI_NO_STDIO
@@ -1220,6 +1235,17 @@ static unsigned char *stbi__load_and_postprocess_8bit(stbi__context *s, int *x,
       stbi__vertical_flip(result, *x, *y, channels * sizeof(stbi_uc));
    }
 
+   // loaders that did not write to the caller's memory hand over a copy
+   if (s->alloc_out && !s->out_allocated) {
+      stbi_uc *out = s->alloc_out(s->alloc_out_user, *x, *y, req_comp);
+      if (out)
+         memcpy(out, result, (size_t) *x * *y * req_comp);
+      STBI_FREE(result);
+      if (!out)
+         return stbi__errpuc("outofmem", "Out of memory");
+      result = out;
+   }
+
    return (unsigned char *) result;
 }
 
@@ -1373,6 +1399,17 @@ STBIDEF stbi_uc *stbi_load_from_memory(stbi_uc const *buffer, int len, int *x, i
    return stbi__load_and_postprocess_8bit(&s,x,y,comp,req_comp);
 }
 
+STBIDEF stbi_uc *stbi_load_from_memory_into(stbi_uc const *buffer, int len, int *x, int *y, int *comp, int req_comp,
+                                            stbi_uc *(*alloc)(void *alloc_user, int x, int y, int comp), void *alloc_user)
+{
+   stbi__context s;
+   if (req_comp <= 0 || req_comp > 4) return stbi__errpuc("bad req_comp", "Internal error");
+   stbi__start_mem(&s,buffer,len);
+   s.alloc_out = alloc;
+   s.alloc_out_user = alloc_user;
+   return stbi__load_and_postprocess_8bit(&s,x,y,comp,req_comp);
+}
+
 STBIDEF stbi_uc *stbi_load_from_callbacks(stbi_io_callbacks const *clbk, void *user, int *x, int *y, int *comp, int req_comp)
 {
    stbi__context s;
@@ -1872,7 +1909,7 @@ static stbi_uc *stbi__hdr_to_ldr(float   *data, int x, int y, int comp)
 #ifndef STBI_NO_JPEG
 
 // huffman decoding acceleration
-#define FAST_BITS   9  // larger handles more cases; smaller stomps less cache
+#define FAST_BITS   10 // larger handles more cases; smaller stomps less cache. 10 keeps the tables in the A57 L1
 
 typedef struct
 {
@@ -3814,7 +3851,13 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
       }
 
       // can't error after this so, this is safe
-      output = (stbi_uc *) stbi__malloc_mad3(n, z->s->img_x, z->s->img_y, 1);
+      // the 3 channel kernels store a 4th byte past the last pixel, only RGBA is written in place
+      if (z->s->alloc_out && n == 4) {
+         output = z->s->alloc_out(z->s->alloc_out_user, z->s->img_x, z->s->img_y, n);
+         z->s->out_allocated = 1;
+      } else {
+         output = (stbi_uc *) stbi__malloc_mad3(n, z->s->img_x, z->s->img_y, 1);
+      }
       if (!output) { stbi__cleanup_jpeg(z); return stbi__errpuc("outofmem", "Out of memory"); }
 
       // now go ahead and resample
@@ -135,6 +135,11 @@
 //        #define STBTT_RASTERIZER_VERSION 1
 //   which will incur about a 15% speed hit.
 //
+//   The new rasterizer accumulates each scanline with SSE2 or NEON when the
+//   compiler targets them. The running coverage is summed four pixels at a
+//   time, in a different order than the scalar loop, so a pixel can come out
+//   one step apart from it. Define STBTT_NO_SIMD to use the scalar loop.
+//
 // ADDITIONAL DOCUMENTATION
 //
 //   Immediately after this block comment are a series of sample programs.
@@ -1114,6 +1119,16 @@ typedef int stbtt__test_oversample_pow2[(STBTT_MAX_OVERSAMPLE & (STBTT_MAX_OVERS
 #define STBTT_RASTERIZER_VERSION 2
 #endif
 
+#if STBTT_RASTERIZER_VERSION == 2 && !defined(STBTT_NO_SIMD)
+   #if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+      #include <emmintrin.h>
+      #define STBTT__SSE2
+   #elif defined(__ARM_NEON) && defined(__aarch64__)
+      #include <arm_neon.h>
+      #define STBTT__NEON
+   #endif
+#endif
+
 #ifdef _MSC_VER
 #define STBTT__NOTUSED(v)  (void)(v)
 #else
@@ -3236,12 +3251,78 @@ static void stbtt__fill_active_edges_new(float *scanline, float *scanline_fill,
    }
 }
 
+// converts the coverage of one scanline to pixels, scanline2 holds the fill
+// deltas that are summed left to right
+static void stbtt__accumulate_scanline(unsigned char *pixels, const float *scanline, const float *scanline2, int w)
+{
+   float sum = 0;
+   int i = 0;
+#if defined(STBTT__SSE2)
+   {
+      const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+      const __m128 k255 = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f);
+      __m128 carry = _mm_setzero_ps();
+      for (; i + 4 <= w; i += 4) {
+         // prefix sum of four deltas, plus the sum of all before them
+         __m128 d = _mm_loadu_ps(scanline2 + i);
+         __m128i m;
+         int packed;
+         d = _mm_add_ps(d, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(d), 4)));
+         d = _mm_add_ps(d, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(d), 8)));
+         d = _mm_add_ps(d, carry);
+         carry = _mm_shuffle_ps(d, d, _MM_SHUFFLE(3,3,3,3));
+         d = _mm_add_ps(_mm_loadu_ps(scanline + i), d);
+         d = _mm_add_ps(_mm_mul_ps(_mm_and_ps(d, abs_mask), k255), half);
+         // truncate like the cast below, the packs saturate to 255
+         m = _mm_cvttps_epi32(d);
+         m = _mm_packs_epi32(m, m);
+         m = _mm_packus_epi16(m, m);
+         packed = _mm_cvtsi128_si32(m);
+         STBTT_memcpy(pixels + i, &packed, 4);
+      }
+      sum = _mm_cvtss_f32(carry);
+   }
+#elif defined(STBTT__NEON)
+   {
+      const float32x4_t zero = vdupq_n_f32(0), k255 = vdupq_n_f32(255.0f), half = vdupq_n_f32(0.5f);
+      float32x4_t carry = zero;
+      for (; i + 4 <= w; i += 4) {
+         // prefix sum of four deltas, plus the sum of all before them
+         float32x4_t d = vld1q_f32(scanline2 + i);
+         uint8x8_t m;
+         unsigned int packed;
+         d = vaddq_f32(d, vextq_f32(zero, d, 3));
+         d = vaddq_f32(d, vextq_f32(zero, d, 2));
+         d = vaddq_f32(d, carry);
+         carry = vdupq_laneq_f32(d, 3);
+         d = vaddq_f32(vld1q_f32(scanline + i), d);
+         d = vaddq_f32(vmulq_f32(vabsq_f32(d), k255), half);
+         // truncate like the cast below, the narrowing saturates to 255
+         m = vqmovn_u16(vcombine_u16(vqmovn_u32(vcvtq_u32_f32(d)), vdup_n_u16(0)));
+         packed = vget_lane_u32(vreinterpret_u32_u8(m), 0);
+         STBTT_memcpy(pixels + i, &packed, 4);
+      }
+      sum = vgetq_lane_f32(carry, 0);
+   }
+#endif
+   for (; i < w; ++i) {
+      float k;
+      int m;
+      sum += scanline2[i];
+      k = scanline[i] + sum;
+      k = (float) STBTT_fabs(k)*255 + 0.5f;
+      m = (int) k;
+      if (m > 255) m = 255;
+      pixels[i] = (unsigned char) m;
+   }
+}
+
 // directly AA rasterize edges w/o supersampling
 static void stbtt__rasterize_sorted_edges(stbtt__bitmap *result, stbtt__edge *e, int n, int vsubsample, int off_x, int off_y, void *userdata)
 {
    stbtt__hheap hh = { 0, 0, 0 };
    stbtt__active_edge *active = NULL;
-   int y,j=0, i;
+   int y,j=0;
    float scanline_data[129], *scanline, *scanline2;
 
    STBTT__NOTUSED(vsubsample);
@@ -3303,19 +3384,7 @@ static void stbtt__rasterize_sorted_edges(stbtt__bitmap *result, stbtt__edge *e,
       if (active)
          stbtt__fill_active_edges_new(scanline, scanline2+1, result->w, active, scan_y_top);
 
-      {
-         float sum = 0;
-         for (i=0; i < result->w; ++i) {
-            float k;
-            int m;
-            sum += scanline2[i];
-            k = scanline[i] + sum;
-            k = (float) STBTT_fabs(k)*255 + 0.5f;
-            m = (int) k;
-            if (m > 255) m = 255;
-            result->pixels[j*result->stride + i] = (unsigned char) m;
-         }
-      }
+      stbtt__accumulate_scanline(result->pixels + j*result->stride, scanline, scanline2, result->w);
       // advance all the edges
       step = &active;
       while (*step) {
@@ -0,0 +1,1415 @@
+#pragma once
+
+// CPU back-end for nanovg, renders into an in-memory RGBA8 framebuffer.
+//
+// It follows the deko3d back-end call for call: fills are stenciled with the same
+// increment/decrement rules and cover pass, convex fills and strokes draw their strips,
+// and the paints are evaluated like in fill_aa_fsh.glsl. This makes it usable as a
+// golden-image reference for the GPU path, and to time nanovg on hosts without a GPU.
+//
+// Calls are recorded during the frame and rasterized by nvgEndFrame(), one 64x64 tile
+// per task so tiles can be spread over workers. Spans are shaded four pixels at a time
+// with SSE2 or NEON when available.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../nanovg.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    #include <emmintrin.h>
+    #define SWNVG_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    #include <arm_neon.h>
+    #define SWNVG_NEON 1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum NVGswCreateFlags {
+    // Flag indicating if geometry based anti-aliasing is used (may not be needed when using MSAA).
+    NVGSW_ANTIALIAS         = 1<<0,
+    // Flag indicating if strokes should be drawn using stencil buffer, like NVG_STENCIL_STROKES.
+    NVGSW_STENCIL_STROKES   = 1<<1,
+    // Flag indicating that text is drawn from signed distance field glyphs, like NVG_SDF_TEXT.
+    NVGSW_SDF_TEXT          = 1<<2,
+};
+
+// Creates a context that renders into a framebuffer the size of the nvgBeginFrame() window.
+// The nvgSw functions find the back-end through the context parameters, so they cannot be
+// used while nvgTraceBegin() has wrapped them; replay the trace into the back-end instead.
+NVGcontext* nvgCreateSw(int flags);
+void nvgDeleteSw(NVGcontext* ctx);
+
+// Spreads the tiles of each frame over workers, pass NULL to rasterize on the calling thread.
+// The pool must stay valid until it is replaced or the context is deleted.
+void nvgSwSetWorkers(NVGcontext* ctx, const NVGworkers* workers);
+
+// Sets the color nvgBeginFrame() clears the framebuffer to, transparent black by default.
+void nvgSwClearColor(NVGcontext* ctx, NVGcolor color);
+
+// Returns the premultiplied RGBA8 pixels of the last frame, rows are width*4 bytes apart.
+const unsigned char* nvgSwFramebuffer(NVGcontext* ctx, int* width, int* height);
+
+#define SWNVG_TILE_SIZE 64
+
+enum SWNVGshaderType {
+    SWNVG_SHADER_FILLGRAD,
+    SWNVG_SHADER_FILLIMG,
+    SWNVG_SHADER_SIMPLE,
+    SWNVG_SHADER_IMG,
+};
+
+enum SWNVGcallType {
+    SWNVG_NONE = 0,
+    SWNVG_FILL,
+    SWNVG_CONVEXFILL,
+    SWNVG_STROKE,
+    SWNVG_TRIANGLES,
+};
+
+enum SWNVGprimitive {
+    SWNVG_FAN,
+    SWNVG_STRIP,
+    SWNVG_LIST,
+};
+
+enum SWNVGstencilTest {
+    SWNVG_TEST_ALWAYS,
+    SWNVG_TEST_EQUAL,       // Stencil equal to zero.
+    SWNVG_TEST_NOTEQUAL,    // Stencil not zero.
+};
+
+enum SWNVGstencilOp {
+    SWNVG_OP_KEEP,
+    SWNVG_OP_WINDING,       // Wrapping increment on front faces, decrement on back faces.
+    SWNVG_OP_INCR,          // Saturating increment of passing fragments.
+    SWNVG_OP_ZERO,          // Zero on pass and fail.
+};
+
+struct SWNVGtexture {
+    int id;
+    int type;
+    int width;
+    int height;
+    int flags;
+    unsigned char* data;
+};
+typedef struct SWNVGtexture SWNVGtexture;
+
+// Same values as DKNVGfragUniforms, with the matrices kept as nanovg transforms.
+struct SWNVGfragUniforms {
+    float scissorMat[6];
+    float paintMat[6];
+    NVGcolor innerCol;
+    NVGcolor outerCol;
+    float scissorExt[2];
+    float scissorScale[2];
+    float extent[2];
+    float radius;
+    float feather;
+    float strokeMult;
+    float strokeThr;
+    int texType;
+    int type;
+};
+typedef struct SWNVGfragUniforms SWNVGfragUniforms;
+
+struct SWNVGcall {
+    int type;
+    int image;
+    int pathOffset;
+    int pathCount;
+    int triangleOffset;
+    int triangleCount;
+    int uniformOffset;
+    int fillPrimitive;
+    NVGcompositeOperationState blendFunc;
+    int bounds[4]; // Pixels touched by the call, x0, y0, x1, y1 exclusive.
+};
+typedef struct SWNVGcall SWNVGcall;
+
+struct SWNVGpath {
+    int fillOffset;
+    int fillCount;
+    int strokeOffset;
+    int strokeCount;
+};
+typedef struct SWNVGpath SWNVGpath;
+
+struct SWNVGcontext {
+    int flags;
+    float view[2];
+
+    // Framebuffer and stencil, tiles only ever touch their own pixels.
+    uint32_t* pixels;
+    unsigned char* stencil;
+    int width;
+    int height;
+    int cpixels;
+    NVGcolor clearColor;
+
+    SWNVGtexture* textures;
+    int ntextures;
+    int ctextures;
+    int textureId;
+
+    NVGworkers workers;
+
+    // Per frame buffers
+    SWNVGcall* calls;
+    int ccalls;
+    int ncalls;
+    SWNVGpath* paths;
+    int cpaths;
+    int npaths;
+    NVGvertex* verts;
+    int cverts;
+    int nverts;
+    SWNVGfragUniforms* uniforms;
+    int cuniforms;
+    int nuniforms;
+};
+typedef struct SWNVGcontext SWNVGcontext;
+
+// State of one draw, what the deko3d back-end binds before a draw call.
+struct SWNVGpass {
+    const SWNVGfragUniforms* frag;
+    const SWNVGtexture* tex;
+    NVGcompositeOperationState blend;
+    int colorWrite;
+    int cull;
+    int stencilTest;
+    int stencilOp;
+};
+typedef struct SWNVGpass SWNVGpass;
+
+//
+// Four wide float vectors
+//
+
+#if SWNVG_SSE2
+typedef __m128 swnvg_f4;
+static inline swnvg_f4 swnvg__set1(float a) { return _mm_set1_ps(a); }
+static inline swnvg_f4 swnvg__set4(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+static inline swnvg_f4 swnvg__add(swnvg_f4 a, swnvg_f4 b) { return _mm_add_ps(a, b); }
+static inline swnvg_f4 swnvg__sub(swnvg_f4 a, swnvg_f4 b) { return _mm_sub_ps(a, b); }
+static inline swnvg_f4 swnvg__mul(swnvg_f4 a, swnvg_f4 b) { return _mm_mul_ps(a, b); }
+static inline swnvg_f4 swnvg__div(swnvg_f4 a, swnvg_f4 b) { return _mm_div_ps(a, b); }
+static inline swnvg_f4 swnvg__min(swnvg_f4 a, swnvg_f4 b) { return _mm_min_ps(a, b); }
+static inline swnvg_f4 swnvg__max(swnvg_f4 a, swnvg_f4 b) { return _mm_max_ps(a, b); }
+static inline swnvg_f4 swnvg__sqrt(swnvg_f4 a) { return _mm_sqrt_ps(a); }
+static inline swnvg_f4 swnvg__abs(swnvg_f4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+// 1.0 in lanes where a >= b, 0.0 elsewhere.
+static inline swnvg_f4 swnvg__ge(swnvg_f4 a, swnvg_f4 b) { return _mm_and_ps(_mm_cmpge_ps(a, b), _mm_set1_ps(1.0f)); }
+static inline void swnvg__store(float* p, swnvg_f4 a) { _mm_storeu_ps(p, a); }
+static inline swnvg_f4 swnvg__load(const float* p) { return _mm_loadu_ps(p); }
+
+static inline void swnvg__unpack(const uint32_t* px, swnvg_f4* r, swnvg_f4* g, swnvg_f4* b, swnvg_f4* a) {
+    const __m128i p = _mm_loadu_si128((const __m128i*)px);
+    const __m128i m = _mm_set1_epi32(0xff);
+    const __m128 s = _mm_set1_ps(1.0f / 255.0f);
+    *r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(p, m)), s);
+    *g = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 8), m)), s);
+    *b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 16), m)), s);
+    *a = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(p, 24)), s);
+}
+
+static inline __m128i swnvg__quantize(swnvg_f4 c) {
+    c = _mm_min_ps(_mm_max_ps(c, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+}
+
+static inline void swnvg__pack(uint32_t* px, swnvg_f4 r, swnvg_f4 g, swnvg_f4 b, swnvg_f4 a) {
+    __m128i p = swnvg__quantize(r);
+    p = _mm_or_si128(p, _mm_slli_epi32(swnvg__quantize(g), 8));
+    p = _mm_or_si128(p, _mm_slli_epi32(swnvg__quantize(b), 16));
+    p = _mm_or_si128(p, _mm_slli_epi32(swnvg__quantize(a), 24));
+    _mm_storeu_si128((__m128i*)px, p);
+}
+#elif SWNVG_NEON
+typedef float32x4_t swnvg_f4;
+static inline swnvg_f4 swnvg__set1(float a) { return vdupq_n_f32(a); }
+static inline swnvg_f4 swnvg__set4(float a, float b, float c, float d) { const float v[4] = { a, b, c, d }; return vld1q_f32(v); }
+static inline swnvg_f4 swnvg__add(swnvg_f4 a, swnvg_f4 b) { return vaddq_f32(a, b); }
+static inline swnvg_f4 swnvg__sub(swnvg_f4 a, swnvg_f4 b) { return vsubq_f32(a, b); }
+static inline swnvg_f4 swnvg__mul(swnvg_f4 a, swnvg_f4 b) { return vmulq_f32(a, b); }
+static inline swnvg_f4 swnvg__div(swnvg_f4 a, swnvg_f4 b) { return vdivq_f32(a, b); }
+static inline swnvg_f4 swnvg__min(swnvg_f4 a, swnvg_f4 b) { return vminq_f32(a, b); }
+static inline swnvg_f4 swnvg__max(swnvg_f4 a, swnvg_f4 b) { return vmaxq_f32(a, b); }
+static inline swnvg_f4 swnvg__sqrt(swnvg_f4 a) { return vsqrtq_f32(a); }
+static inline swnvg_f4 swnvg__abs(swnvg_f4 a) { return vabsq_f32(a); }
+static inline swnvg_f4 swnvg__ge(swnvg_f4 a, swnvg_f4 b) {
+    return vreinterpretq_f32_u32(vandq_u32(vcgeq_f32(a, b), vreinterpretq_u32_f32(vdupq_n_f32(1.0f))));
+}
+static inline void swnvg__store(float* p, swnvg_f4 a) { vst1q_f32(p, a); }
+static inline swnvg_f4 swnvg__load(const float* p) { return vld1q_f32(p); }
+
+static inline void swnvg__unpack(const uint32_t* px, swnvg_f4* r, swnvg_f4* g, swnvg_f4* b, swnvg_f4* a) {
+    const uint32x4_t p = vld1q_u32(px);
+    const uint32x4_t m = vdupq_n_u32(0xff);
+    const float32x4_t s = vdupq_n_f32(1.0f / 255.0f);
+    *r = vmulq_f32(vcvtq_f32_u32(vandq_u32(p, m)), s);
+    *g = vmulq_f32(vcvtq_f32_u32(vandq_u32(vshrq_n_u32(p, 8), m)), s);
+    *b = vmulq_f32(vcvtq_f32_u32(vandq_u32(vshrq_n_u32(p, 16), m)), s);
+    *a = vmulq_f32(vcvtq_f32_u32(vshrq_n_u32(p, 24)), s);
+}
+
+static inline uint32x4_t swnvg__quantize(swnvg_f4 c) {
+    c = vminq_f32(vmaxq_f32(c, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+    return vcvtq_u32_f32(vmlaq_f32(vdupq_n_f32(0.5f), c, vdupq_n_f32(255.0f)));
+}
+
+static inline void swnvg__pack(uint32_t* px, swnvg_f4 r, swnvg_f4 g, swnvg_f4 b, swnvg_f4 a) {
+    uint32x4_t p = swnvg__quantize(r);
+    p = vorrq_u32(p, vshlq_n_u32(swnvg__quantize(g), 8));
+    p = vorrq_u32(p, vshlq_n_u32(swnvg__quantize(b), 16));
+    p = vorrq_u32(p, vshlq_n_u32(swnvg__quantize(a), 24));
+    vst1q_u32(px, p);
+}
+#else
+typedef struct { float v[4]; } swnvg_f4;
+static inline swnvg_f4 swnvg__set4(float a, float b, float c, float d) { swnvg_f4 r; r.v[0] = a; r.v[1] = b; r.v[2] = c; r.v[3] = d; return r; }
+static inline swnvg_f4 swnvg__set1(float a) { return swnvg__set4(a, a, a, a); }
+#define SWNVG_LANES(expr) swnvg_f4 r; int i; for (i = 0; i < 4; i++) r.v[i] = (expr); return r
+static inline swnvg_f4 swnvg__add(swnvg_f4 a, swnvg_f4 b) { SWNVG_LANES(a.v[i] + b.v[i]); }
+static inline swnvg_f4 swnvg__sub(swnvg_f4 a, swnvg_f4 b) { SWNVG_LANES(a.v[i] - b.v[i]); }
+static inline swnvg_f4 swnvg__mul(swnvg_f4 a, swnvg_f4 b) { SWNVG_LANES(a.v[i] * b.v[i]); }
+static inline swnvg_f4 swnvg__div(swnvg_f4 a, swnvg_f4 b) { SWNVG_LANES(a.v[i] / b.v[i]); }
+static inline swnvg_f4 swnvg__min(swnvg_f4 a, swnvg_f4 b) { SWNVG_LANES(a.v[i] < b.v[i] ? a.v[i] : b.v[i]); }
+static inline swnvg_f4 swnvg__max(swnvg_f4 a, swnvg_f4 b) { SWNVG_LANES(a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+static inline swnvg_f4 swnvg__sqrt(swnvg_f4 a) { SWNVG_LANES(sqrtf(a.v[i])); }
+static inline swnvg_f4 swnvg__abs(swnvg_f4 a) { SWNVG_LANES(fabsf(a.v[i])); }
+static inline swnvg_f4 swnvg__ge(swnvg_f4 a, swnvg_f4 b) { SWNVG_LANES(a.v[i] >= b.v[i] ? 1.0f : 0.0f); }
+#undef SWNVG_LANES
+static inline void swnvg__store(float* p, swnvg_f4 a) { memcpy(p, a.v, sizeof(a.v)); }
+static inline swnvg_f4 swnvg__load(const float* p) { swnvg_f4 r; memcpy(r.v, p, sizeof(r.v)); return r; }
+
+static inline void swnvg__unpack(const uint32_t* px, swnvg_f4* r, swnvg_f4* g, swnvg_f4* b, swnvg_f4* a) {
+    int i;
+    for (i = 0; i < 4; i++) {
+        r->v[i] = (float)(px[i] & 0xff) / 255.0f;
+        g->v[i] = (float)((px[i] >> 8) & 0xff) / 255.0f;
+        b->v[i] = (float)((px[i] >> 16) & 0xff) / 255.0f;
+        a->v[i] = (float)(px[i] >> 24) / 255.0f;
+    }
+}
+
+static inline uint32_t swnvg__quantize(float c) {
+    c = c < 0.0f ? 0.0f : c > 1.0f ? 1.0f : c;
+    return (uint32_t)(c * 255.0f + 0.5f);
+}
+
+static inline void swnvg__pack(uint32_t* px, swnvg_f4 r, swnvg_f4 g, swnvg_f4 b, swnvg_f4 a) {
+    int i;
+    for (i = 0; i < 4; i++) {
+        px[i] = swnvg__quantize(r.v[i]) | (swnvg__quantize(g.v[i]) << 8) | (swnvg__quantize(b.v[i]) << 16) | (swnvg__quantize(a.v[i]) << 24);
+    }
+}
+#endif
+
+static inline swnvg_f4 swnvg__clamp01(swnvg_f4 a) {
+    return swnvg__min(swnvg__max(a, swnvg__set1(0.0f)), swnvg__set1(1.0f));
+}
+
+static inline swnvg_f4 swnvg__mix(swnvg_f4 a, swnvg_f4 b, swnvg_f4 t) {
+    return swnvg__add(a, swnvg__mul(swnvg__sub(b, a), t));
+}
+
+//
+// Back-end
+//
+
+static int swnvg__maxi(int a, int b) { return a > b ? a : b; }
+static int swnvg__mini(int a, int b) { return a < b ? a : b; }
+
+static SWNVGcontext* swnvg__context(NVGcontext* ctx) {
+    return (SWNVGcontext*)nvgInternalParams(ctx)->userPtr;
+}
+
+static SWNVGtexture* swnvg__findTexture(SWNVGcontext* sw, int id) {
+    int i;
+    for (i = 0; i < sw->ntextures; i++) {
+        if (sw->textures[i].id == id) return &sw->textures[i];
+    }
+    return NULL;
+}
+
+static int swnvg__texelSize(int type) {
+    return type == NVG_TEXTURE_RGBA ? 4 : 1;
+}
+
+static void* swnvg__reserveBuffer(void* buf, int* cap, int n, size_t size) {
+    if (n > *cap) {
+        int c = swnvg__maxi(n, *cap + *cap / 2);
+        void* mem = realloc(buf, size * c);
+        if (mem == NULL) return NULL;
+        *cap = c;
+        return mem;
+    }
+    return buf;
+}
+
+static int swnvg__renderCreate(void* uptr) {
+    (void)uptr;
+    return 1;
+}
+
+static int swnvg__renderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data) {
+    SWNVGcontext* sw = (SWNVGcontext*)uptr;
+    SWNVGtexture* textures;
+    SWNVGtexture* tex;
+    size_t size = (size_t)w * h * swnvg__texelSize(type);
+
+    if (w <= 0 || h <= 0) return 0;
+    textures = (SWNVGtexture*)swnvg__reserveBuffer(sw->textures, &sw->ctextures, sw->ntextures + 1, sizeof(SWNVGtexture));
+    if (textures == NULL) return 0;
+    sw->textures = textures;
+
+    tex = &sw->textures[sw->ntextures];
+    memset(tex, 0, sizeof(*tex));
+    tex->data = (unsigned char*)calloc(size, 1);
+    if (tex->data == NULL) return 0;
+    if (data != NULL) memcpy(tex->data, data, size);
+    tex->id = ++sw->textureId;
+    tex->type = type;
+    tex->width = w;
+    tex->height = h;
+    tex->flags = imageFlags;
+    sw->ntextures++;
+    return tex->id;
+}
+
+static int swnvg__renderDeleteTexture(void* uptr, int image) {
+    SWNVGcontext* sw = (SWNVGcontext*)uptr;
+    SWNVGtexture* tex = swnvg__findTexture(sw, image);
+    if (tex == NULL) return 0;
+    free(tex->data);
+    *tex = sw->textures[--sw->ntextures];
+    return 1;
+}
+
+static int swnvg__renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data) {
+    SWNVGcontext* sw = (SWNVGcontext*)uptr;
+    SWNVGtexture* tex = swnvg__findTexture(sw, image);
+    size_t stride;
+    (void)x;
+    (void)w;
+
+    if (tex == NULL || y < 0 || h < 0 || y + h > tex->height) return 0;
+    // Like the deko3d back-end, whole rows are copied from the full image.
+    stride = (size_t)tex->width * swnvg__texelSize(tex->type);
+    memcpy(tex->data + stride * y, data + stride * y, stride * h);
+    return 1;
+}
+
+static int swnvg__renderGetTextureSize(void* uptr, int image, int* w, int* h) {
+    SWNVGcontext* sw = (SWNVGcontext*)uptr;
+    SWNVGtexture* tex = swnvg__findTexture(sw, image);
+    if (tex == NULL) return 0;
+    *w = tex->width;
+    *h = tex->height;
+    return 1;
+}
+
+static NVGcolor swnvg__premulColor(NVGcolor c) {
+    c.r *= c.a;
+    c.g *= c.a;
+    c.b *= c.a;
+    return c;
+}
+
+static int swnvg__convertPaint(SWNVGcontext* sw, SWNVGfragUniforms* frag, NVGpaint* paint,
+                               NVGscissor* scissor, float width, float fringe, float strokeThr) {
+    const SWNVGtexture* tex;
+
+    memset(frag, 0, sizeof(*frag));
+    frag->innerCol = swnvg__premulColor(paint->innerColor);
+    frag->outerCol = swnvg__premulColor(paint->outerColor);
+
+    if (scissor->extent[0] < -0.5f || scissor->extent[1] < -0.5f) {
+        // Negative extent skips scissoring.
+        frag->scissorExt[0] = -1.0f;
+        frag->scissorExt[1] = -1.0f;
+        frag->scissorScale[0] = 1.0f;
+        frag->scissorScale[1] = 1.0f;
+    } else {
+        nvgTransformInverse(frag->scissorMat, scissor->xform);
+        frag->scissorExt[0] = scissor->extent[0];
+        frag->scissorExt[1] = scissor->extent[1];
+        frag->scissorScale[0] = sqrtf(scissor->xform[0]*scissor->xform[0] + scissor->xform[2]*scissor->xform[2]) / fringe;
+        frag->scissorScale[1] = sqrtf(scissor->xform[1]*scissor->xform[1] + scissor->xform[3]*scissor->xform[3]) / fringe;
+    }
+
+    memcpy(frag->extent, paint->extent, sizeof(frag->extent));
+    frag->strokeMult = (width*0.5f + fringe*0.5f) / fringe;
+    frag->strokeThr = strokeThr;
+
+    if (paint->image != 0) {
+        tex = swnvg__findTexture(sw, paint->image);
+        if (tex == NULL) return 0;
+        if ((tex->flags & NVG_IMAGE_FLIPY) != 0) {
+            float m1[6], m2[6];
+            nvgTransformTranslate(m1, 0.0f, frag->extent[1] * 0.5f);
+            nvgTransformMultiply(m1, paint->xform);
+            nvgTransformScale(m2, 1.0f, -1.0f);
+            nvgTransformMultiply(m2, m1);
+            nvgTransformTranslate(m1, 0.0f, -frag->extent[1] * 0.5f);
+            nvgTransformMultiply(m1, m2);
+            nvgTransformInverse(frag->paintMat, m1);
+        } else {
+            nvgTransformInverse(frag->paintMat, paint->xform);
+        }
+        frag->type = SWNVG_SHADER_FILLIMG;
+
+        if (tex->type == NVG_TEXTURE_RGBA)
+            frag->texType = (tex->flags & NVG_IMAGE_PREMULTIPLIED) ? 0 : 1;
+        else
+            frag->texType = (tex->flags & NVG_IMAGE_SDF) ? 3 : 2;
+    } else {
+        frag->type = SWNVG_SHADER_FILLGRAD;
+        frag->radius = paint->radius;
+        frag->feather = paint->feather;
+        nvgTransformInverse(frag->paintMat, paint->xform);
+    }
+
+    return 1;
+}
+
+static void swnvg__renderViewport(void* uptr, float width, float height, float devicePixelRatio) {
+    SWNVGcontext* sw = (SWNVGcontext*)uptr;
+    int w = (int)ceilf(width), h = (int)ceilf(height), i;
+    NVGcolor c = swnvg__premulColor(sw->clearColor);
+    uint32_t clear;
+    (void)devicePixelRatio;
+
+    sw->view[0] = width;
+    sw->view[1] = height;
+
+    if (w * h > sw->cpixels) {
+        uint32_t* pixels = (uint32_t*)realloc(sw->pixels, sizeof(uint32_t) * w * h);
+        unsigned char* stencil = (unsigned char*)realloc(sw->stencil, (size_t)w * h);
+        if (pixels != NULL) sw->pixels = pixels;
+        if (stencil != NULL) sw->stencil = stencil;
+        if (pixels == NULL || stencil == NULL) {
+            sw->width = sw->height = 0;
+            return;
+        }
+        sw->cpixels = w * h;
+    }
+    sw->width = w;
+    sw->height = h;
+
+    // Start each frame from the clear color, like the app clearing its framebuffer.
+    clear = (uint32_t)(c.r * 255.0f + 0.5f) | ((uint32_t)(c.g * 255.0f + 0.5f) << 8) |
+            ((uint32_t)(c.b * 255.0f + 0.5f) << 16) | ((uint32_t)(c.a * 255.0f + 0.5f) << 24);
+    for (i = 0; i < w * h; i++) sw->pixels[i] = clear;
+    memset(sw->stencil, 0, (size_t)w * h);
+}
+
+static void swnvg__renderCancel(void* uptr) {
+    SWNVGcontext* sw = (SWNVGcontext*)uptr;
+    sw->nverts = 0;
+    sw->npaths = 0;
+    sw->ncalls = 0;
+    sw->nuniforms = 0;
+}
+
+static SWNVGcall* swnvg__allocCall(SWNVGcontext* sw) {
+    SWNVGcall* calls = (SWNVGcall*)swnvg__reserveBuffer(sw->calls, &sw->ccalls, sw->ncalls + 1, sizeof(SWNVGcall));
+    SWNVGcall* ret;
+    if (calls == NULL) return NULL;
+    sw->calls = calls;
+    ret = &sw->calls[sw->ncalls++];
+    memset(ret, 0, sizeof(SWNVGcall));
+    return ret;
+}
+
+static int swnvg__allocPaths(SWNVGcontext* sw, int n) {
+    SWNVGpath* paths = (SWNVGpath*)swnvg__reserveBuffer(sw->paths, &sw->cpaths, sw->npaths + n, sizeof(SWNVGpath));
+    int ret;
+    if (paths == NULL) return -1;
+    sw->paths = paths;
+    ret = sw->npaths;
+    sw->npaths += n;
+    return ret;
+}
+
+static int swnvg__allocVerts(SWNVGcontext* sw, int n) {
+    NVGvertex* verts = (NVGvertex*)swnvg__reserveBuffer(sw->verts, &sw->cverts, sw->nverts + n, sizeof(NVGvertex));
+    int ret;
+    if (verts == NULL) return -1;
+    sw->verts = verts;
+    ret = sw->nverts;
+    sw->nverts += n;
+    return ret;
+}
+
+static int swnvg__allocFragUniforms(SWNVGcontext* sw, int n) {
+    SWNVGfragUniforms* uniforms = (SWNVGfragUniforms*)swnvg__reserveBuffer(sw->uniforms, &sw->cuniforms, sw->nuniforms + n,
+                                                                             sizeof(SWNVGfragUniforms));
+    int ret;
+    if (uniforms == NULL) return -1;
+    sw->uniforms = uniforms;
+    ret = sw->nuniforms;
+    sw->nuniforms += n;
+    return ret;
+}
+
+static int swnvg__maxVertCount(const NVGpath* paths, int npaths) {
+    int i, count = 0;
+    for (i = 0; i < npaths; i++) {
+        count += paths[i].nfill;
+        count += paths[i].nstroke;
+    }
+    return count;
+}
+
+static void swnvg__vset(NVGvertex* vtx, float x, float y, float u, float v) {
+    vtx->x = x;
+    vtx->y = y;
+    vtx->u = u;
+    vtx->v = v;
+}
+
+// Pixels a range of vertices can touch, clipped to the framebuffer.
+static void swnvg__setCallBounds(SWNVGcontext* sw, SWNVGcall* call, int first, int count) {
+    float minx = 1e30f, miny = 1e30f, maxx = -1e30f, maxy = -1e30f;
+    int i;
+    for (i = first; i < first + count; i++) {
+        const NVGvertex* v = &sw->verts[i];
+        if (v->x < minx) minx = v->x;
+        if (v->y < miny) miny = v->y;
+        if (v->x > maxx) maxx = v->x;
+        if (v->y > maxy) maxy = v->y;
+    }
+    if (count == 0) {
+        call->bounds[0] = call->bounds[1] = call->bounds[2] = call->bounds[3] = 0;
+        return;
+    }
+    call->bounds[0] = swnvg__maxi((int)floorf(minx), 0);
+    call->bounds[1] = swnvg__maxi((int)floorf(miny), 0);
+    call->bounds[2] = swnvg__mini((int)ceilf(maxx) + 1, sw->width);
+    call->bounds[3] = swnvg__mini((int)ceilf(maxy) + 1, sw->height);
+}
+
+static void swnvg__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+                              const float* bounds, const NVGpath* paths, int npaths) {
+    SWNVGcontext* sw = (SWNVGcontext*)uptr;
+    SWNVGcall* call = swnvg__allocCall(sw);
+    NVGvertex* quad;
+    SWNVGfragUniforms* frag;
+    int i, maxverts, offset, first;
+
+    if (call == NULL) return;
+
+    call->type = SWNVG_FILL;
+    call->triangleCount = 4;
+    call->pathOffset = swnvg__allocPaths(sw, npaths);
+    if (call->pathOffset == -1) goto error;
+    call->pathCount = npaths;
+    call->image = paint->image;
+    call->blendFunc = compositeOperation;
+
+    if (npaths == 1 && (paths[0].convex || paths[0].triangulated)) {
+        call->type = SWNVG_CONVEXFILL;
+        call->triangleCount = 0;	// Bounding box fill quad not needed for convex fill
+        // Triangulated concave fills come as a triangle list instead of a fan.
+        call->fillPrimitive = paths[0].triangulated ? SWNVG_LIST : SWNVG_FAN;
+    }
+
+    // Allocate vertices for all the paths.
+    maxverts = swnvg__maxVertCount(paths, npaths) + call->triangleCount;
+    offset = swnvg__allocVerts(sw, maxverts);
+    if (offset == -1) goto error;
+    first = offset;
+
+    for (i = 0; i < npaths; i++) {
+        SWNVGpath* copy = &sw->paths[call->pathOffset + i];
+        const NVGpath* path = &paths[i];
+        memset(copy, 0, sizeof(SWNVGpath));
+        if (path->nfill > 0) {
+            copy->fillOffset = offset;
+            copy->fillCount = path->nfill;
+            memcpy(&sw->verts[offset], path->fill, sizeof(NVGvertex) * path->nfill);
+            offset += path->nfill;
+        }
+        if (path->nstroke > 0) {
+            copy->strokeOffset = offset;
+            copy->strokeCount = path->nstroke;
+            memcpy(&sw->verts[offset], path->stroke, sizeof(NVGvertex) * path->nstroke);
+            offset += path->nstroke;
+        }
+    }
+
+    if (call->type == SWNVG_FILL) {
+        // Quad
+        call->triangleOffset = offset;
+        quad = &sw->verts[call->triangleOffset];
+        swnvg__vset(&quad[0], bounds[2], bounds[3], 0.5f, 1.0f);
+        swnvg__vset(&quad[1], bounds[2], bounds[1], 0.5f, 1.0f);
+        swnvg__vset(&quad[2], bounds[0], bounds[3], 0.5f, 1.0f);
+        swnvg__vset(&quad[3], bounds[0], bounds[1], 0.5f, 1.0f);
+
+        call->uniformOffset = swnvg__allocFragUniforms(sw, 2);
+        if (call->uniformOffset == -1) goto error;
+        // Simple shader for stencil
+        frag = &sw->uniforms[call->uniformOffset];
+        memset(frag, 0, sizeof(*frag));
+        frag->strokeThr = -1.0f;
+        frag->type = SWNVG_SHADER_SIMPLE;
+        // Fill shader
+        if (!swnvg__convertPaint(sw, &sw->uniforms[call->uniformOffset + 1], paint, scissor, fringe, fringe, -1.0f)) goto error;
+    } else {
+        call->uniformOffset = swnvg__allocFragUniforms(sw, 1);
+        if (call->uniformOffset == -1) goto error;
+        // Fill shader
+        if (!swnvg__convertPaint(sw, &sw->uniforms[call->uniformOffset], paint, scissor, fringe, fringe, -1.0f)) goto error;
+    }
+
+    swnvg__setCallBounds(sw, call, first, maxverts);
+    return;
+
+error:
+    // We get here if call alloc was ok, but something else is not.
+    // Roll back the last call to prevent drawing it.
+    if (sw->ncalls > 0) sw->ncalls--;
+}
+
+static void swnvg__renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+                                float strokeWidth, const NVGpath* paths, int npaths) {
+    SWNVGcontext* sw = (SWNVGcontext*)uptr;
+    SWNVGcall* call = swnvg__allocCall(sw);
+    int i, maxverts, offset, first;
+
+    if (call == NULL) return;
+
+    call->type = SWNVG_STROKE;
+    call->pathOffset = swnvg__allocPaths(sw, npaths);
+    if (call->pathOffset == -1) goto error;
+    call->pathCount = npaths;
+    call->image = paint->image;
+    call->blendFunc = compositeOperation;
+
+    // Allocate vertices for all the paths.
+    maxverts = swnvg__maxVertCount(paths, npaths);
+    offset = swnvg__allocVerts(sw, maxverts);
+    if (offset == -1) goto error;
+    first = offset;
+
+    for (i = 0; i < npaths; i++) {
+        SWNVGpath* copy = &sw->paths[call->pathOffset + i];
+        const NVGpath* path = &paths[i];
+        memset(copy, 0, sizeof(SWNVGpath));
+        if (path->nstroke) {
+            copy->strokeOffset = offset;
+            copy->strokeCount = path->nstroke;
+            memcpy(&sw->verts[offset], path->stroke, sizeof(NVGvertex) * path->nstroke);
+            offset += path->nstroke;
+        }
+    }
+
+    if (sw->flags & NVGSW_STENCIL_STROKES) {
+        // Fill shader
+        call->uniformOffset = swnvg__allocFragUniforms(sw, 2);
+        if (call->uniformOffset == -1) goto error;
+
+        if (!swnvg__convertPaint(sw, &sw->uniforms[call->uniformOffset], paint, scissor, strokeWidth, fringe, -1.0f)) goto error;
+        if (!swnvg__convertPaint(sw, &sw->uniforms[call->uniformOffset + 1], paint, scissor, strokeWidth, fringe, 1.0f - 0.5f/255.0f)) goto error;
+    } else {
+        // Fill shader
+        call->uniformOffset = swnvg__allocFragUniforms(sw, 1);
+        if (call->uniformOffset == -1) goto error;
+
+        if (!swnvg__convertPaint(sw, &sw->uniforms[call->uniformOffset], paint, scissor, strokeWidth, fringe, -1.0f)) goto error;
+    }
+
+    swnvg__setCallBounds(sw, call, first, maxverts);
+    return;
+
+error:
+    // We get here if call alloc was ok, but something else is not.
+    // Roll back the last call to prevent drawing it.
+    if (sw->ncalls > 0) sw->ncalls--;
+}
+
+static void swnvg__renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+                                   const NVGvertex* verts, int nverts, float fringe) {
+    SWNVGcontext* sw = (SWNVGcontext*)uptr;
+    SWNVGcall* call = swnvg__allocCall(sw);
+    SWNVGfragUniforms* frag;
+
+    if (call == NULL) return;
+
+    call->type = SWNVG_TRIANGLES;
+    call->image = paint->image;
+    call->blendFunc = compositeOperation;
+
+    // Allocate vertices for all the paths.
+    call->triangleOffset = swnvg__allocVerts(sw, nverts);
+    if (call->triangleOffset == -1) goto error;
+    call->triangleCount = nverts;
+
+    memcpy(&sw->verts[call->triangleOffset], verts, sizeof(NVGvertex) * nverts);
+
+    // Fill shader
+    call->uniformOffset = swnvg__allocFragUniforms(sw, 1);
+    if (call->uniformOffset == -1) goto error;
+    frag = &sw->uniforms[call->uniformOffset];
+    if (!swnvg__convertPaint(sw, frag, paint, scissor, 1.0f, fringe, -1.0f)) goto error;
+    frag->type = SWNVG_SHADER_IMG;
+
+    swnvg__setCallBounds(sw, call, call->triangleOffset, nverts);
+    return;
+
+error:
+    // We get here if call alloc was ok, but something else is not.
+    // Roll back the last call to prevent drawing it.
+    if (sw->ncalls > 0) sw->ncalls--;
+}
+
+static void swnvg__renderFillRect(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+                                  const float* rect) {
+    SWNVGcontext* sw = (SWNVGcontext*)uptr;
+    SWNVGcall* call = swnvg__allocCall(sw);
+    NVGvertex* quad;
+
+    if (call == NULL) return;
+
+    // Drawn with the fill shader like the deko3d rect batches, without the batching.
+    call->type = SWNVG_TRIANGLES;
+    call->image = paint->image;
+    call->blendFunc = compositeOperation;
+    call->triangleOffset = swnvg__allocVerts(sw, 6);
+    if (call->triangleOffset == -1) goto error;
+    call->triangleCount = 6;
+
+    // Same winding as text quads.
+    quad = &sw->verts[call->triangleOffset];
+    swnvg__vset(&quad[0], rect[0], rect[1], 0.5f, 1.0f);
+    swnvg__vset(&quad[1], rect[2], rect[3], 0.5f, 1.0f);
+    swnvg__vset(&quad[2], rect[2], rect[1], 0.5f, 1.0f);
+    swnvg__vset(&quad[3], rect[0], rect[1], 0.5f, 1.0f);
+    swnvg__vset(&quad[4], rect[0], rect[3], 0.5f, 1.0f);
+    swnvg__vset(&quad[5], rect[2], rect[3], 0.5f, 1.0f);
+
+    call->uniformOffset = swnvg__allocFragUniforms(sw, 1);
+    if (call->uniformOffset == -1) goto error;
+    if (!swnvg__convertPaint(sw, &sw->uniforms[call->uniformOffset], paint, scissor, fringe, fringe, -1.0f)) goto error;
+
+    swnvg__setCallBounds(sw, call, call->triangleOffset, 6);
+    return;
+
+error:
+    // We get here if call alloc was ok, but something else is not.
+    // Roll back the last call to prevent drawing it.
+    if (sw->ncalls > 0) sw->ncalls--;
+}
+
+//
+// Rasterizer
+//
+
+// One rasterized row of a triangle, x0 to x1 exclusive, with the attribute gradients.
+struct SWNVGspan {
+    int x0;
+    int x1;
+    int y;
+    float u;        // At the center of x0.
+    float v;
+    float dudx;
+    float dvdx;
+    float dudy;
+    float dvdy;
+    int front;
+};
+typedef struct SWNVGspan SWNVGspan;
+
+static void swnvg__sample(const SWNVGtexture* tex, float s, float t, float* out) {
+    const int bpp = swnvg__texelSize(tex->type);
+    const int w = tex->width, h = tex->height;
+    int x0, y0, x1, y1, c;
+    float fx, fy;
+
+    if (tex->flags & NVG_IMAGE_REPEATX) s -= floorf(s);
+    if (tex->flags & NVG_IMAGE_REPEATY) t -= floorf(t);
+
+    if (tex->flags & NVG_IMAGE_NEAREST) {
+        x0 = swnvg__mini(swnvg__maxi((int)floorf(s * w), 0), w - 1);
+        y0 = swnvg__mini(swnvg__maxi((int)floorf(t * h), 0), h - 1);
+        for (c = 0; c < bpp; c++) out[c] = tex->data[((size_t)y0 * w + x0) * bpp + c] / 255.0f;
+    } else {
+        float x = s * w - 0.5f, y = t * h - 0.5f;
+        x0 = (int)floorf(x);
+        y0 = (int)floorf(y);
+        fx = x - (float)x0;
+        fy = y - (float)y0;
+        x1 = x0 + 1;
+        y1 = y0 + 1;
+        if (tex->flags & NVG_IMAGE_REPEATX) {
+            x0 = (x0 % w + w) % w;
+            x1 = (x1 % w + w) % w;
+        } else {
+            x0 = swnvg__mini(swnvg__maxi(x0, 0), w - 1);
+            x1 = swnvg__mini(swnvg__maxi(x1, 0), w - 1);
+        }
+        if (tex->flags & NVG_IMAGE_REPEATY) {
+            y0 = (y0 % h + h) % h;
+            y1 = (y1 % h + h) % h;
+        } else {
+            y0 = swnvg__mini(swnvg__maxi(y0, 0), h - 1);
+            y1 = swnvg__mini(swnvg__maxi(y1, 0), h - 1);
+        }
+        for (c = 0; c < bpp; c++) {
+            float a = tex->data[((size_t)y0 * w + x0) * bpp + c], b = tex->data[((size_t)y0 * w + x1) * bpp + c];
+            float d = tex->data[((size_t)y1 * w + x0) * bpp + c], e = tex->data[((size_t)y1 * w + x1) * bpp + c];
+            out[c] = ((a + (b - a) * fx) * (1.0f - fy) + (d + (e - d) * fx) * fy) / 255.0f;
+        }
+    }
+
+    // Single channel textures read as (r, 0, 0, 1).
+    if (bpp == 1) {
+        out[1] = 0.0f;
+        out[2] = 0.0f;
+        out[3] = 1.0f;
+    }
+}
+
+// Coverage of a distance field texel, fwidth() taken from the texels one pixel right and down.
+static float swnvg__sdfCoverage(const SWNVGtexture* tex, float s, float t, const float* st) {
+    float d[4], dx[4], dy[4], w;
+    swnvg__sample(tex, s, t, d);
+    swnvg__sample(tex, s + st[0], t + st[1], dx);
+    swnvg__sample(tex, s + st[2], t + st[3], dy);
+    w = fmaxf(fabsf(dx[0] - d[0]) + fabsf(dy[0] - d[0]), 1e-4f);
+    return fminf(fmaxf((d[0] - 0.5f) / w + 0.5f, 0.0f), 1.0f);
+}
+
+// Samples four texels, applying the texture type conversion of the shader.
+// st holds the texture coordinate steps of one pixel in x and y, for distance fields.
+static void swnvg__sample4(const SWNVGfragUniforms* frag, const SWNVGtexture* tex, swnvg_f4 s, swnvg_f4 t, const float* st,
+                           swnvg_f4* r, swnvg_f4* g, swnvg_f4* b, swnvg_f4* a) {
+    float ss[4], ts[4], cr[4], cg[4], cb[4], ca[4];
+    int i;
+
+    swnvg__store(ss, s);
+    swnvg__store(ts, t);
+    for (i = 0; i < 4; i++) {
+        float c[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        if (tex != NULL && frag->texType == 3) {
+            c[0] = c[1] = c[2] = c[3] = swnvg__sdfCoverage(tex, ss[i], ts[i], st);
+        } else if (tex != NULL) {
+            swnvg__sample(tex, ss[i], ts[i], c);
+        }
+        if (frag->texType == 1) {
+            c[0] *= c[3];
+            c[1] *= c[3];
+            c[2] *= c[3];
+        } else if (frag->texType == 2) {
+            c[1] = c[2] = c[3] = c[0];
+        }
+        cr[i] = c[0];
+        cg[i] = c[1];
+        cb[i] = c[2];
+        ca[i] = c[3];
+    }
+    *r = swnvg__load(cr);
+    *g = swnvg__load(cg);
+    *b = swnvg__load(cb);
+    *a = swnvg__load(ca);
+}
+
+// Evaluates fill_aa_fsh.glsl for four pixels, mask is zeroed for discarded lanes.
+static void swnvg__shade(const SWNVGpass* pass, const SWNVGspan* span, swnvg_f4 x, float y, swnvg_f4 u, swnvg_f4 v,
+                         swnvg_f4* r, swnvg_f4* g, swnvg_f4* b, swnvg_f4* a, swnvg_f4* mask) {
+    const SWNVGfragUniforms* f = pass->frag;
+    const swnvg_f4 one = swnvg__set1(1.0f);
+    swnvg_f4 scissor = one, strokeAlpha, alpha;
+
+    if (f->type == SWNVG_SHADER_SIMPLE) {
+        *r = *g = *b = *a = one;
+        return;
+    }
+
+    if (f->scissorExt[0] >= 0.0f) {
+        const float* m = f->scissorMat;
+        swnvg_f4 sx = swnvg__add(swnvg__mul(x, swnvg__set1(m[0])), swnvg__set1(m[2]*y + m[4]));
+        swnvg_f4 sy = swnvg__add(swnvg__mul(x, swnvg__set1(m[1])), swnvg__set1(m[3]*y + m[5]));
+        sx = swnvg__sub(swnvg__abs(sx), swnvg__set1(f->scissorExt[0]));
+        sy = swnvg__sub(swnvg__abs(sy), swnvg__set1(f->scissorExt[1]));
+        sx = swnvg__clamp01(swnvg__sub(swnvg__set1(0.5f), swnvg__mul(sx, swnvg__set1(f->scissorScale[0]))));
+        sy = swnvg__clamp01(swnvg__sub(swnvg__set1(0.5f), swnvg__mul(sy, swnvg__set1(f->scissorScale[1]))));
+        scissor = swnvg__mul(sx, sy);
+    }
+
+    // Stroke - from [0..1] to clipped pyramid, where the slope is 1px.
+    strokeAlpha = swnvg__sub(one, swnvg__abs(swnvg__sub(swnvg__add(u, u), one)));
+    strokeAlpha = swnvg__min(one, swnvg__mul(strokeAlpha, swnvg__set1(f->strokeMult)));
+    strokeAlpha = swnvg__mul(strokeAlpha, swnvg__min(one, v));
+    if (f->strokeThr > -1.0f) *mask = swnvg__mul(*mask, swnvg__ge(strokeAlpha, swnvg__set1(f->strokeThr)));
+
+    if (f->type == SWNVG_SHADER_FILLGRAD) {
+        const NVGcolor* ic = &f->innerCol;
+        const NVGcolor* oc = &f->outerCol;
+        alpha = swnvg__mul(strokeAlpha, scissor);
+        if (ic->r == oc->r && ic->g == oc->g && ic->b == oc->b && ic->a == oc->a) {
+            // Solid color, the gradient has nothing to blend.
+            *r = swnvg__mul(swnvg__set1(ic->r), alpha);
+            *g = swnvg__mul(swnvg__set1(ic->g), alpha);
+            *b = swnvg__mul(swnvg__set1(ic->b), alpha);
+            *a = swnvg__mul(swnvg__set1(ic->a), alpha);
+        } else {
+            const float* m = f->paintMat;
+            swnvg_f4 px = swnvg__add(swnvg__mul(x, swnvg__set1(m[0])), swnvg__set1(m[2]*y + m[4]));
+            swnvg_f4 py = swnvg__add(swnvg__mul(x, swnvg__set1(m[1])), swnvg__set1(m[3]*y + m[5]));
+            swnvg_f4 dx = swnvg__sub(swnvg__abs(px), swnvg__set1(f->extent[0] - f->radius));
+            swnvg_f4 dy = swnvg__sub(swnvg__abs(py), swnvg__set1(f->extent[1] - f->radius));
+            swnvg_f4 zero = swnvg__set1(0.0f);
+            swnvg_f4 mx = swnvg__max(dx, zero), my = swnvg__max(dy, zero);
+            swnvg_f4 d = swnvg__add(swnvg__min(swnvg__max(dx, dy), zero), swnvg__sqrt(swnvg__add(swnvg__mul(mx, mx), swnvg__mul(my, my))));
+            d = swnvg__sub(d, swnvg__set1(f->radius));
+            d = swnvg__clamp01(swnvg__div(swnvg__add(d, swnvg__set1(f->feather*0.5f)), swnvg__set1(f->feather)));
+            *r = swnvg__mul(swnvg__mix(swnvg__set1(ic->r), swnvg__set1(oc->r), d), alpha);
+            *g = swnvg__mul(swnvg__mix(swnvg__set1(ic->g), swnvg__set1(oc->g), d), alpha);
+            *b = swnvg__mul(swnvg__mix(swnvg__set1(ic->b), swnvg__set1(oc->b), d), alpha);
+            *a = swnvg__mul(swnvg__mix(swnvg__set1(ic->a), swnvg__set1(oc->a), d), alpha);
+        }
+    } else if (f->type == SWNVG_SHADER_FILLIMG) {
+        const float* m = f->paintMat;
+        swnvg_f4 s = swnvg__add(swnvg__mul(x, swnvg__set1(m[0])), swnvg__set1(m[2]*y + m[4]));
+        swnvg_f4 t = swnvg__add(swnvg__mul(x, swnvg__set1(m[1])), swnvg__set1(m[3]*y + m[5]));
+        const float st[4] = { m[0] / f->extent[0], m[1] / f->extent[1], m[2] / f->extent[0], m[3] / f->extent[1] };
+        s = swnvg__div(s, swnvg__set1(f->extent[0]));
+        t = swnvg__div(t, swnvg__set1(f->extent[1]));
+        swnvg__sample4(f, pass->tex, s, t, st, r, g, b, a);
+        alpha = swnvg__mul(strokeAlpha, scissor);
+        *r = swnvg__mul(swnvg__mul(*r, swnvg__set1(f->innerCol.r)), alpha);
+        *g = swnvg__mul(swnvg__mul(*g, swnvg__set1(f->innerCol.g)), alpha);
+        *b = swnvg__mul(swnvg__mul(*b, swnvg__set1(f->innerCol.b)), alpha);
+        *a = swnvg__mul(swnvg__mul(*a, swnvg__set1(f->innerCol.a)), alpha);
+    } else {
+        // Textured tris
+        const float st[4] = { span->dudx, span->dvdx, span->dudy, span->dvdy };
+        swnvg__sample4(f, pass->tex, u, v, st, r, g, b, a);
+        *r = swnvg__mul(swnvg__mul(*r, scissor), swnvg__set1(f->innerCol.r));
+        *g = swnvg__mul(swnvg__mul(*g, scissor), swnvg__set1(f->innerCol.g));
+        *b = swnvg__mul(swnvg__mul(*b, scissor), swnvg__set1(f->innerCol.b));
+        *a = swnvg__mul(swnvg__mul(*a, scissor), swnvg__set1(f->innerCol.a));
+    }
+}
+
+static swnvg_f4 swnvg__blendFactor(int factor, swnvg_f4 sc, swnvg_f4 sa, swnvg_f4 dc, swnvg_f4 da, int alpha) {
+    const swnvg_f4 one = swnvg__set1(1.0f);
+    switch (factor) {
+        case NVG_ZERO: return swnvg__set1(0.0f);
+        case NVG_SRC_COLOR: return sc;
+        case NVG_ONE_MINUS_SRC_COLOR: return swnvg__sub(one, sc);
+        case NVG_DST_COLOR: return dc;
+        case NVG_ONE_MINUS_DST_COLOR: return swnvg__sub(one, dc);
+        case NVG_SRC_ALPHA: return sa;
+        case NVG_ONE_MINUS_SRC_ALPHA: return swnvg__sub(one, sa);
+        case NVG_DST_ALPHA: return da;
+        case NVG_ONE_MINUS_DST_ALPHA: return swnvg__sub(one, da);
+        case NVG_SRC_ALPHA_SATURATE: return alpha ? one : swnvg__min(sa, swnvg__sub(one, da));
+        default: return one;
+    }
+}
+
+// Blends four shaded pixels into the framebuffer, lanes with a zero mask are left untouched.
+static void swnvg__blend(const SWNVGpass* pass, uint32_t* px, swnvg_f4 r, swnvg_f4 g, swnvg_f4 b, swnvg_f4 a, swnvg_f4 mask) {
+    const NVGcompositeOperationState* op = &pass->blend;
+    swnvg_f4 dr, dg, db, da, or_, og, ob, oa;
+
+    swnvg__unpack(px, &dr, &dg, &db, &da);
+
+    if (op->srcRGB == NVG_ONE && op->dstRGB == NVG_ONE_MINUS_SRC_ALPHA &&
+        op->srcAlpha == NVG_ONE && op->dstAlpha == NVG_ONE_MINUS_SRC_ALPHA) {
+        // Source over, the default composite operation.
+        swnvg_f4 inv = swnvg__sub(swnvg__set1(1.0f), a);
+        or_ = swnvg__add(r, swnvg__mul(dr, inv));
+        og = swnvg__add(g, swnvg__mul(dg, inv));
+        ob = swnvg__add(b, swnvg__mul(db, inv));
+        oa = swnvg__add(a, swnvg__mul(da, inv));
+    } else {
+        or_ = swnvg__add(swnvg__mul(r, swnvg__blendFactor(op->srcRGB, r, a, dr, da, 0)),
+                         swnvg__mul(dr, swnvg__blendFactor(op->dstRGB, r, a, dr, da, 0)));
+        og = swnvg__add(swnvg__mul(g, swnvg__blendFactor(op->srcRGB, g, a, dg, da, 0)),
+                        swnvg__mul(dg, swnvg__blendFactor(op->dstRGB, g, a, dg, da, 0)));
+        ob = swnvg__add(swnvg__mul(b, swnvg__blendFactor(op->srcRGB, b, a, db, da, 0)),
+                        swnvg__mul(db, swnvg__blendFactor(op->dstRGB, b, a, db, da, 0)));
+        oa = swnvg__add(swnvg__mul(a, swnvg__blendFactor(op->srcAlpha, a, a, da, da, 1)),
+                        swnvg__mul(da, swnvg__blendFactor(op->dstAlpha, a, a, da, da, 1)));
+    }
+
+    swnvg__pack(px, swnvg__mix(dr, or_, mask), swnvg__mix(dg, og, mask), swnvg__mix(db, ob, mask), swnvg__mix(da, oa, mask));
+}
+
+static void swnvg__fillSpan(SWNVGcontext* sw, const SWNVGpass* pass, const SWNVGspan* span) {
+    unsigned char* stencil = &sw->stencil[(size_t)span->y * sw->width];
+    uint32_t* pixels = &sw->pixels[(size_t)span->y * sw->width];
+    const float y = (float)span->y + 0.5f;
+    int x;
+
+    if (!pass->colorWrite) {
+        // Stencil only passes.
+        if (pass->stencilOp == SWNVG_OP_ZERO) {
+            memset(&stencil[span->x0], 0, span->x1 - span->x0);
+        } else if (pass->stencilOp == SWNVG_OP_WINDING) {
+            unsigned char d = span->front ? 1 : 0xff;
+            for (x = span->x0; x < span->x1; x++) stencil[x] = (unsigned char)(stencil[x] + d);
+        }
+        return;
+    }
+
+    for (x = span->x0; x < span->x1; x += 4) {
+        const int n = swnvg__mini(4, span->x1 - x);
+        const float fx = (float)x + 0.5f;
+        const float t = (float)(x - span->x0);
+        float lanes[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        uint32_t tail[4];
+        uint32_t* px = &pixels[x];
+        swnvg_f4 r, g, b, a, mask, u, v;
+        int i;
+
+        // Stencil test, and the pixels past the span end.
+        for (i = 0; i < n; i++) {
+            const unsigned char s = stencil[x + i];
+            lanes[i] = pass->stencilTest == SWNVG_TEST_ALWAYS ? 1.0f :
+                       pass->stencilTest == SWNVG_TEST_EQUAL ? (s == 0 ? 1.0f : 0.0f) : (s != 0 ? 1.0f : 0.0f);
+        }
+        mask = swnvg__load(lanes);
+
+        u = swnvg__add(swnvg__set1(span->u + span->dudx * t), swnvg__mul(swnvg__set4(0.0f, 1.0f, 2.0f, 3.0f), swnvg__set1(span->dudx)));
+        v = swnvg__add(swnvg__set1(span->v + span->dvdx * t), swnvg__mul(swnvg__set4(0.0f, 1.0f, 2.0f, 3.0f), swnvg__set1(span->dvdx)));
+        swnvg__shade(pass, span, swnvg__set4(fx, fx + 1.0f, fx + 2.0f, fx + 3.0f), y, u, v, &r, &g, &b, &a, &mask);
+
+        if (n < 4) {
+            memcpy(tail, px, sizeof(uint32_t) * n);
+            px = tail;
+        }
+        swnvg__blend(pass, px, r, g, b, a, mask);
+        if (n < 4) memcpy(&pixels[x], tail, sizeof(uint32_t) * n);
+
+        if (pass->stencilOp == SWNVG_OP_ZERO) {
+            memset(&stencil[x], 0, n);
+        } else if (pass->stencilOp == SWNVG_OP_INCR) {
+            swnvg__store(lanes, mask);
+            for (i = 0; i < n; i++) {
+                if (lanes[i] != 0.0f && stencil[x + i] < 0xff) stencil[x + i]++;
+            }
+        }
+    }
+}
+
+// Rasterizes a triangle inside the tile, pixel centers on a shared edge belong to exactly one side.
+static void swnvg__rasterTriangle(SWNVGcontext* sw, const SWNVGpass* pass, const int* tile,
+                                  const NVGvertex* a, const NVGvertex* b, const NVGvertex* c) {
+    const NVGvertex* tri[3] = { a, b, c };
+    float ex[3], ey[3], dx[3], dy[3];
+    int inside[3];
+    float area = (b->x - a->x)*(c->y - a->y) - (c->x - a->x)*(b->y - a->y);
+    float dudx, dudy, dvdx, dvdy, minx, maxx, miny, maxy;
+    int i, y, y0, y1, x0, x1;
+    SWNVGspan span;
+
+    if (area == 0.0f) return;
+    // The y flip of the vertex shader makes triangles with negative area face the front.
+    span.front = area < 0.0f;
+    if (pass->cull && !span.front) return;
+
+    minx = fminf(a->x, fminf(b->x, c->x));
+    maxx = fmaxf(a->x, fmaxf(b->x, c->x));
+    miny = fminf(a->y, fminf(b->y, c->y));
+    maxy = fmaxf(a->y, fmaxf(b->y, c->y));
+    x0 = swnvg__maxi((int)floorf(minx), tile[0]);
+    x1 = swnvg__mini((int)ceilf(maxx) + 1, tile[2]);
+    y0 = swnvg__maxi((int)floorf(miny), tile[1]);
+    y1 = swnvg__mini((int)ceilf(maxy) + 1, tile[3]);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    // Edges go from their lower to their upper end point, so triangles sharing an edge see the same line.
+    for (i = 0; i < 3; i++) {
+        const NVGvertex* p = tri[i];
+        const NVGvertex* q = tri[(i + 1) % 3];
+        const NVGvertex* o = tri[(i + 2) % 3];
+        if (q->y < p->y || (q->y == p->y && q->x < p->x)) {
+            const NVGvertex* t = p;
+            p = q;
+            q = t;
+        }
+        ex[i] = p->x;
+        ey[i] = p->y;
+        dx[i] = q->x - p->x;
+        dy[i] = q->y - p->y;
+        // Side of the edge the triangle lies on, x side for slanted edges and y side for horizontal ones.
+        if (dy[i] != 0.0f) {
+            inside[i] = (o->x > p->x + dx[i] * (o->y - p->y) / dy[i]) ? 1 : -1;
+        } else {
+            inside[i] = o->y > p->y ? 1 : -1;
+        }
+    }
+
+    dudx = ((b->u - a->u)*(c->y - a->y) - (c->u - a->u)*(b->y - a->y)) / area;
+    dudy = ((c->u - a->u)*(b->x - a->x) - (b->u - a->u)*(c->x - a->x)) / area;
+    dvdx = ((b->v - a->v)*(c->y - a->y) - (c->v - a->v)*(b->y - a->y)) / area;
+    dvdy = ((c->v - a->v)*(b->x - a->x) - (b->v - a->v)*(c->x - a->x)) / area;
+    span.dudx = dudx;
+    span.dvdx = dvdx;
+    span.dudy = dudy;
+    span.dvdy = dvdy;
+
+    for (y = y0; y < y1; y++) {
+        const float py = (float)y + 0.5f;
+        int lo = x0, hi = x1;
+
+        for (i = 0; i < 3 && lo < hi; i++) {
+            if (dy[i] == 0.0f) {
+                // Centers on the line belong to the triangle below it.
+                if (inside[i] > 0 ? py < ey[i] : py >= ey[i]) lo = hi;
+            } else {
+                const float xt = ex[i] + dx[i] * (py - ey[i]) / dy[i] - 0.5f;
+                const int xe = (int)ceilf(xt);
+                if (inside[i] > 0) {
+                    lo = swnvg__maxi(lo, xe);   // x + 0.5 >= crossing
+                } else {
+                    hi = swnvg__mini(hi, xe);   // x + 0.5 < crossing
+                }
+            }
+        }
+        if (lo >= hi) continue;
+
+        span.x0 = lo;
+        span.x1 = hi;
+        span.y = y;
+        span.u = a->u + dudx * ((float)lo + 0.5f - a->x) + dudy * (py - a->y);
+        span.v = a->v + dvdx * ((float)lo + 0.5f - a->x) + dvdy * (py - a->y);
+        swnvg__fillSpan(sw, pass, &span);
+    }
+}
+
+static void swnvg__drawArrays(SWNVGcontext* sw, const SWNVGpass* pass, const int* tile, int primitive, int offset, int count) {
+    const NVGvertex* v = &sw->verts[offset];
+    int i;
+
+    if (primitive == SWNVG_FAN) {
+        for (i = 2; i < count; i++) swnvg__rasterTriangle(sw, pass, tile, &v[0], &v[i - 1], &v[i]);
+    } else if (primitive == SWNVG_STRIP) {
+        // Every other strip triangle is flipped to keep the winding.
+        for (i = 2; i < count; i++) {
+            if (i & 1) swnvg__rasterTriangle(sw, pass, tile, &v[i - 1], &v[i - 2], &v[i]);
+            else swnvg__rasterTriangle(sw, pass, tile, &v[i - 2], &v[i - 1], &v[i]);
+        }
+    } else {
+        for (i = 0; i + 2 < count; i += 3) swnvg__rasterTriangle(sw, pass, tile, &v[i], &v[i + 1], &v[i + 2]);
+    }
+}
+
+static void swnvg__setPass(SWNVGcontext* sw, SWNVGpass* pass, const SWNVGcall* call, int uniform,
+                           int colorWrite, int cull, int stencilTest, int stencilOp) {
+    pass->frag = &sw->uniforms[uniform];
+    pass->tex = call->image != 0 ? swnvg__findTexture(sw, call->image) : NULL;
+    pass->blend = call->blendFunc;
+    pass->colorWrite = colorWrite;
+    pass->cull = cull;
+    pass->stencilTest = stencilTest;
+    pass->stencilOp = stencilOp;
+}
+
+// Same passes as DkRenderer::DrawFill.
+static void swnvg__drawFill(SWNVGcontext* sw, const SWNVGcall* call, const int* tile) {
+    const SWNVGpath* paths = &sw->paths[call->pathOffset];
+    SWNVGpass pass;
+    int i;
+
+    swnvg__setPass(sw, &pass, call, call->uniformOffset, 0, 0, SWNVG_TEST_ALWAYS, SWNVG_OP_WINDING);
+    for (i = 0; i < call->pathCount; i++) swnvg__drawArrays(sw, &pass, tile, SWNVG_FAN, paths[i].fillOffset, paths[i].fillCount);
+
+    swnvg__setPass(sw, &pass, call, call->uniformOffset + 1, 1, 1, SWNVG_TEST_EQUAL, SWNVG_OP_KEEP);
+    if (sw->flags & NVGSW_ANTIALIAS) {
+        for (i = 0; i < call->pathCount; i++) swnvg__drawArrays(sw, &pass, tile, SWNVG_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+    }
+
+    pass.stencilTest = SWNVG_TEST_NOTEQUAL;
+    pass.stencilOp = SWNVG_OP_ZERO;
+    swnvg__drawArrays(sw, &pass, tile, SWNVG_STRIP, call->triangleOffset, call->triangleCount);
+}
+
+static void swnvg__drawConvexFill(SWNVGcontext* sw, const SWNVGcall* call, const int* tile) {
+    const SWNVGpath* paths = &sw->paths[call->pathOffset];
+    SWNVGpass pass;
+    int i;
+
+    swnvg__setPass(sw, &pass, call, call->uniformOffset, 1, 1, SWNVG_TEST_ALWAYS, SWNVG_OP_KEEP);
+    for (i = 0; i < call->pathCount; i++) {
+        swnvg__drawArrays(sw, &pass, tile, call->fillPrimitive, paths[i].fillOffset, paths[i].fillCount);
+        // Draw fringes
+        swnvg__drawArrays(sw, &pass, tile, SWNVG_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+    }
+}
+
+// Same passes as DkRenderer::DrawStroke.
+static void swnvg__drawStroke(SWNVGcontext* sw, const SWNVGcall* call, const int* tile) {
+    const SWNVGpath* paths = &sw->paths[call->pathOffset];
+    SWNVGpass pass;
+    int i;
+
+    if (sw->flags & NVGSW_STENCIL_STROKES) {
+        // Fill the stroke base without overlap.
+        swnvg__setPass(sw, &pass, call, call->uniformOffset + 1, 1, 1, SWNVG_TEST_EQUAL, SWNVG_OP_INCR);
+        for (i = 0; i < call->pathCount; i++) swnvg__drawArrays(sw, &pass, tile, SWNVG_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+
+        // Draw anti-aliased pixels.
+        swnvg__setPass(sw, &pass, call, call->uniformOffset, 1, 1, SWNVG_TEST_EQUAL, SWNVG_OP_KEEP);
+        for (i = 0; i < call->pathCount; i++) swnvg__drawArrays(sw, &pass, tile, SWNVG_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+
+        // Clear the stencil buffer.
+        swnvg__setPass(sw, &pass, call, call->uniformOffset, 0, 1, SWNVG_TEST_ALWAYS, SWNVG_OP_ZERO);
+        for (i = 0; i < call->pathCount; i++) swnvg__drawArrays(sw, &pass, tile, SWNVG_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+    } else {
+        swnvg__setPass(sw, &pass, call, call->uniformOffset, 1, 1, SWNVG_TEST_ALWAYS, SWNVG_OP_KEEP);
+        for (i = 0; i < call->pathCount; i++) swnvg__drawArrays(sw, &pass, tile, SWNVG_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+    }
+}
+
+static void swnvg__drawTriangles(SWNVGcontext* sw, const SWNVGcall* call, const int* tile) {
+    SWNVGpass pass;
+    swnvg__setPass(sw, &pass, call, call->uniformOffset, 1, 1, SWNVG_TEST_ALWAYS, SWNVG_OP_KEEP);
+    swnvg__drawArrays(sw, &pass, tile, SWNVG_LIST, call->triangleOffset, call->triangleCount);
+}
+
+static void swnvg__rasterTile(void* arg, int index, int worker) {
+    SWNVGcontext* sw = (SWNVGcontext*)arg;
+    const int columns = (sw->width + SWNVG_TILE_SIZE - 1) / SWNVG_TILE_SIZE;
+    int tile[4], i;
+    (void)worker;
+
+    tile[0] = (index % columns) * SWNVG_TILE_SIZE;
+    tile[1] = (index / columns) * SWNVG_TILE_SIZE;
+    tile[2] = swnvg__mini(tile[0] + SWNVG_TILE_SIZE, sw->width);
+    tile[3] = swnvg__mini(tile[1] + SWNVG_TILE_SIZE, sw->height);
+
+    for (i = 0; i < sw->ncalls; i++) {
+        const SWNVGcall* call = &sw->calls[i];
+        if (call->bounds[0] >= tile[2] || call->bounds[2] <= tile[0] || call->bounds[1] >= tile[3] || call->bounds[3] <= tile[1])
+            continue;
+
+        if (call->type == SWNVG_FILL) {
+            swnvg__drawFill(sw, call, tile);
+        } else if (call->type == SWNVG_CONVEXFILL) {
+            swnvg__drawConvexFill(sw, call, tile);
+        } else if (call->type == SWNVG_STROKE) {
+            swnvg__drawStroke(sw, call, tile);
+        } else if (call->type == SWNVG_TRIANGLES) {
+            swnvg__drawTriangles(sw, call, tile);
+        }
+    }
+}
+
+static void swnvg__renderFlush(void* uptr) {
+    SWNVGcontext* sw = (SWNVGcontext*)uptr;
+    const int columns = (sw->width + SWNVG_TILE_SIZE - 1) / SWNVG_TILE_SIZE;
+    const int rows = (sw->height + SWNVG_TILE_SIZE - 1) / SWNVG_TILE_SIZE;
+    int i;
+
+    if (sw->ncalls > 0 && sw->pixels != NULL) {
+        if (sw->workers.parallelFor != NULL) {
+            sw->workers.parallelFor(sw->workers.userPtr, columns * rows, swnvg__rasterTile, sw);
+        } else {
+            for (i = 0; i < columns * rows; i++) swnvg__rasterTile(sw, i, 0);
+        }
+    }
+
+    // Reset calls
+    sw->nverts = 0;
+    sw->npaths = 0;
+    sw->ncalls = 0;
+    sw->nuniforms = 0;
+}
+
+static void swnvg__renderDelete(void* uptr) {
+    SWNVGcontext* sw = (SWNVGcontext*)uptr;
+    int i;
+    if (sw == NULL) return;
+
+    for (i = 0; i < sw->ntextures; i++) free(sw->textures[i].data);
+    free(sw->textures);
+    free(sw->pixels);
+    free(sw->stencil);
+    free(sw->paths);
+    free(sw->verts);
+    free(sw->uniforms);
+    free(sw->calls);
+
+    free(sw);
+}
+
+NVGcontext* nvgCreateSw(int flags) {
+    NVGparams params;
+    NVGcontext* ctx = NULL;
+    SWNVGcontext* sw = (SWNVGcontext*)malloc(sizeof(SWNVGcontext));
+    if (sw == NULL) goto error;
+    memset(sw, 0, sizeof(SWNVGcontext));
+
+    memset(&params, 0, sizeof(params));
+    params.renderCreate = swnvg__renderCreate;
+    params.renderCreateTexture = swnvg__renderCreateTexture;
+    params.renderDeleteTexture = swnvg__renderDeleteTexture;
+    params.renderUpdateTexture = swnvg__renderUpdateTexture;
+    params.renderGetTextureSize = swnvg__renderGetTextureSize;
+    params.renderViewport = swnvg__renderViewport;
+    params.renderCancel = swnvg__renderCancel;
+    params.renderFlush = swnvg__renderFlush;
+    params.renderFill = swnvg__renderFill;
+    params.renderStroke = swnvg__renderStroke;
+    params.renderTriangles = swnvg__renderTriangles;
+    params.renderFillRect = swnvg__renderFillRect;
+    params.triangulateFills = 1;
+    params.sdfText = flags & NVGSW_SDF_TEXT ? 1 : 0;
+    params.renderDelete = swnvg__renderDelete;
+    params.userPtr = sw;
+    params.edgeAntiAlias = flags & NVGSW_ANTIALIAS ? 1 : 0;
+
+    sw->flags = flags;
+
+    ctx = nvgCreateInternal(&params);
+    if (ctx == NULL) goto error;
+
+    return ctx;
+
+error:
+    // 'sw' is freed by nvgDeleteInternal.
+    if (ctx != NULL) nvgDeleteInternal(ctx);
+    return NULL;
+}
+
+void nvgDeleteSw(NVGcontext* ctx) {
+    nvgDeleteInternal(ctx);
+}
+
+void nvgSwSetWorkers(NVGcontext* ctx, const NVGworkers* workers) {
+    SWNVGcontext* sw = swnvg__context(ctx);
+    if (workers != NULL) {
+        sw->workers = *workers;
+    } else {
+        memset(&sw->workers, 0, sizeof(sw->workers));
+    }
+}
+
+void nvgSwClearColor(NVGcontext* ctx, NVGcolor color) {
+    swnvg__context(ctx)->clearColor = color;
+}
+
+const unsigned char* nvgSwFramebuffer(NVGcontext* ctx, int* width, int* height) {
+    SWNVGcontext* sw = swnvg__context(ctx);
+    *width = sw->width;
+    *height = sw->height;
+    return (const unsigned char*)sw->pixels;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -86,38 +86,28 @@ NVGcolor getColour(Colour c) {
 }
 
 void drawRect(NVGcontext* vg, float x, float y, float w, float h, Colour c) {
-    nvgBeginPath(vg);
-    nvgRect(vg, x, y, w, h);
     nvgFillColor(vg, getColour(c));
-    nvgFill(vg);
+    nvgFillRect(vg, x, y, w, h);
 }
 
 void drawRect(NVGcontext* vg, float x, float y, float w, float h, const NVGcolor& c) {
-    nvgBeginPath(vg);
-    nvgRect(vg, x, y, w, h);
     nvgFillColor(vg, c);
-    nvgFill(vg);
+    nvgFillRect(vg, x, y, w, h);
 }
 
 void drawRect(NVGcontext* vg, float x, float y, float w, float h, const NVGcolor&& c) {
-    nvgBeginPath(vg);
-    nvgRect(vg, x, y, w, h);
     nvgFillColor(vg, c);
-    nvgFill(vg);
+    nvgFillRect(vg, x, y, w, h);
 }
 
 void drawRect(NVGcontext* vg, float x, float y, float w, float h, const NVGpaint& p) {
-    nvgBeginPath(vg);
-    nvgRect(vg, x, y, w, h);
     nvgFillPaint(vg, p);
-    nvgFill(vg);
+    nvgFillRect(vg, x, y, w, h);
 }
 
 void drawRect(NVGcontext* vg, float x, float y, float w, float h, const NVGpaint&& p) {
-    nvgBeginPath(vg);
-    nvgRect(vg, x, y, w, h);
     nvgFillPaint(vg, p);
-    nvgFill(vg);
+    nvgFillRect(vg, x, y, w, h);
 }
 
 void drawText(NVGcontext* vg, float x, float y, float size, const char* str, const char* end, int align, Colour c) {
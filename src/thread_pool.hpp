@@ -0,0 +1,172 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <latch>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __SWITCH__
+#include <switch.h>
+#endif
+
+namespace util {
+
+// fixed set of threads that run a parallel for, the calling thread joins in as worker 0.
+// only one parallel_for may run at a time.
+// on the switch the threads run on cores 1 and 2, the calling thread is expected on core 0.
+// the threads also run background jobs, a parallel_for is picked up first.
+class ThreadPool {
+public:
+    using Task = void(*)(void* arg, int index, int worker);
+    using Job = void(*)(void* arg);
+
+    explicit ThreadPool(unsigned thread_count) {
+        this->threads.reserve(thread_count);
+#ifdef __SWITCH__
+        // libnx creates threads on core 0 next to the caller, and threads of the same priority
+        // on one core are not time-sliced, so the workers would only run while the caller blocks.
+        // each worker moves itself to its own core, waiting here gives them core 0 to do that.
+        std::latch placed{static_cast<std::ptrdiff_t>(thread_count)};
+#endif
+        for (unsigned i = 0; i < thread_count; i++) {
+            this->threads.emplace_back([&, i](std::stop_token stop_token){
+#ifdef __SWITCH__
+                const s32 core = 1 + static_cast<s32>(i % 2);
+                svcSetThreadCoreMask(CUR_THREAD_HANDLE, core, 1U << core);
+                placed.count_down();
+#endif
+                this->Loop(stop_token, static_cast<int>(i) + 1);
+            });
+        }
+#ifdef __SWITCH__
+        placed.wait();
+#endif
+    }
+
+    ~ThreadPool() {
+        for (auto& thread : this->threads) {
+            thread.request_stop();
+        }
+        this->work_cv.notify_all();
+
+        // join before the members the threads wait on are destroyed.
+        this->threads.clear();
+    }
+
+    // disable copying
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // number of workers, including the calling thread.
+    [[nodiscard]]
+    auto size() const noexcept -> int {
+        return static_cast<int>(this->threads.size()) + 1;
+    }
+
+    // runs task(arg, i, worker) for every i in [0, n) and returns once all have finished.
+    void parallel_for(int n, Task task, void* arg) {
+        if (n <= 0) {
+            return;
+        }
+
+        {
+            std::scoped_lock lock{this->mutex};
+            this->task = task;
+            this->arg = arg;
+            this->count = n;
+            this->next = 0;
+            this->done = 0;
+            this->generation++;
+        }
+        this->work_cv.notify_all();
+
+        this->Work(0);
+
+        // wait for the other workers to leave, so none of them picks up an index of the next run.
+        std::unique_lock lock{this->mutex};
+        this->done_cv.wait(lock, [this]{
+            return this->done == this->count && this->active == 0;
+        });
+    }
+
+    // runs job(arg) on one of the threads and returns without waiting for it.
+    // jobs still queued when the pool is destroyed are run before the destructor returns.
+    void submit(Job job, void* arg) {
+        {
+            std::scoped_lock lock{this->mutex};
+            this->jobs.emplace_back(job, arg);
+        }
+        this->work_cv.notify_one();
+    }
+
+private:
+    void Loop(std::stop_token stop_token, int worker) {
+        unsigned seen = 0;
+        while (true) {
+            {
+                std::unique_lock lock{this->mutex};
+                if (!this->work_cv.wait(lock, stop_token, [this, seen]{ return this->generation != seen || !this->jobs.empty(); })) {
+                    return;
+                }
+
+                if (this->generation == seen) {
+                    const auto [job, arg] = this->jobs.front();
+                    this->jobs.pop_front();
+                    lock.unlock();
+                    job(arg);
+                    continue;
+                }
+
+                seen = this->generation;
+                this->active++;
+            }
+
+            this->Work(worker);
+
+            {
+                std::scoped_lock lock{this->mutex};
+                this->active--;
+            }
+            this->done_cv.notify_one();
+        }
+    }
+
+    void Work(int worker) {
+        while (true) {
+            const int i = this->next.fetch_add(1);
+            if (i >= this->count) {
+                break;
+            }
+
+            this->task(this->arg, i, worker);
+
+            if (this->done.fetch_add(1) + 1 == this->count) {
+                // take the lock so the wakeup can't slip in between the waiter's check and sleep.
+                std::scoped_lock lock{this->mutex};
+                this->done_cv.notify_one();
+            }
+        }
+    }
+
+private:
+    std::vector<std::jthread> threads{};
+    std::mutex mutex{};
+    std::condition_variable_any work_cv{};
+    std::condition_variable done_cv{};
+
+    Task task{};
+    void* arg{};
+    int count{};
+    unsigned generation{};
+    int active{};
+    std::atomic<int> next{};
+    std::atomic<int> done{};
+    std::deque<std::pair<Job, void*>> jobs{};
+};
+
+} // namespace util
@@ -0,0 +1,123 @@
+// Host stand-in for the deko3d API the nanovg back-end uses, see tools/nvgdk.cpp. Only the types
+// and calls it touches are declared, dkstub.cpp implements them.
+#pragma once
+#include <stdint.h>
+#include <array>
+#include <initializer_list>
+#include <switch.h>
+typedef uint64_t DkGpuAddr;
+#define DK_GPU_ADDR_INVALID (~(DkGpuAddr)0)
+typedef uintptr_t DkCmdList;
+typedef uint64_t DkResHandle;
+typedef struct DkMemBlock_T* DkMemBlock;
+#define DK_CMDMEM_ALIGNMENT 4
+#define DK_SHADER_CODE_ALIGNMENT 0x100
+#define DK_SHADER_CODE_UNUSABLE_SIZE 0x80
+#define DK_MEMBLOCK_ALIGNMENT 0x1000
+#define DK_UNIFORM_BUF_ALIGNMENT 0x100
+#define DK_IMAGE_LINEAR_STRIDE_ALIGNMENT 32
+#define DK_IMAGE_DESCRIPTOR_ALIGNMENT 32
+#define DK_SAMPLER_DESCRIPTOR_ALIGNMENT 32
+enum DkResult { DkResult_Success, DkResult_Timeout };
+enum DkMemBlockFlags { DkMemBlockFlags_CpuUncached=1, DkMemBlockFlags_GpuCached=2, DkMemBlockFlags_Code=4, DkMemBlockFlags_Image=8, DkMemBlockFlags_CpuCached=16 };
+enum DkQueueFlags { DkQueueFlags_Graphics = 1 };
+enum DkStage { DkStage_Vertex, DkStage_Fragment };
+enum DkStageFlag { DkStageFlag_GraphicsMask = 0x1f };
+enum DkPrimitive { DkPrimitive_Triangles, DkPrimitive_TriangleStrip, DkPrimitive_TriangleFan };
+enum DkIdxFormat { DkIdxFormat_Uint8, DkIdxFormat_Uint16, DkIdxFormat_Uint32 };
+enum DkFace { DkFace_None=0, DkFace_Front=1, DkFace_Back=2, DkFace_FrontAndBack=3 };
+enum DkCompareOp { DkCompareOp_Never, DkCompareOp_Less, DkCompareOp_Equal, DkCompareOp_Lequal, DkCompareOp_Greater, DkCompareOp_NotEqual, DkCompareOp_Gequal, DkCompareOp_Always };
+enum DkStencilOp { DkStencilOp_Keep, DkStencilOp_Zero, DkStencilOp_Replace, DkStencilOp_Incr, DkStencilOp_Decr, DkStencilOp_Invert, DkStencilOp_IncrWrap, DkStencilOp_DecrWrap };
+enum DkBlendFactor { DkBlendFactor_Zero, DkBlendFactor_One, DkBlendFactor_SrcColor, DkBlendFactor_InvSrcColor, DkBlendFactor_SrcAlpha, DkBlendFactor_InvSrcAlpha, DkBlendFactor_DstAlpha, DkBlendFactor_InvDstAlpha, DkBlendFactor_DstColor, DkBlendFactor_InvDstColor, DkBlendFactor_SrcAlphaSaturate };
+enum DkBarrier { DkBarrier_None, DkBarrier_Tiles, DkBarrier_Fragments, DkBarrier_Primitives, DkBarrier_Full };
+enum DkInvalidateFlags { DkInvalidateFlags_Shader=1, DkInvalidateFlags_Image=2, DkInvalidateFlags_Code=4, DkInvalidateFlags_Pool=8, DkInvalidateFlags_Zcull=16, DkInvalidateFlags_L2Cache=32, DkInvalidateFlags_Descriptors = 1|2|8 };
+enum DkImageFormat { DkImageFormat_R8_Unorm, DkImageFormat_RGBA8_Unorm, DkImageFormat_S8 };
+enum DkImageFlags { DkImageFlags_UsageRender=1, DkImageFlags_UsagePresent=2, DkImageFlags_HwCompression=4, DkImageFlags_PitchLinear=8 };
+enum DkFilter { DkFilter_Nearest, DkFilter_Linear };
+enum DkMipFilter { DkMipFilter_None, DkMipFilter_Nearest, DkMipFilter_Linear };
+enum DkWrapMode { DkWrapMode_Repeat, DkWrapMode_ClampToEdge };
+enum DkVtxAttribSize { DkVtxAttribSize_1x32, DkVtxAttribSize_2x32, DkVtxAttribSize_4x32, DkVtxAttribSize_1x16, DkVtxAttribSize_4x8 };
+enum DkVtxAttribType { DkVtxAttribType_Float, DkVtxAttribType_Uint, DkVtxAttribType_Sint, DkVtxAttribType_Unorm };
+enum DkColorMask { DkColorMask_RGBA = 15 };
+struct DkVtxBufferState { uint32_t stride; uint32_t divisor; };
+struct DkVtxAttribState { uint32_t bufferId : 5; uint32_t isFixed : 1; uint32_t offset : 14; uint32_t size : 6; uint32_t type : 3; uint32_t _pad : 2; uint32_t isBgra : 1; };
+struct DkImageRect { uint32_t x, y, z, width, height, depth; };
+struct DkCopyBuf { DkGpuAddr addr; uint32_t rowLength; uint32_t imageHeight; };
+struct DkViewport { float x, y, width, height, near, far; };
+struct DkScissor { uint32_t x, y, width, height; };
+struct DkImageDescriptor { uint32_t d[8]; };
+struct DkSamplerDescriptor { uint32_t d[8]; };
+struct DkFence { uint32_t d[8]; };
+struct DkShader { uint32_t d[32]; };
+struct DkImage { uint64_t d[16]; };
+struct DkImageLayout { uint64_t d[16]; };
+struct DkBlendState { uint32_t d; };
+inline DkResHandle dkMakeTextureHandle(uint32_t i, uint32_t s) { return i | (s << 20); }
+namespace dk {
+    struct Shader : DkShader {};
+    struct MemBlock { DkMemBlock h = nullptr; operator DkMemBlock() const { return h; } explicit operator bool() const { return h != nullptr; } void* getCpuAddr(); DkGpuAddr getGpuAddr(); void destroy(); };
+    struct MemBlockMaker { uint32_t size; template<class D> MemBlockMaker(D const&, uint32_t s) : size(s) {} MemBlockMaker& setFlags(uint32_t) { return *this; } MemBlock create(); };
+    struct Fence : DkFence { DkResult wait(int64_t timeout_ns = -1); };
+    struct Image : DkImage { void initialize(DkImageLayout const&, DkMemBlock, uint32_t); };
+    struct ImageLayout : DkImageLayout { uint64_t getSize() const; uint32_t getAlignment() const; };
+    struct ImageLayoutMaker { ImageLayoutMaker(struct Device); ImageLayoutMaker& setFlags(uint32_t); ImageLayoutMaker& setFormat(DkImageFormat); ImageLayoutMaker& setDimensions(uint32_t, uint32_t, uint32_t = 0); void initialize(ImageLayout&); };
+    struct ImageView { DkImage const* img; ImageView(DkImage const& i) : img(&i) {} };
+    struct ImageDescriptor : DkImageDescriptor { void initialize(DkImage const&, bool = false, bool = false); };
+    struct Sampler { Sampler& setFilter(DkFilter, DkFilter, DkMipFilter = DkMipFilter_None); Sampler& setWrapMode(DkWrapMode, DkWrapMode, DkWrapMode = DkWrapMode_Repeat); };
+    struct SamplerDescriptor : DkSamplerDescriptor { void initialize(Sampler const&); };
+    struct RasterizerState { RasterizerState& setCullMode(DkFace); };
+    struct ColorState { ColorState& setBlendEnable(uint32_t, bool); };
+    struct ColorWriteState { ColorWriteState& setMask(uint32_t, uint32_t); };
+    struct BlendState : DkBlendState { BlendState& setFactors(DkBlendFactor, DkBlendFactor, DkBlendFactor, DkBlendFactor); };
+    struct DepthStencilState {
+        DepthStencilState& setStencilTestEnable(bool);
+        DepthStencilState& setStencilFrontCompareOp(DkCompareOp); DepthStencilState& setStencilFrontFailOp(DkStencilOp); DepthStencilState& setStencilFrontDepthFailOp(DkStencilOp); DepthStencilState& setStencilFrontPassOp(DkStencilOp);
+        DepthStencilState& setStencilBackCompareOp(DkCompareOp); DepthStencilState& setStencilBackFailOp(DkStencilOp); DepthStencilState& setStencilBackDepthFailOp(DkStencilOp); DepthStencilState& setStencilBackPassOp(DkStencilOp);
+    };
+    struct Swapchain { };
+    struct CmdBuf {
+        void* h = nullptr;
+        explicit operator bool() const { return h != nullptr; }
+        void addMemory(DkMemBlock, uint32_t, uint32_t); DkCmdList finishList(); void clear(); void destroy();
+        void bindShaders(uint32_t, std::initializer_list<DkShader const*>);
+        void bindUniformBuffer(DkStage, uint32_t, DkGpuAddr, uint32_t);
+        void bindStorageBuffer(DkStage, uint32_t, DkGpuAddr, uint32_t);
+        void bindTextures(DkStage, uint32_t, DkResHandle);
+        void bindImageDescriptorSet(DkGpuAddr, uint32_t); void bindSamplerDescriptorSet(DkGpuAddr, uint32_t);
+        void bindRenderTargets(ImageView const*, ImageView const* = nullptr);
+        void bindRasterizerState(RasterizerState const&); void bindColorState(ColorState const&); void bindColorWriteState(ColorWriteState const&);
+        void bindBlendStates(uint32_t, std::initializer_list<DkBlendState const>);
+        void bindDepthStencilState(DepthStencilState const&);
+        template<size_t N> void bindVtxAttribState(std::array<DkVtxAttribState, N> const&);
+        template<size_t N> void bindVtxBufferState(std::array<DkVtxBufferState, N> const&);
+        void bindVtxBuffer(uint32_t, DkGpuAddr, uint32_t);
+        void bindIdxBuffer(DkIdxFormat, DkGpuAddr);
+        void setViewports(uint32_t, std::initializer_list<DkViewport const>);
+        void setScissors(uint32_t, std::initializer_list<DkScissor const>);
+        void setStencil(DkFace, uint8_t, uint8_t, uint8_t);
+        void clearColor(uint32_t, uint32_t, float, float, float, float); void clearDepthStencil(bool, float, uint8_t, uint8_t);
+        void draw(DkPrimitive, uint32_t, uint32_t, uint32_t, uint32_t);
+        void drawIndexed(DkPrimitive, uint32_t, uint32_t, uint32_t, int32_t, uint32_t);
+        void pushConstants(DkGpuAddr, uint32_t, uint32_t, uint32_t, const void*);
+        void pushData(DkGpuAddr, const void*, uint32_t);
+        void barrier(DkBarrier, uint32_t);
+        void signalFence(DkFence&, bool = false); void waitFence(DkFence&);
+        void copyBufferToImage(DkCopyBuf const&, ImageView const&, DkImageRect const&, uint32_t = 0);
+    };
+    struct UniqueCmdBuf : CmdBuf { UniqueCmdBuf() = default; UniqueCmdBuf(UniqueCmdBuf&&) = default; UniqueCmdBuf& operator=(UniqueCmdBuf&&) = default; ~UniqueCmdBuf(); };
+    struct Device { void* h; };
+    struct UniqueDevice : Device { explicit operator bool() const; };
+    struct Queue {
+        void* h = nullptr;
+        void submitCommands(DkCmdList); void waitIdle(); void flush();
+        void signalFence(DkFence&, bool = false); void waitFence(DkFence&);
+        int acquireImage(Swapchain); void presentImage(Swapchain, int);
+    };
+    struct UniqueQueue : Queue {};
+    struct UniqueSwapchain : Swapchain { explicit operator bool() const; void destroy(); };
+    struct DeviceMaker { UniqueDevice create(); };
+    struct QueueMaker { QueueMaker(Device); QueueMaker& setFlags(uint32_t); UniqueQueue create(); };
+    struct CmdBufMaker { CmdBufMaker(Device); UniqueCmdBuf create(); };
+    template<size_t N> struct SwapchainMaker { SwapchainMaker(Device, NWindow*, std::array<DkImage const*, N> const&); UniqueSwapchain create(); };
+    template<size_t N> SwapchainMaker(Device, NWindow*, std::array<DkImage const*, N> const&) -> SwapchainMaker<N>;
+}
@@ -0,0 +1,124 @@
+// Host stand-in for the deko3d calls the renderer makes. Memory blocks are malloc'd, command
+// buffers count what they would record into g_dk and keep only their copies, which run when the
+// list is submitted. The GPU is infinitely fast otherwise, so fences and waits return at once.
+#include <deko3d.hpp>
+#include <stdlib.h>
+#include <string.h>
+#include "framework/CShader.h"
+#include "dkstub.h"
+#include <vector>
+#include <map>
+
+struct Copy { const unsigned char* src; unsigned char* dst; uint32_t pitch, bpp; DkImageRect r; };
+static std::map<void*, std::vector<Copy>> s_recording;
+static std::map<DkCmdList, std::vector<Copy>> s_lists;
+static DkCmdList s_nextList = 1;
+static uintptr_t s_nextCmdBuf = 1;
+
+DkStats g_dk;
+DkImageInfo g_imageInfo[65536];
+
+namespace dk {
+    void* MemBlock::getCpuAddr() { return h; }
+    DkGpuAddr MemBlock::getGpuAddr() { return (DkGpuAddr)(uintptr_t)h; }
+    void MemBlock::destroy() { free(h); h = nullptr; }
+    MemBlock MemBlockMaker::create() { MemBlock m; m.h = (DkMemBlock)aligned_alloc(0x1000, (size + 0xfff) & ~0xfff); return m; }
+    DkResult Fence::wait(int64_t) { return DkResult_Success; }
+    void Image::initialize(DkImageLayout const& l, DkMemBlock m, uint32_t o) { d[0] = (uint64_t)(uintptr_t)((unsigned char*)m + o); d[1] = l.d[1]; d[2] = l.d[2]; }
+    uint64_t ImageLayout::getSize() const { return d[0]; }
+    uint32_t ImageLayout::getAlignment() const { return 0x100; }
+    static uint32_t s_w, s_h, s_bpp;
+    ImageLayoutMaker::ImageLayoutMaker(Device) {}
+    ImageLayoutMaker& ImageLayoutMaker::setFlags(uint32_t) { return *this; }
+    ImageLayoutMaker& ImageLayoutMaker::setFormat(DkImageFormat f) { s_bpp = f == DkImageFormat_RGBA8_Unorm ? 4 : 1; return *this; }
+    ImageLayoutMaker& ImageLayoutMaker::setDimensions(uint32_t w, uint32_t h, uint32_t) { s_w = w; s_h = h; return *this; }
+    void ImageLayoutMaker::initialize(ImageLayout& l) { memset(&l, 0, sizeof(l)); l.d[0] = (uint64_t)s_w * s_h * (s_bpp ? s_bpp : 4); l.d[1] = s_w; l.d[2] = s_bpp ? s_bpp : 4; }
+    void ImageDescriptor::initialize(DkImage const& img, bool, bool) { d[0] = ++g_dk.nextImage; g_imageInfo[d[0] & 65535] = DkImageInfo{ (unsigned char*)(uintptr_t)img.d[0], (unsigned)img.d[1], (unsigned)img.d[2] }; }
+    Sampler& Sampler::setFilter(DkFilter, DkFilter, DkMipFilter) { return *this; }
+    Sampler& Sampler::setWrapMode(DkWrapMode, DkWrapMode, DkWrapMode) { return *this; }
+    void SamplerDescriptor::initialize(Sampler const&) {}
+    RasterizerState& RasterizerState::setCullMode(DkFace) { return *this; }
+    ColorState& ColorState::setBlendEnable(uint32_t, bool) { return *this; }
+    ColorWriteState& ColorWriteState::setMask(uint32_t, uint32_t) { return *this; }
+    BlendState& BlendState::setFactors(DkBlendFactor, DkBlendFactor, DkBlendFactor, DkBlendFactor) { return *this; }
+    DepthStencilState& DepthStencilState::setStencilTestEnable(bool) { return *this; }
+    DepthStencilState& DepthStencilState::setStencilFrontCompareOp(DkCompareOp) { return *this; }
+    DepthStencilState& DepthStencilState::setStencilFrontFailOp(DkStencilOp) { return *this; }
+    DepthStencilState& DepthStencilState::setStencilFrontDepthFailOp(DkStencilOp) { return *this; }
+    DepthStencilState& DepthStencilState::setStencilFrontPassOp(DkStencilOp) { return *this; }
+    DepthStencilState& DepthStencilState::setStencilBackCompareOp(DkCompareOp) { return *this; }
+    DepthStencilState& DepthStencilState::setStencilBackFailOp(DkStencilOp) { return *this; }
+    DepthStencilState& DepthStencilState::setStencilBackDepthFailOp(DkStencilOp) { return *this; }
+    DepthStencilState& DepthStencilState::setStencilBackPassOp(DkStencilOp) { return *this; }
+
+    void CmdBuf::addMemory(DkMemBlock, uint32_t, uint32_t) {}
+    DkCmdList CmdBuf::finishList() { DkCmdList l = s_nextList++; s_lists[l] = std::move(s_recording[h]); s_recording[h].clear(); return l; }
+    void CmdBuf::clear() { s_recording[h].clear(); }
+    void CmdBuf::destroy() {}
+    void CmdBuf::bindShaders(uint32_t, std::initializer_list<DkShader const*>) {}
+    void CmdBuf::bindUniformBuffer(DkStage, uint32_t, DkGpuAddr, uint32_t) {}
+    void CmdBuf::bindStorageBuffer(DkStage, uint32_t, DkGpuAddr, uint32_t) {}
+    void CmdBuf::bindTextures(DkStage, uint32_t, DkResHandle h) { g_dk.textureBinds++; g_dk.lastTexture = (int)(h & 0xfffff); }
+    void CmdBuf::bindImageDescriptorSet(DkGpuAddr a, uint32_t n) { g_dk.imageSet = a; g_dk.imageSetCount = n; }
+    void CmdBuf::bindSamplerDescriptorSet(DkGpuAddr, uint32_t) {}
+    void CmdBuf::bindRenderTargets(ImageView const*, ImageView const*) {}
+    void CmdBuf::bindRasterizerState(RasterizerState const&) {}
+    void CmdBuf::bindColorState(ColorState const&) {}
+    void CmdBuf::bindColorWriteState(ColorWriteState const&) {}
+    void CmdBuf::bindBlendStates(uint32_t, std::initializer_list<DkBlendState const>) {}
+    void CmdBuf::bindDepthStencilState(DepthStencilState const&) {}
+    template<> void CmdBuf::bindVtxAttribState<3>(std::array<DkVtxAttribState, 3> const&) {}
+    template<> void CmdBuf::bindVtxBufferState<2>(std::array<DkVtxBufferState, 2> const&) {}
+    void CmdBuf::bindVtxBuffer(uint32_t, DkGpuAddr, uint32_t) {}
+    void CmdBuf::bindIdxBuffer(DkIdxFormat, DkGpuAddr) {}
+    void CmdBuf::setViewports(uint32_t, std::initializer_list<DkViewport const>) {}
+    void CmdBuf::setScissors(uint32_t, std::initializer_list<DkScissor const>) {}
+    void CmdBuf::setStencil(DkFace, uint8_t, uint8_t, uint8_t) {}
+    void CmdBuf::clearColor(uint32_t, uint32_t, float, float, float, float) {}
+    void CmdBuf::clearDepthStencil(bool, float, uint8_t, uint8_t) {}
+    static void recordDraw() {
+        if (g_dk.pendingUpdate) g_dk.staleDraws++;
+        g_dk.readSinceWait[g_dk.lastTexture & 4095] = 1;
+        g_dk.drawContent[g_dk.draws++ & 8191] = g_dk.descriptorContent[g_dk.lastTexture & 4095];
+    }
+    void CmdBuf::draw(DkPrimitive, uint32_t, uint32_t, uint32_t, uint32_t) { recordDraw(); }
+    void CmdBuf::drawIndexed(DkPrimitive, uint32_t, uint32_t, uint32_t, int32_t, uint32_t) { recordDraw(); }
+    void CmdBuf::pushConstants(DkGpuAddr, uint32_t, uint32_t, uint32_t, const void*) {}
+    void CmdBuf::pushData(DkGpuAddr a, const void* data, uint32_t size) {
+        if (a >= g_dk.imageSet && a < g_dk.imageSet + g_dk.imageSetCount * 32ull) {
+            unsigned desc = (unsigned)((a - g_dk.imageSet) / 32);
+            g_dk.descriptorUpdates++;
+            // Rewriting a descriptor draws may still read.
+            if (g_dk.readSinceWait[desc]) g_dk.hazards++;
+            g_dk.descriptorContent[desc] = *(const unsigned*)data;
+            g_dk.pendingUpdate = 1;
+        }
+        (void)size;
+    }
+    void CmdBuf::barrier(DkBarrier b, uint32_t flags) {
+        g_dk.barriers++;
+        if (b == DkBarrier_Fragments || b == DkBarrier_Full) memset(g_dk.readSinceWait, 0, sizeof(g_dk.readSinceWait));
+        if ((flags & DkInvalidateFlags_Descriptors) == DkInvalidateFlags_Descriptors) { g_dk.descriptorBarriers++; g_dk.pendingUpdate = 0; }
+    }
+    void CmdBuf::signalFence(DkFence&, bool) {}
+    void CmdBuf::waitFence(DkFence&) {}
+    void CmdBuf::copyBufferToImage(DkCopyBuf const& src, ImageView const& v, DkImageRect const& r, uint32_t) {
+        g_dk.copies++;
+        s_recording[h].push_back(Copy{ (const unsigned char*)(uintptr_t)src.addr, (unsigned char*)(uintptr_t)v.img->d[0], (uint32_t)v.img->d[1], (uint32_t)v.img->d[2], r });
+    }
+    UniqueCmdBuf::~UniqueCmdBuf() {}
+    void Queue::submitCommands(DkCmdList l) {
+        g_dk.submits++;
+        for (const Copy& c : s_lists[l]) {
+            for (uint32_t row = 0; row < c.r.height; row++)
+                memcpy(c.dst + ((c.r.y + row) * c.pitch + c.r.x) * c.bpp, c.src + row * c.r.width * c.bpp, c.r.width * c.bpp);
+        }
+        s_lists.erase(l);
+    }
+    void Queue::waitIdle() { g_dk.waitIdles++; }
+    void Queue::flush() {}
+    CmdBufMaker::CmdBufMaker(Device) {}
+    UniqueCmdBuf CmdBufMaker::create() { UniqueCmdBuf b; b.h = (void*)s_nextCmdBuf++; return b; }
+}
+
+bool CShader::load(CMemPool& pool, const char*) { m_codemem = pool.allocate(0x100, DK_SHADER_CODE_ALIGNMENT); return true; }
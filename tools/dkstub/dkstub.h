@@ -0,0 +1,27 @@
+// What the deko3d stand-in recorded, see dkstub.cpp.
+#pragma once
+
+struct DkStats {
+    // Per frame, cleared up to imageSet.
+    int barriers, descriptorBarriers, descriptorUpdates, staleDraws, pendingUpdate, hazards;
+    int draws, textureBinds, copies, submits, waitIdles;
+    // Content of the descriptor each draw read.
+    unsigned drawContent[8192];
+
+    // Persistent.
+    unsigned long long imageSet;
+    unsigned imageSetCount;
+    int lastTexture, nextImage;
+    // Every initialized image descriptor gets the next nextImage as its content.
+    unsigned descriptorContent[4096];
+    // Descriptors read by a draw since the last barrier that waited for fragments.
+    unsigned char readSinceWait[4096];
+};
+extern DkStats g_dk;
+
+// Memory behind the image of each descriptor content, to check the texels uploads leave there.
+struct DkImageInfo {
+    unsigned char* mem;
+    unsigned w, bpp;
+};
+extern DkImageInfo g_imageInfo[65536];
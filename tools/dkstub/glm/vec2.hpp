@@ -0,0 +1,3 @@
+// Host stand-in for glm, only the vector the deko3d back-end uses.
+#pragma once
+namespace glm { struct vec2 { float x, y; vec2() = default; template<class A, class B> vec2(A a, B b) : x((float)a), y((float)b) {} }; }
@@ -0,0 +1,22 @@
+// Host stand-in for the parts of libnx the deko3d back-end uses, see tools/nvgdk.cpp.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef u32 Result;
+
+#define R_FAILED(r) ((r) != 0)
+#define R_SUCCEEDED(r) ((r) == 0)
+#define NX_CONSTEXPR constexpr
+#define NX_INLINE static inline
+
+typedef struct NWindow NWindow;
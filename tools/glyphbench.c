@@ -0,0 +1,187 @@
+// Times stb_truetype glyph rasterization over the Latin, CJK and button glyph ranges the app draws.
+//
+// Builds on any host with a C11 compiler:
+//   cc -O2 -std=c11 -Isrc/nanovg -o glyphbench tools/glyphbench.c -lm
+// add -DSTBTT_NO_SIMD for the scalar rasterizer.
+//
+// Usage: glyphbench [-write <file> | -compare <file>] [repeat] <font> [font...]
+//
+// Fonts are TTF or OTF files, for example the Switch shared fonts once decrypted. Glyphs a font
+// lacks are skipped. -write saves every bitmap to a file, -compare checks the bitmaps against
+// such a file, so a SIMD build can be compared with a -DSTBTT_NO_SIMD one.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "stb_truetype.h"
+
+struct Range {
+    const char* name;
+    int first;
+    int last;
+};
+
+static const struct Range ranges[] = {
+    { "latin", 0x20, 0x17f },
+    { "cjk", 0x4e00, 0x55ff },
+    { "kana", 0x3040, 0x30ff },
+    { "buttons", 0xe000, 0xe1ff },
+};
+
+// Sizes of the list, header and dialog text.
+static const float sizes[] = { 24.0f, 28.0f, 36.0f };
+
+struct Output {
+    FILE* write;
+    unsigned char* compare;
+    long ncompare;
+    long offset;
+    long differing;
+    int maxDiff;
+};
+
+static unsigned char* bench__readFile(const char* path, long* size) {
+    FILE* fp = fopen(path, "rb");
+    unsigned char* data = NULL;
+    if (fp == NULL) return NULL;
+    if (fseek(fp, 0, SEEK_END) == 0 && (*size = ftell(fp)) > 0 && fseek(fp, 0, SEEK_SET) == 0) {
+        data = (unsigned char*)malloc(*size);
+        if (data != NULL && fread(data, 1, *size, fp) != (size_t)*size) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(fp);
+    return data;
+}
+
+static double bench__now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void bench__output(struct Output* out, const unsigned char* pixels, int n) {
+    int i, d;
+    if (out->write != NULL) fwrite(pixels, 1, n, out->write);
+    if (out->compare == NULL) return;
+    for (i = 0; i < n; i++) {
+        if (out->offset + i >= out->ncompare) {
+            out->differing += n - i;
+            break;
+        }
+        d = abs((int)pixels[i] - (int)out->compare[out->offset + i]);
+        if (d != 0) out->differing++;
+        if (d > out->maxDiff) out->maxDiff = d;
+    }
+    out->offset += n;
+}
+
+// Rasterizes every glyph of the range at every size, returns the number of glyphs.
+static int bench__range(const stbtt_fontinfo* font, const struct Range* range, int repeat, struct Output* out, double* seconds, long* pixels) {
+    static unsigned char bitmap[256 * 256];
+    int s, c, r, count = 0;
+    double start;
+
+    *seconds = 0;
+    *pixels = 0;
+    for (s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+        float scale = stbtt_ScaleForMappingEmToPixels(font, sizes[s]);
+        for (c = range->first; c <= range->last; c++) {
+            int g = stbtt_FindGlyphIndex(font, c);
+            int x0, y0, x1, y1, w, h;
+            if (g == 0) continue;
+            stbtt_GetGlyphBitmapBox(font, g, scale, scale, &x0, &y0, &x1, &y1);
+            w = x1 - x0;
+            h = y1 - y0;
+            if (w <= 0 || h <= 0 || w > 256 || h > 256) continue;
+
+            // Glyph shape, flattening and rasterization, like a fontstash glyph miss.
+            start = bench__now();
+            for (r = 0; r < repeat; r++) stbtt_MakeGlyphBitmap(font, bitmap, w, h, w, scale, scale, g);
+            *seconds += bench__now() - start;
+            *pixels += (long)w * h * repeat;
+            count++;
+            bench__output(out, bitmap, w * h);
+        }
+    }
+    return count;
+}
+
+int main(int argc, char** argv) {
+    struct Output out;
+    const char* write = NULL;
+    const char* compare = NULL;
+    int i, j, repeat = 10, failed = 0;
+
+    memset(&out, 0, sizeof(out));
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-write") == 0 && i + 1 < argc) {
+            write = argv[++i];
+        } else if (strcmp(argv[i], "-compare") == 0 && i + 1 < argc) {
+            compare = argv[++i];
+        } else if (argv[i][0] >= '0' && argv[i][0] <= '9') {
+            repeat = atoi(argv[i]);
+        } else {
+            break;
+        }
+    }
+
+    if (i == argc || repeat < 1 || (write != NULL && compare != NULL)) {
+        fprintf(stderr, "usage: %s [-write <file> | -compare <file>] [repeat] <font> [font...]\n", argv[0]);
+        return 1;
+    }
+    if (write != NULL && (out.write = fopen(write, "wb")) == NULL) {
+        fprintf(stderr, "failed to open %s\n", write);
+        return 1;
+    }
+    if (compare != NULL && (out.compare = bench__readFile(compare, &out.ncompare)) == NULL) {
+        fprintf(stderr, "failed to read %s\n", compare);
+        return 1;
+    }
+
+#ifdef STBTT_NO_SIMD
+    printf("scalar rasterizer, %d repeats\n", repeat);
+#else
+    printf("default rasterizer, %d repeats\n", repeat);
+#endif
+    printf("%-10s %7s %10s %10s\n", "range", "glyphs", "us/glyph", "Mpix/s");
+    for (; i < argc; i++) {
+        stbtt_fontinfo font;
+        long size;
+        unsigned char* data = bench__readFile(argv[i], &size);
+        if (data == NULL || !stbtt_InitFont(&font, data, stbtt_GetFontOffsetForIndex(data, 0))) {
+            fprintf(stderr, "failed to load %s\n", argv[i]);
+            free(data);
+            failed = 1;
+            continue;
+        }
+        printf("%s\n", argv[i]);
+        for (j = 0; j < (int)(sizeof(ranges) / sizeof(ranges[0])); j++) {
+            double seconds;
+            long pixels;
+            int count = bench__range(&font, &ranges[j], repeat, &out, &seconds, &pixels);
+            if (count == 0) {
+                printf("%-10s %7d\n", ranges[j].name, 0);
+                continue;
+            }
+            printf("%-10s %7d %10.2f %10.1f\n", ranges[j].name, count, seconds * 1e6 / ((double)count * repeat), pixels / seconds * 1e-6);
+        }
+        free(data);
+    }
+
+    if (out.write != NULL && fclose(out.write) != 0) {
+        fprintf(stderr, "failed to write %s\n", write);
+        return 1;
+    }
+    if (out.compare != NULL) {
+        if (out.offset != out.ncompare) out.differing += labs(out.ncompare - out.offset);
+        printf("%ld of %ld pixels differ, max difference %d\n", out.differing, out.offset, out.maxDiff);
+        free(out.compare);
+        if (out.differing > 0 && out.maxDiff > 1) failed = 2;
+    }
+    return failed;
+}
@@ -0,0 +1,168 @@
+// Times stb_image JPEG decoding of title icons the way the app loads them, to RGBA.
+//
+// Builds on any host with a C11 compiler:
+//   cc -O2 -std=c11 -Isrc/nanovg -o jpegbench tools/jpegbench.c -lm
+// add -DSTBI_NO_SIMD for the scalar decoder, -DSTBI_NEON on aarch64 like the Makefile.
+//
+// Usage: jpegbench [-write <file> | -compare <file>] [repeat] <jpeg> [jpeg...]
+//
+// Icons can be dumped from the control data of installed titles, any JPEG works. -write saves
+// every decoded image to a file, -compare checks the images against such a file, so a SIMD
+// build can be compared with a -DSTBI_NO_SIMD one.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STBI_ONLY_JPEG
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+struct Output {
+    FILE* write;
+    unsigned char* compare;
+    long ncompare;
+    long offset;
+    long differing;
+    int maxDiff;
+};
+
+static unsigned char* bench__readFile(const char* path, long* size) {
+    FILE* fp = fopen(path, "rb");
+    unsigned char* data = NULL;
+    if (fp == NULL) return NULL;
+    if (fseek(fp, 0, SEEK_END) == 0 && (*size = ftell(fp)) > 0 && fseek(fp, 0, SEEK_SET) == 0) {
+        data = (unsigned char*)malloc(*size);
+        if (data != NULL && fread(data, 1, *size, fp) != (size_t)*size) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(fp);
+    return data;
+}
+
+static double bench__now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void bench__output(struct Output* out, const unsigned char* pixels, long n) {
+    long i;
+    int d;
+    if (out->write != NULL) fwrite(pixels, 1, n, out->write);
+    if (out->compare == NULL) return;
+    for (i = 0; i < n; i++) {
+        if (out->offset + i >= out->ncompare) {
+            out->differing += n - i;
+            break;
+        }
+        d = abs((int)pixels[i] - (int)out->compare[out->offset + i]);
+        if (d != 0) out->differing++;
+        if (d > out->maxDiff) out->maxDiff = d;
+    }
+    out->offset += n;
+}
+
+int main(int argc, char** argv) {
+    struct Output out;
+    const char* write = NULL;
+    const char* compare = NULL;
+    int i, r, repeat = 100, failed = 0, count = 0;
+    double total = 0, worst = 0;
+    long inBytes = 0, outBytes = 0;
+
+    memset(&out, 0, sizeof(out));
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-write") == 0 && i + 1 < argc) {
+            write = argv[++i];
+        } else if (strcmp(argv[i], "-compare") == 0 && i + 1 < argc) {
+            compare = argv[++i];
+        } else if (argv[i][0] >= '0' && argv[i][0] <= '9') {
+            repeat = atoi(argv[i]);
+        } else {
+            break;
+        }
+    }
+
+    if (i == argc || repeat < 1 || (write != NULL && compare != NULL)) {
+        fprintf(stderr, "usage: %s [-write <file> | -compare <file>] [repeat] <jpeg> [jpeg...]\n", argv[0]);
+        return 1;
+    }
+    if (write != NULL && (out.write = fopen(write, "wb")) == NULL) {
+        fprintf(stderr, "failed to open %s\n", write);
+        return 1;
+    }
+    if (compare != NULL && (out.compare = bench__readFile(compare, &out.ncompare)) == NULL) {
+        fprintf(stderr, "failed to read %s\n", compare);
+        return 1;
+    }
+
+#if defined(STBI_SSE2)
+    printf("SSE2 decoder, %d repeats\n", repeat);
+#elif defined(STBI_NEON)
+    printf("NEON decoder, %d repeats\n", repeat);
+#else
+    printf("scalar decoder, %d repeats\n", repeat);
+#endif
+    printf("%-40s %9s %10s %10s %10s\n", "file", "size", "us/image", "best us", "MB/s");
+    for (; i < argc; i++) {
+        unsigned char* pixels = NULL;
+        double best = 1e9, sum = 0, start, seconds;
+        long size;
+        int w = 0, h = 0, n;
+        unsigned char* data = bench__readFile(argv[i], &size);
+        if (data == NULL) {
+            fprintf(stderr, "failed to read %s\n", argv[i]);
+            failed = 1;
+            continue;
+        }
+
+        for (r = 0; r < repeat; r++) {
+            // Same call as nvgCreateImageMem(), the allocation is part of the cost.
+            start = bench__now();
+            pixels = stbi_load_from_memory(data, (int)size, &w, &h, &n, 4);
+            seconds = bench__now() - start;
+            if (pixels == NULL) break;
+            sum += seconds;
+            if (seconds < best) best = seconds;
+            if (seconds > worst) worst = seconds;
+            if (r + 1 < repeat) stbi_image_free(pixels);
+        }
+        if (pixels == NULL) {
+            fprintf(stderr, "failed to decode %s: %s\n", argv[i], stbi_failure_reason());
+            free(data);
+            failed = 1;
+            continue;
+        }
+
+        // MB/s of decoded RGBA, the unit the upload path cares about.
+        printf("%-40s %4dx%-4d %10.1f %10.1f %10.1f\n", argv[i], w, h, sum * 1e6 / repeat, best * 1e6,
+               (double)w * h * 4 * repeat / sum * 1e-6);
+        bench__output(&out, pixels, (long)w * h * 4);
+        stbi_image_free(pixels);
+        free(data);
+        total += sum;
+        inBytes += size * repeat;
+        outBytes += (long)w * h * 4 * repeat;
+        count++;
+    }
+
+    if (count > 0) {
+        printf("%d images, %.1f us/image, worst %.1f us, %.1f MB/s in, %.1f MB/s out\n", count, total * 1e6 / ((double)count * repeat),
+               worst * 1e6, inBytes / total * 1e-6, outBytes / total * 1e-6);
+    }
+    if (out.write != NULL && fclose(out.write) != 0) {
+        fprintf(stderr, "failed to write %s\n", write);
+        return 1;
+    }
+    if (out.compare != NULL) {
+        if (out.offset != out.ncompare) out.differing += labs(out.ncompare - out.offset);
+        printf("%ld of %ld bytes differ, max difference %d\n", out.differing, out.offset, out.maxDiff);
+        free(out.compare);
+        if (out.differing > 0) failed = 2;
+    }
+    return failed;
+}
@@ -0,0 +1,190 @@
+// Counts the heap calls nanovg makes per frame and fails if a steady-state frame makes any.
+//
+// Builds on any host with a C11 compiler, nanovg.c is compiled into the tool so its allocations
+// can be counted:
+//   cc -O2 -std=c11 -Isrc/nanovg -o nvgalloc tools/nvgalloc.c -lm
+//
+// Usage: nvgalloc [frames] [font]
+//
+// A list frame like the app's is drawn on the counting null back-end, with tessellation on
+// the calling thread and deferred to workers. The first frames warm up the caches and the
+// buffers, every frame after them must not touch the heap. Text is only drawn when a TTF or
+// OTF font is given.
+
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <memory.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Every header nanovg pulls in is included above, so only its own calls are renamed.
+static long alloc__calls;
+
+static void* alloc__malloc(size_t size) {
+    alloc__calls++;
+    return malloc(size);
+}
+
+static void* alloc__realloc(void* ptr, size_t size) {
+    alloc__calls++;
+    return realloc(ptr, size);
+}
+
+static void alloc__free(void* ptr) {
+    if (ptr != NULL) alloc__calls++;
+    free(ptr);
+}
+
+#define malloc(size) alloc__malloc(size)
+#define realloc(ptr, size) alloc__realloc(ptr, size)
+#define free(ptr) alloc__free(ptr)
+
+#include "nanovg.c"
+#include "nanovg_null.h"
+
+#define ALLOC_WARMUP_FRAMES 4
+
+static void alloc__parallelFor(void* uptr, int n, void (*func)(void* arg, int index, int worker), void* arg) {
+    int i;
+    (void)uptr;
+    // Spread over three workers like the app's pool, the order does not matter to nanovg.
+    for (i = 0; i < n; i++) func(arg, i, i % 3);
+}
+
+static void alloc__async(void* uptr, void (*func)(void* arg), void* arg) {
+    (void)uptr;
+    func(arg);
+}
+
+static void alloc__drawFrame(NVGcontext* vg, int font, int icon, int frame) {
+    char buf[64];
+    int i;
+
+    nvgBeginFrame(vg, 1280, 720, 1.0f);
+
+    // Background and separators.
+    nvgBeginPath(vg);
+    nvgRect(vg, 0, 0, 1280, 720);
+    nvgFillColor(vg, nvgRGB(45, 45, 45));
+    nvgFill(vg);
+    nvgFillColor(vg, nvgRGB(80, 80, 80));
+    nvgFillRect(vg, 30, 86, 1220, 1);
+    nvgFillRect(vg, 30, 646, 1220, 1);
+
+    for (i = 0; i < 8; i++) {
+        const float y = 110.0f + i * 62.0f;
+        NVGpaint paint = nvgImagePattern(vg, 100, y, 56, 56, 0, icon, 1.0f);
+
+        // Row, selection outline and icon.
+        nvgBeginPath(vg);
+        nvgRoundedRect(vg, 90, y - 4, 1100, 60, 6);
+        nvgFillColor(vg, nvgRGB(55, 55, 55));
+        nvgFill(vg);
+        if (i == frame % 8) {
+            nvgStrokeColor(vg, nvgRGB(0, 255, 200));
+            nvgStrokeWidth(vg, 3);
+            nvgStroke(vg);
+        }
+        nvgBeginPath(vg);
+        nvgRect(vg, 100, y, 56, 56);
+        nvgFillPaint(vg, paint);
+        nvgFill(vg);
+
+        // Tick mark, a small concave fill.
+        nvgBeginPath(vg);
+        nvgMoveTo(vg, 1150, y + 28);
+        nvgLineTo(vg, 1160, y + 38);
+        nvgLineTo(vg, 1178, y + 16);
+        nvgLineTo(vg, 1174, y + 12);
+        nvgLineTo(vg, 1160, y + 30);
+        nvgLineTo(vg, 1154, y + 24);
+        nvgClosePath(vg);
+        nvgFillColor(vg, nvgRGB(0, 255, 200));
+        nvgFill(vg);
+
+        if (font >= 0) {
+            nvgFontFaceId(vg, font);
+            nvgFontSize(vg, 24);
+            nvgTextAlign(vg, NVG_ALIGN_LEFT | NVG_ALIGN_MIDDLE);
+            nvgFillColor(vg, nvgRGB(255, 255, 255));
+            snprintf(buf, sizeof(buf), "Title %d", i);
+            nvgText(vg, 170, y + 18, buf, NULL);
+            nvgFontSize(vg, 20);
+            nvgText(vg, 170, y + 42, "1.0.0 Publisher", NULL);
+        }
+    }
+
+    nvgEndFrame(vg);
+}
+
+// Returns the most heap calls of a frame after the warm-up.
+static long alloc__run(const char* name, const char* fontPath, int frames, int deferred) {
+    static unsigned char pixels[56 * 56 * 4];
+    const NVGworkers workers = { NULL, 3, alloc__parallelFor, alloc__async };
+    NVGcontext* vg = nvgCreateNull(NVGNULL_ANTIALIAS | NVGNULL_STENCIL_STROKES);
+    long warmup = 0, worst = 0, total = 0;
+    int i, font = -1, icon;
+
+    if (vg == NULL) return -1;
+    if (deferred) nvgSetWorkers(vg, &workers);
+    if (fontPath != NULL && (font = nvgCreateFont(vg, "font", fontPath)) < 0) {
+        fprintf(stderr, "failed to load %s\n", fontPath);
+        nvgDeleteNull(vg);
+        return -1;
+    }
+    icon = nvgCreateImageRGBA(vg, 56, 56, 0, pixels);
+
+    for (i = 0; i < frames; i++) {
+        long calls = alloc__calls;
+        alloc__drawFrame(vg, font, icon, i);
+        calls = alloc__calls - calls;
+        if (i < ALLOC_WARMUP_FRAMES) {
+            warmup += calls;
+        } else {
+            total += calls;
+            if (calls > worst) worst = calls;
+        }
+    }
+
+    printf("%-10s %5d calls %6d verts, %ld heap calls warming up, %ld in %d frames after\n", name, nvgNullStats(vg)->calls,
+           nvgNullStats(vg)->verts, warmup, total, frames - ALLOC_WARMUP_FRAMES);
+    nvgDeleteImage(vg, icon);
+    nvgDeleteNull(vg);
+    return worst;
+}
+
+int main(int argc, char** argv) {
+    int frames = 100;
+    const char* font = NULL;
+    long immediate, deferred;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (argv[i][0] >= '0' && argv[i][0] <= '9') {
+            frames = atoi(argv[i]);
+        } else {
+            font = argv[i];
+        }
+    }
+    if (frames <= ALLOC_WARMUP_FRAMES) {
+        fprintf(stderr, "usage: %s [frames] [font], frames must be above %d\n", argv[0], ALLOC_WARMUP_FRAMES);
+        return 1;
+    }
+
+    immediate = alloc__run("immediate", font, frames, 0);
+    deferred = alloc__run("deferred", font, frames, 1);
+    if (immediate < 0 || deferred < 0) return 1;
+    if (immediate > 0 || deferred > 0) {
+        printf("steady-state frames allocate\n");
+        return 2;
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,251 @@
+// Checks that deferred tessellation hands the back-end the same calls as tessellating on the calling thread.
+//
+// Builds on any host with a C11 compiler:
+//   cc -O2 -std=c11 -Isrc/nanovg -o nvgdeferred tools/nvgdeferred.c src/nanovg/nanovg.c -lm
+//
+// Usage: nvgdeferred [frames] [font]
+//
+// The same frames are drawn on two null back-ends, one with a worker pool set by nvgSetWorkers().
+// Every fill, stroke, triangle and rect call is hashed with its paint, scissor, path flags and
+// vertices, and the hashes and call counts of both must match frame for frame. The first frame
+// misses the geometry cache, the later ones hit it. Text, which flushes the pending jobs in the
+// middle of a frame, is only drawn when a TTF or OTF font is given.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanovg.h"
+#include "nanovg_null.h"
+
+struct Recorder {
+    void* uptr;
+    NVGparams inner;
+    unsigned int hash;
+};
+
+static struct Recorder recorders[2];
+
+static struct Recorder* deferred__find(void* uptr) {
+    return recorders[0].uptr == uptr ? &recorders[0] : &recorders[1];
+}
+
+// FNV-1a, the floats are hashed bit for bit.
+static void deferred__hash(struct Recorder* rec, const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    size_t i;
+    for (i = 0; i < size; i++) rec->hash = (rec->hash ^ p[i]) * 16777619u;
+}
+
+static void deferred__hashState(struct Recorder* rec, int type, NVGpaint* paint, NVGcompositeOperationState* op, NVGscissor* scissor, float fringe) {
+    deferred__hash(rec, &type, sizeof(type));
+    deferred__hash(rec, paint, sizeof(*paint));
+    deferred__hash(rec, op, sizeof(*op));
+    deferred__hash(rec, scissor, sizeof(*scissor));
+    deferred__hash(rec, &fringe, sizeof(fringe));
+}
+
+static void deferred__hashPaths(struct Recorder* rec, const NVGpath* paths, int npaths) {
+    int i;
+    for (i = 0; i < npaths; i++) {
+        deferred__hash(rec, &paths[i].closed, sizeof(paths[i].closed));
+        deferred__hash(rec, &paths[i].nbevel, sizeof(paths[i].nbevel));
+        deferred__hash(rec, &paths[i].winding, sizeof(paths[i].winding));
+        deferred__hash(rec, &paths[i].convex, sizeof(paths[i].convex));
+        deferred__hash(rec, &paths[i].triangulated, sizeof(paths[i].triangulated));
+        deferred__hash(rec, &paths[i].nfill, sizeof(paths[i].nfill));
+        deferred__hash(rec, &paths[i].nstroke, sizeof(paths[i].nstroke));
+        if (paths[i].nfill > 0) deferred__hash(rec, paths[i].fill, sizeof(NVGvertex) * paths[i].nfill);
+        if (paths[i].nstroke > 0) deferred__hash(rec, paths[i].stroke, sizeof(NVGvertex) * paths[i].nstroke);
+    }
+}
+
+static void deferred__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+                                 float fringe, const float* bounds, const NVGpath* paths, int npaths) {
+    struct Recorder* rec = deferred__find(uptr);
+    deferred__hashState(rec, 0, paint, &compositeOperation, scissor, fringe);
+    deferred__hash(rec, bounds, sizeof(float) * 4);
+    deferred__hashPaths(rec, paths, npaths);
+    rec->inner.renderFill(uptr, paint, compositeOperation, scissor, fringe, bounds, paths, npaths);
+}
+
+static void deferred__renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+                                   float fringe, float strokeWidth, const NVGpath* paths, int npaths) {
+    struct Recorder* rec = deferred__find(uptr);
+    deferred__hashState(rec, 1, paint, &compositeOperation, scissor, fringe);
+    deferred__hash(rec, &strokeWidth, sizeof(strokeWidth));
+    deferred__hashPaths(rec, paths, npaths);
+    rec->inner.renderStroke(uptr, paint, compositeOperation, scissor, fringe, strokeWidth, paths, npaths);
+}
+
+static void deferred__renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+                                      const NVGvertex* verts, int nverts, float fringe) {
+    struct Recorder* rec = deferred__find(uptr);
+    deferred__hashState(rec, 2, paint, &compositeOperation, scissor, fringe);
+    deferred__hash(rec, verts, sizeof(NVGvertex) * nverts);
+    rec->inner.renderTriangles(uptr, paint, compositeOperation, scissor, verts, nverts, fringe);
+}
+
+static void deferred__renderFillRect(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+                                     float fringe, const float* rect) {
+    struct Recorder* rec = deferred__find(uptr);
+    deferred__hashState(rec, 3, paint, &compositeOperation, scissor, fringe);
+    deferred__hash(rec, rect, sizeof(float) * 4);
+    rec->inner.renderFillRect(uptr, paint, compositeOperation, scissor, fringe, rect);
+}
+
+// Runs the jobs last to first and spreads them over three workers, the result must not depend on either.
+static void deferred__parallelFor(void* uptr, int n, void (*func)(void* arg, int index, int worker), void* arg) {
+    int i;
+    (void)uptr;
+    for (i = n - 1; i >= 0; i--) func(arg, i, i % 3);
+}
+
+static void deferred__star(NVGcontext* vg, float cx, float cy, float r0, float r1, int points) {
+    int i;
+    nvgBeginPath(vg);
+    for (i = 0; i < points; i++) {
+        const float a = (float)i * NVG_PI * 2.0f / points - NVG_PI * 0.5f;
+        const float r = i & 1 ? r1 : r0;
+        if (i == 0) nvgMoveTo(vg, cx + cosf(a) * r, cy + sinf(a) * r);
+        else nvgLineTo(vg, cx + cosf(a) * r, cy + sinf(a) * r);
+    }
+    nvgClosePath(vg);
+}
+
+static void deferred__drawFrame(NVGcontext* vg, int font) {
+    static const int caps[] = { NVG_BUTT, NVG_ROUND, NVG_SQUARE };
+    static const int joins[] = { NVG_MITER, NVG_ROUND, NVG_BEVEL };
+    int i;
+
+    nvgBeginFrame(vg, 1280, 720, 1.0f);
+
+    for (i = 0; i < 12; i++) {
+        const float x = 60.0f + (i % 6) * 200.0f, y = 80.0f + (i / 6) * 200.0f;
+
+        nvgSave(vg);
+        if (i == 3) nvgScissor(vg, x - 40, y - 40, 60, 60);
+        if (i == 7) {
+            nvgTranslate(vg, x, y);
+            nvgRotate(vg, 0.3f);
+            nvgTranslate(vg, -x, -y);
+        }
+
+        // Convex, the geometry cache takes the translated copies.
+        nvgBeginPath(vg);
+        nvgRoundedRect(vg, x - 50, y - 50, 100, 100, 10);
+        nvgFillPaint(vg, nvgLinearGradient(vg, x - 50, y - 50, x + 50, y + 50, nvgRGB(40, 80, 160), nvgRGB(160, 80, 40)));
+        nvgFill(vg);
+
+        // Small concave, triangulated when the back-end allows it.
+        deferred__star(vg, x, y, 40, 18, 10);
+        nvgFillColor(vg, nvgRGBA(255, 200, 0, 200));
+        nvgFill(vg);
+
+        // Self-intersecting bow tie, always stenciled.
+        nvgBeginPath(vg);
+        nvgMoveTo(vg, x + 30, y + 30);
+        nvgLineTo(vg, x + 90, y + 90);
+        nvgLineTo(vg, x + 90, y + 30);
+        nvgLineTo(vg, x + 60, y + 40);
+        nvgLineTo(vg, x + 30, y + 90);
+        nvgClosePath(vg);
+        nvgFillColor(vg, nvgRGBA(0, 200, 255, 160));
+        nvgFill(vg);
+
+        // Strokes with every cap and join.
+        nvgBeginPath(vg);
+        nvgMoveTo(vg, x - 40, y + 70);
+        nvgBezierTo(vg, x - 10, y + 30, x + 10, y + 110, x + 40, y + 70);
+        nvgLineTo(vg, x + 50, y + 90);
+        nvgLineCap(vg, caps[i % 3]);
+        nvgLineJoin(vg, joins[i / 3 % 3]);
+        nvgStrokeWidth(vg, 1.0f + i);
+        nvgStrokeColor(vg, nvgRGB(220, 220, 220));
+        nvgStroke(vg);
+
+        // Flushes the recorded jobs before it.
+        nvgFillColor(vg, nvgRGB(255, 0, 128));
+        nvgFillRect(vg, x - 50, y + 100, 100, 2);
+
+        if (font >= 0) {
+            nvgFontFaceId(vg, font);
+            nvgFontSize(vg, 18);
+            nvgFillColor(vg, nvgRGB(255, 255, 255));
+            nvgText(vg, x - 40, y - 60, "Title", NULL);
+        }
+        nvgRestore(vg);
+    }
+
+    nvgEndFrame(vg);
+}
+
+static NVGcontext* deferred__create(struct Recorder* rec, const char* fontPath, int* font) {
+    NVGcontext* vg = nvgCreateNull(NVGNULL_ANTIALIAS | NVGNULL_STENCIL_STROKES);
+    NVGparams* params;
+    if (vg == NULL) return NULL;
+
+    params = nvgInternalParams(vg);
+    rec->uptr = params->userPtr;
+    rec->inner = *params;
+    params->renderFill = deferred__renderFill;
+    params->renderStroke = deferred__renderStroke;
+    params->renderTriangles = deferred__renderTriangles;
+    params->renderFillRect = deferred__renderFillRect;
+
+    *font = -1;
+    if (fontPath != NULL && (*font = nvgCreateFont(vg, "font", fontPath)) < 0) {
+        fprintf(stderr, "failed to load %s\n", fontPath);
+        nvgDeleteNull(vg);
+        return NULL;
+    }
+    return vg;
+}
+
+int main(int argc, char** argv) {
+    const NVGworkers workers = { NULL, 3, deferred__parallelFor, NULL };
+    NVGcontext* immediate;
+    NVGcontext* deferred;
+    const char* fontPath = NULL;
+    int i, frames = 3, failed = 0, font0, font1;
+
+    for (i = 1; i < argc; i++) {
+        if (argv[i][0] >= '0' && argv[i][0] <= '9') {
+            frames = atoi(argv[i]);
+        } else {
+            fontPath = argv[i];
+        }
+    }
+
+    immediate = deferred__create(&recorders[0], fontPath, &font0);
+    deferred = deferred__create(&recorders[1], fontPath, &font1);
+    if (immediate == NULL || deferred == NULL) {
+        fprintf(stderr, "failed to create the null renderers\n");
+        return 1;
+    }
+    nvgSetWorkers(deferred, &workers);
+
+    printf("%5s %-9s %8s %6s %6s %7s %9s %6s\n", "frame", "mode", "hash", "calls", "fills", "convex", "strokes", "verts");
+    for (i = 0; i < frames; i++) {
+        const NVGnullStats* a;
+        const NVGnullStats* b;
+        recorders[0].hash = recorders[1].hash = 2166136261u;
+        deferred__drawFrame(immediate, font0);
+        deferred__drawFrame(deferred, font1);
+
+        a = nvgNullStats(immediate);
+        b = nvgNullStats(deferred);
+        printf("%5d %-9s %08x %6d %6d %7d %9d %6d\n", i, "immediate", recorders[0].hash, a->calls, a->fills, a->convexFills, a->strokes, a->verts);
+        printf("%5d %-9s %08x %6d %6d %7d %9d %6d\n", i, "deferred", recorders[1].hash, b->calls, b->fills, b->convexFills, b->strokes, b->verts);
+        if (recorders[0].hash != recorders[1].hash || a->calls != b->calls || a->fills != b->fills || a->convexFills != b->convexFills ||
+            a->strokes != b->strokes || a->verts != b->verts) {
+            failed = 1;
+        }
+    }
+
+    nvgDeleteNull(immediate);
+    nvgDeleteNull(deferred);
+    printf(failed ? "deferred output differs\n" : "ok\n");
+    return failed ? 2 : 0;
+}
@@ -0,0 +1,266 @@
+// Runs the nanovg deko3d back-end against a recording stand-in for deko3d and checks the descriptor
+// writes, barriers and draws of each frame, and the texels texture uploads leave behind.
+//
+// Builds on any host with a C11 and a C++23 compiler, tools/dkstub replaces deko3d and libnx:
+//   cc -O1 -std=gnu11 -Isrc/nanovg -DSTBI_ONLY_JPEG -c src/nanovg/nanovg.c -o nanovg.o
+//   c++ -O1 -std=c++23 -fno-exceptions -fno-rtti -pthread -Itools/dkstub -Isrc/nanovg -Isrc/nanovg/deko3d -o nvgdk tools/nvgdk.cpp
+//     tools/dkstub/dkstub.cpp src/nanovg/deko3d/dk_renderer.cpp src/nanovg/deko3d/framework/CMemPool.cpp src/nanovg/deko3d/framework/CIntrusiveTree.cpp nanovg.o -lm
+//
+// Usage: nvgdk [textures] [jpeg]
+//
+// Every frame fills one 16x16 rect per texture. A texture drawn for the first time gets its
+// descriptor written once, all writes of a frame share one barrier, and a frame drawing the same
+// textures again writes none. Each draw must read the descriptor of its own texture, and no
+// descriptor may be rewritten while a draw of the frame can still read it. With more textures
+// than the descriptor set holds, the descriptors are recycled between frames.
+// Icons and a large image are then created without a flush in between. The queue must never be
+// waited on and every texel must land, also for textures deleted before their copy ran. Given a
+// JPEG, it is decoded straight into staging memory, once on the calling thread and once on a
+// second thread while the first keeps drawing and flushing, like the app's scan does. Building
+// with -fsanitize=thread checks the locking of the back-end as well.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <atomic>
+#include <thread>
+
+#include "nanovg.h"
+#include "nanovg_dk.h"
+#include "stb_image.h"
+#include "dkstub/dkstub.h"
+
+#define DK_MAX_TEXTURES 8000
+
+static int failures;
+#define EXPECT(c) do { if (!(c)) { printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #c); failures++; } } while (0)
+
+static int images[DK_MAX_TEXTURES];
+static unsigned content[DK_MAX_TEXTURES];
+static unsigned char pixels[16 * 16 * 4];
+
+static void dk__clearStats() {
+    memset(&g_dk, 0, offsetof(DkStats, imageSet));
+    memset(g_dk.readSinceWait, 0, sizeof(g_dk.readSinceWait));
+}
+
+static void dk__create(NVGcontext* vg, int i) {
+    images[i] = nvgCreateImageRGBA(vg, 16, 16, 0, pixels);
+    content[i] = g_dk.nextImage;
+}
+
+static void dk__draw(NVGcontext* vg, const int* ids, int n) {
+    int i;
+    nvgBeginFrame(vg, 1280, 720, 1.0f);
+    for (i = 0; i < n; i++) {
+        const float x = (i % 80) * 16, y = (i / 80 % 45) * 16;
+        NVGpaint paint = nvgImagePattern(vg, x, y, 16, 16, 0, ids[i], 1.0f);
+        nvgBeginPath(vg);
+        nvgRect(vg, x, y, 16, 16);
+        nvgFillPaint(vg, paint);
+        nvgFill(vg);
+    }
+    nvgEndFrame(vg);
+}
+
+static void dk__frame(NVGcontext* vg, int first, int n, const char* name) {
+    int i, wrong = 0;
+    dk__clearStats();
+    dk__draw(vg, &images[first], n);
+
+    for (i = 0; i < n && i < 8192; i++) wrong += g_dk.drawContent[i] != content[first + i];
+    printf("%-20s %5d textures %5d draws %5d writes %3d descriptor barriers %3d barriers, %d stale, %d hazards, %d wrong\n", name, n,
+           g_dk.draws, g_dk.descriptorUpdates, g_dk.descriptorBarriers, g_dk.barriers, g_dk.staleDraws, g_dk.hazards, wrong);
+    EXPECT(g_dk.draws == n);
+    EXPECT(g_dk.staleDraws == 0);
+    EXPECT(g_dk.hazards == 0);
+    EXPECT(wrong == 0);
+}
+
+// Icons are created in batches, the queue is never waited on, and every texel lands.
+static void dk__uploads(NVGcontext* vg) {
+    static unsigned char big[1024 * 1024 * 4];
+    static unsigned char icon[64 * 64 * 4];
+    static int icons[300];
+    static unsigned iconContent[300];
+    unsigned bigContent;
+    int i, j, submits, bad = 0, bigImage;
+
+    dk__clearStats();
+    for (i = 0; i < 300; i++) {
+        for (j = 0; j < (int)sizeof(icon); j++) icon[j] = (unsigned char)(i * 7 + j);
+        icons[i] = nvgCreateImageRGBA(vg, 64, 64, 0, icon);
+        iconContent[i] = g_dk.nextImage;
+        // Deleting right away must not free the image before its copy ran.
+        if (i % 50 == 49) nvgDeleteImage(vg, icons[i]);
+    }
+    for (j = 0; j < (int)sizeof(big); j++) big[j] = (unsigned char)(j * 13 >> 3);
+    bigImage = nvgCreateImageRGBA(vg, 1024, 1024, 0, big);
+    bigContent = g_dk.nextImage;
+    submits = g_dk.submits;
+    printf("300 icons and a 4 MB image: %d copies, %d submits before the flush, %d waits\n", g_dk.copies, submits, g_dk.waitIdles);
+    EXPECT(g_dk.waitIdles == 0);
+
+    nvgBeginFrame(vg, 1280, 720, 1.0f);
+    nvgEndFrame(vg);
+    EXPECT(g_dk.submits == submits + 1);
+    for (i = 0; i < 300; i++) {
+        const DkImageInfo* info = &g_imageInfo[iconContent[i] & 65535];
+        if (i % 50 == 49) continue;
+        for (j = 0; j < (int)sizeof(icon); j++) bad += info->mem[j] != (unsigned char)(i * 7 + j);
+    }
+    EXPECT(bad == 0);
+    EXPECT(memcmp(g_imageInfo[bigContent & 65535].mem, big, sizeof(big)) == 0);
+
+    // Too large for the staging slices, goes through the batches after what was staged before.
+    memset(big, 0x11, sizeof(big));
+    nvgUpdateImage(vg, bigImage, big);
+    nvgBeginFrame(vg, 1280, 720, 1.0f);
+    nvgEndFrame(vg);
+    EXPECT(g_dk.waitIdles == 0);
+    EXPECT(memcmp(g_imageInfo[bigContent & 65535].mem, big, sizeof(big)) == 0);
+
+    for (i = 0; i < 300; i++) {
+        if (i % 50 != 49) nvgDeleteImage(vg, icons[i]);
+    }
+    nvgDeleteImage(vg, bigImage);
+}
+
+// Checks the image behind each descriptor content against the decoded JPEG.
+static int dk__countWrongIcons(const unsigned* contents, int n, const unsigned char* ref, int w, int h) {
+    int i, wrong = 0;
+    for (i = 0; i < n; i++) wrong += memcmp(g_imageInfo[contents[i] & 65535].mem, ref, (size_t)w * h * 4) != 0;
+    return wrong;
+}
+
+// The JPEG is decoded into staging memory, on this thread and then on another one while this one draws.
+static int dk__mappedIcons(NVGcontext* vg, const char* path) {
+    static unsigned char jpeg[1 << 20];
+    static int icons[64];
+    static unsigned iconContent[64];
+    std::atomic<int> created{0};
+    FILE* fp = fopen(path, "rb");
+    unsigned char* ref;
+    int i, size, w, h, n, frames = 0, wrong;
+
+    if (fp == NULL) {
+        fprintf(stderr, "failed to open %s\n", path);
+        return 0;
+    }
+    size = (int)fread(jpeg, 1, sizeof(jpeg), fp);
+    fclose(fp);
+    ref = stbi_load_from_memory(jpeg, size, &w, &h, &n, 4);
+    if (ref == NULL) {
+        fprintf(stderr, "failed to decode %s\n", path);
+        return 0;
+    }
+
+    for (i = 0; i < 16; i++) {
+        icons[i] = nvgCreateImageMem(vg, 0, jpeg, size);
+        iconContent[i] = g_dk.nextImage;
+    }
+    nvgBeginFrame(vg, 1280, 720, 1.0f);
+    nvgEndFrame(vg);
+    wrong = dk__countWrongIcons(iconContent, 16, ref, w, h);
+    printf("%d mapped %dx%d icons, %d wrong\n", 16, w, h, wrong);
+    EXPECT(icons[0] != 0 && icons[15] != 0);
+    EXPECT(wrong == 0);
+    for (i = 0; i < 16; i++) nvgDeleteImage(vg, icons[i]);
+
+    // Only this thread touches the stats while the other creates icons, so they are not cleared.
+    std::thread scan([&] {
+        for (int k = 0; k < 64; k++) {
+            icons[k] = nvgCreateImageMem(vg, 0, jpeg, size);
+            iconContent[k] = g_dk.nextImage;
+            created.store(k + 1, std::memory_order_release);
+        }
+        // The decode arena is per thread, like the app's scan thread.
+        nvgFreeImageArena();
+    });
+    while (created.load(std::memory_order_acquire) < 64) {
+        const int done = created.load(std::memory_order_acquire);
+        int ids[200 + 64];
+        memcpy(ids, images, sizeof(int) * 200);
+        memcpy(ids + 200, icons, sizeof(int) * done);
+        dk__draw(vg, ids, 200 + done);
+        frames++;
+    }
+    scan.join();
+    nvgBeginFrame(vg, 1280, 720, 1.0f);
+    nvgEndFrame(vg);
+
+    wrong = dk__countWrongIcons(iconContent, 64, ref, w, h);
+    printf("%d icons mapped on another thread over %d frames, %d wrong\n", 64, frames, wrong);
+    EXPECT(wrong == 0);
+    for (i = 0; i < 64; i++) nvgDeleteImage(vg, icons[i]);
+    stbi_image_free(ref);
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    dk::Device dev{};
+    dk::Queue queue{};
+    CMemPool image(dev), code(dev), data(dev);
+    nvg::DkRenderer renderer(1280, 720, dev, queue, image, code, data);
+    NVGcontext* vg = nvgCreateDk(&renderer, NVG_ANTIALIAS | NVG_STENCIL_STROKES);
+    int i, many = argc > 1 ? atoi(argv[1]) : 200;
+
+    if (vg == NULL || many > DK_MAX_TEXTURES) {
+        fprintf(stderr, "usage: %s [textures], at most %d textures\n", argv[0], DK_MAX_TEXTURES);
+        return 1;
+    }
+
+    for (i = 0; i < 200; i++) dk__create(vg, i);
+
+    dk__frame(vg, 0, 100, "first 100");
+    EXPECT(g_dk.descriptorUpdates == 100 && g_dk.descriptorBarriers <= 1);
+    dk__frame(vg, 0, 100, "same 100");
+    EXPECT(g_dk.descriptorUpdates == 0 && g_dk.descriptorBarriers == 0);
+    dk__frame(vg, 0, 200, "all 200");
+    EXPECT(g_dk.descriptorUpdates == 100 && g_dk.descriptorBarriers <= 1);
+
+    // Replace ten textures, the new ones reuse the freed descriptors.
+    for (i = 0; i < 10; i++) {
+        nvgDeleteImage(vg, images[i * 7]);
+        dk__create(vg, i * 7);
+    }
+    dk__frame(vg, 0, 200, "10 replaced");
+    EXPECT(g_dk.descriptorUpdates == 10 && g_dk.descriptorBarriers <= 1);
+    dk__frame(vg, 0, 200, "steady");
+    EXPECT(g_dk.descriptorUpdates == 0 && g_dk.descriptorBarriers == 0);
+
+    // Ids of deleted textures must not resolve, not even once their slot is reused.
+    {
+        int w = -1, h = -1, old = images[0];
+        nvgDeleteImage(vg, old);
+        nvgImageSize(vg, old, &w, &h);
+        EXPECT(w == -1);
+        dk__create(vg, 0);
+        EXPECT(images[0] != old);
+        nvgImageSize(vg, old, &w, &h);
+        EXPECT(w == -1);
+        nvgImageSize(vg, images[0], &w, &h);
+        EXPECT(w == 16 && h == 16);
+    }
+
+    // More textures than descriptors.
+    if (many > 200) {
+        for (i = 200; i < many; i++) dk__create(vg, i);
+        dk__frame(vg, 0, many, "all textures");
+        dk__frame(vg, 0, 200, "first 200 again");
+        dk__frame(vg, many - 200, 200, "last 200");
+        dk__frame(vg, 0, many, "all textures again");
+        EXPECT(nvgCreateImageRGBA(vg, 16, 16, 0, pixels) != 0);
+    }
+
+    dk__uploads(vg);
+    if (argc > 2 && !dk__mappedIcons(vg, argv[2])) {
+        nvgDeleteDk(vg);
+        return 1;
+    }
+
+    nvgDeleteDk(vg);
+    printf(failures ? "%d failures\n" : "ok\n", failures);
+    return failures != 0 ? 2 : 0;
+}
@@ -0,0 +1,182 @@
+// Replays a trace recorded with nvgTraceBegin() and prints per-frame statistics.
+//
+// Builds on any host with a C11 compiler:
+//   cc -O2 -std=c11 -Isrc/nanovg -o nvgreplay tools/nvgreplay.c src/nanovg/nanovg.c -lm
+//
+// Usage: nvgreplay [-sw] [-write <prefix> | -compare <prefix>] <trace> [repeat]
+//
+// Frames go to the counting null back-end by default, the binds column is how often the
+// texture, blend or scissor state changed between calls.
+// -sw rasterizes the frames with the CPU back-end instead, the timings then include rasterization. -write saves each frame as <prefix>NNNN.ppm, -compare checks the
+// frames against such files and fails if any pixel is off by more than one step.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanovg.h"
+#include "nanovg_null.h"
+#include "nanovg_trace.h"
+#include "sw/nanovg_sw.h"
+
+struct Totals {
+    NVGcontext* null;
+    NVGcontext* sw;
+    const char* write;
+    const char* compare;
+    int mismatches;
+    int frames;
+    double cpuTime;
+    double maxCpuTime;
+    long calls;
+    long verts;
+    long uniforms;
+    long uploads;
+    long binds;
+};
+
+static int replay__writeFrame(const char* path, const unsigned char* pixels, int w, int h) {
+    FILE* fp = fopen(path, "wb");
+    int i;
+    if (fp == NULL) return 0;
+    fprintf(fp, "P6\n%d %d\n255\n", w, h);
+    for (i = 0; i < w * h; i++) fwrite(&pixels[i * 4], 1, 3, fp);
+    return fclose(fp) == 0;
+}
+
+// Returns the number of pixels differing by more than one step, or -1 if the file does not match the frame size.
+static int replay__compareFrame(const char* path, const unsigned char* pixels, int w, int h) {
+    FILE* fp = fopen(path, "rb");
+    unsigned char rgb[3];
+    int i, c, fw, fh, max, diff = 0;
+    if (fp == NULL) return -1;
+    if (fscanf(fp, "P6 %d %d %d", &fw, &fh, &max) != 3 || fgetc(fp) == EOF || fw != w || fh != h || max != 255) {
+        fclose(fp);
+        return -1;
+    }
+    for (i = 0; i < w * h; i++) {
+        if (fread(rgb, 1, 3, fp) != 3) {
+            diff = -1;
+            break;
+        }
+        for (c = 0; c < 3; c++) {
+            if (abs((int)rgb[c] - (int)pixels[i * 4 + c]) > 1) {
+                diff++;
+                break;
+            }
+        }
+    }
+    fclose(fp);
+    return diff;
+}
+
+static void replay__frameDone(void* uptr, const NVGtraceFrame* frame) {
+    struct Totals* totals = (struct Totals*)uptr;
+    int binds = 0;
+
+    if (totals->sw != NULL && (totals->write != NULL || totals->compare != NULL)) {
+        char path[1024];
+        int w, h, diff;
+        const unsigned char* pixels = nvgSwFramebuffer(totals->sw, &w, &h);
+        if (totals->write != NULL) {
+            snprintf(path, sizeof(path), "%s%04d.ppm", totals->write, frame->frame);
+            if (!replay__writeFrame(path, pixels, w, h)) fprintf(stderr, "failed to write %s\n", path);
+        } else {
+            snprintf(path, sizeof(path), "%s%04d.ppm", totals->compare, frame->frame);
+            diff = replay__compareFrame(path, pixels, w, h);
+            if (diff != 0) {
+                if (diff < 0) fprintf(stderr, "frame %d: cannot compare against %s\n", frame->frame, path);
+                else fprintf(stderr, "frame %d: %d pixels differ from %s\n", frame->frame, diff, path);
+                totals->mismatches++;
+            }
+        }
+    }
+
+    // The null back-end also knows how often the state a GPU back-end binds changed.
+    if (totals->null != NULL) {
+        const NVGnullStats* stats = nvgNullStats(totals->null);
+        binds = stats->imageChanges + stats->blendChanges + stats->scissorChanges;
+    }
+
+    printf("%6d %10.3f %10.3f %7d %7d %8d %8d %10d %6d\n", frame->frame, frame->cpuTime * 1000.0, frame->wallTime * 1000.0,
+           frame->calls, frame->paths, frame->verts, frame->uniforms, frame->uploads, binds);
+    totals->frames++;
+    totals->cpuTime += frame->cpuTime;
+    if (frame->cpuTime > totals->maxCpuTime) totals->maxCpuTime = frame->cpuTime;
+    totals->calls += frame->calls;
+    totals->verts += frame->verts;
+    totals->uniforms += frame->uniforms;
+    totals->uploads += frame->uploads;
+    totals->binds += binds;
+}
+
+int main(int argc, char** argv) {
+    NVGparams params;
+    struct Totals totals;
+    const char* trace = NULL;
+    int i, sw = 0, repeat = 1;
+
+    memset(&totals, 0, sizeof(totals));
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-sw") == 0) {
+            sw = 1;
+        } else if (strcmp(argv[i], "-write") == 0 && i + 1 < argc) {
+            totals.write = argv[++i];
+        } else if (strcmp(argv[i], "-compare") == 0 && i + 1 < argc) {
+            totals.compare = argv[++i];
+        } else if (trace == NULL) {
+            trace = argv[i];
+        } else {
+            repeat = atoi(argv[i]);
+        }
+    }
+
+    if (trace == NULL || ((totals.write != NULL || totals.compare != NULL) && !sw)) {
+        fprintf(stderr, "usage: %s [-sw] [-write <prefix> | -compare <prefix>] <trace> [repeat]\n", argv[0]);
+        return 1;
+    }
+
+    if (sw) {
+        // Same flags as the app's deko3d context.
+        totals.sw = nvgCreateSw(NVGSW_ANTIALIAS | NVGSW_STENCIL_STROKES);
+        if (totals.sw == NULL) {
+            fprintf(stderr, "failed to create the software renderer\n");
+            return 1;
+        }
+        nvgSwClearColor(totals.sw, nvgRGBA(0, 0, 0, 255));
+        params = *nvgInternalParams(totals.sw);
+    } else {
+        // Counts the calls and draws nothing, replay then times the trace reader alone.
+        totals.null = nvgCreateNull(NVGNULL_ANTIALIAS | NVGNULL_STENCIL_STROKES);
+        if (totals.null == NULL) {
+            fprintf(stderr, "failed to create the null renderer\n");
+            return 1;
+        }
+        params = *nvgInternalParams(totals.null);
+    }
+
+    printf(" frame    cpu(ms)   wall(ms)   calls   paths    verts uniforms    uploads  binds\n");
+    for (i = 0; i < repeat; i++) {
+        if (nvgTraceReplay(trace, &params, replay__frameDone, &totals) < 0) {
+            fprintf(stderr, "failed to replay %s\n", trace);
+            if (totals.sw != NULL) nvgDeleteSw(totals.sw);
+            if (totals.null != NULL) nvgDeleteNull(totals.null);
+            return 1;
+        }
+    }
+
+    if (totals.frames > 0) {
+        printf("frames %d, cpu avg %.3f ms max %.3f ms, per frame: %.1f calls %.1f verts %.1f uniforms %.1f upload bytes %.1f binds\n",
+               totals.frames, totals.cpuTime * 1000.0 / totals.frames, totals.maxCpuTime * 1000.0,
+               (double)totals.calls / totals.frames, (double)totals.verts / totals.frames,
+               (double)totals.uniforms / totals.frames, (double)totals.uploads / totals.frames,
+               (double)totals.binds / totals.frames);
+    }
+    if (totals.sw != NULL) nvgDeleteSw(totals.sw);
+    if (totals.null != NULL) nvgDeleteNull(totals.null);
+    if (totals.mismatches > 0) {
+        fprintf(stderr, "%d frames differ\n", totals.mismatches);
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,228 @@
+// Checks that triangulated concave fills cover the same pixels as the stenciled fills they replace.
+//
+// Builds on any host with a C11 compiler:
+//   cc -O2 -std=c11 -Isrc/nanovg -o nvgtriangulate tools/nvgtriangulate.c src/nanovg/nanovg.c -lm
+//
+// Usage: nvgtriangulate [-write <prefix>] [seed]
+//
+// Stars, notched and random simple polygons are rasterized by the CPU back-end three times: with
+// NVGparams::triangulateFills cleared so every concave fill goes through the stencil, with it set,
+// and with it set and tessellation deferred to workers. Both triangulated frames must match the
+// stenciled one within one step per channel away from the corners, and must both have triangulated
+// the same fills.
+// -write saves the three frames as <prefix>stencil.ppm, <prefix>immediate.ppm and <prefix>deferred.ppm.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nanovg.h"
+#include "sw/nanovg_sw.h"
+
+#define TRI_WIDTH 960
+#define TRI_HEIGHT 640
+#define TRI_CELL 80
+// Pixels this close to a corner may differ, the half fringe of a triangulated fill is mitred there
+// while the stencil path blends the full fringe over the outside only. Sharper corners get more.
+#define TRI_CORNER_RADIUS 1.5f
+
+struct Variant {
+    const char* name;
+    int triangulate;
+    int deferred;
+    NVGcontext* vg;
+    void (*renderFill)(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+                       const float* bounds, const NVGpath* paths, int npaths);
+    int fills;
+    int triangulated;
+};
+
+// Set for the pixels around a corner of any drawn polygon.
+static unsigned char corners[TRI_WIDTH * TRI_HEIGHT];
+
+static struct Variant variants[] = {
+    { "stencil", 0, 0, NULL, NULL, 0, 0 },
+    { "immediate", 1, 0, NULL, NULL, 0, 0 },
+    { "deferred", 1, 1, NULL, NULL, 0, 0 },
+};
+
+#define TRI_VARIANTS ((int)(sizeof(variants) / sizeof(variants[0])))
+
+static void tri__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+                            const float* bounds, const NVGpath* paths, int npaths) {
+    int i;
+    for (i = 0; i < TRI_VARIANTS; i++) {
+        if (variants[i].vg != NULL && nvgInternalParams(variants[i].vg)->userPtr == uptr) break;
+    }
+    variants[i].fills++;
+    if (npaths == 1 && paths[0].triangulated) variants[i].triangulated++;
+    variants[i].renderFill(uptr, paint, compositeOperation, scissor, fringe, bounds, paths, npaths);
+}
+
+static void tri__parallelFor(void* uptr, int n, void (*func)(void* arg, int index, int worker), void* arg) {
+    int i;
+    (void)uptr;
+    for (i = 0; i < n; i++) func(arg, i, i & 1);
+}
+
+// Deterministic across hosts, unlike rand().
+static float tri__random(unsigned int* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return (float)(*state >> 8) / 16777216.0f;
+}
+
+static void tri__polygon(NVGcontext* vg, const float* pts, int npts) {
+    int i, x, y;
+    nvgBeginPath(vg);
+    nvgMoveTo(vg, pts[0], pts[1]);
+    for (i = 1; i < npts; i++) nvgLineTo(vg, pts[i * 2], pts[i * 2 + 1]);
+    nvgClosePath(vg);
+
+    for (i = 0; i < npts; i++) {
+        const float* p0 = &pts[(i + npts - 1) % npts * 2];
+        const float* p1 = &pts[i * 2];
+        const float* p2 = &pts[(i + 1) % npts * 2];
+        const float a = fabsf(atan2f((p0[0] - p1[0]) * (p2[1] - p1[1]) - (p0[1] - p1[1]) * (p2[0] - p1[0]),
+                                     (p0[0] - p1[0]) * (p2[0] - p1[0]) + (p0[1] - p1[1]) * (p2[1] - p1[1])));
+        const float r = TRI_CORNER_RADIUS + 1.0f / sinf(a * 0.5f);
+        for (y = (int)(p1[1] - r); y <= (int)(p1[1] + r); y++) {
+            for (x = (int)(p1[0] - r); x <= (int)(p1[0] + r); x++) {
+                const float dx = x + 0.5f - p1[0], dy = y + 0.5f - p1[1];
+                if (x < 0 || y < 0 || x >= TRI_WIDTH || y >= TRI_HEIGHT || dx * dx + dy * dy > r * r) continue;
+                corners[y * TRI_WIDTH + x] = 1;
+            }
+        }
+    }
+}
+
+// Fills one concave polygon per cell, the same sequence for every seed-identical call.
+static void tri__drawFrame(NVGcontext* vg, unsigned int seed) {
+    float pts[64 * 2];
+    int cell, i;
+
+    nvgBeginFrame(vg, TRI_WIDTH, TRI_HEIGHT, 1.0f);
+    for (cell = 0; cell < (TRI_WIDTH / TRI_CELL) * (TRI_HEIGHT / TRI_CELL); cell++) {
+        const float cx = (cell % (TRI_WIDTH / TRI_CELL)) * TRI_CELL + TRI_CELL * 0.5f + tri__random(&seed) - 0.5f;
+        const float cy = (cell / (TRI_WIDTH / TRI_CELL)) * TRI_CELL + TRI_CELL * 0.5f + tri__random(&seed) - 0.5f;
+        const float r = TRI_CELL * 0.45f;
+        int n;
+
+        switch (cell % 3) {
+        case 0:
+            // Star with 3 to 12 points.
+            n = 6 + (int)(tri__random(&seed) * 19.0f);
+            n &= ~1;
+            for (i = 0; i < n; i++) {
+                const float a = (float)i / n * NVG_PI * 2.0f;
+                const float ri = i & 1 ? r * (0.2f + tri__random(&seed) * 0.5f) : r;
+                pts[i * 2] = cx + cosf(a) * ri;
+                pts[i * 2 + 1] = cy + sinf(a) * ri;
+            }
+            break;
+        case 1:
+            // Rectangle with a notch cut into one side, a thin sliver for some seeds.
+            n = 8;
+            {
+                const float w = r * (0.1f + tri__random(&seed) * 0.5f), d = r * (0.2f + tri__random(&seed) * 1.6f);
+                const float q[16] = { cx - r, cy - r, cx - w, cy - r, cx, cy - r + d, cx + w, cy - r,
+                                      cx + r, cy - r, cx + r, cy + r, cx, cy + r * 0.5f, cx - r, cy + r };
+                memcpy(pts, q, sizeof(q));
+            }
+            break;
+        default:
+            // Random star-shaped polygon, points sorted by angle around the centre.
+            n = 5 + (int)(tri__random(&seed) * 20.0f);
+            for (i = 0; i < n; i++) {
+                const float a = ((float)i + tri__random(&seed) * 0.5f) / n * NVG_PI * 2.0f;
+                const float ri = r * (0.4f + tri__random(&seed) * 0.6f);
+                pts[i * 2] = cx + cosf(a) * ri;
+                pts[i * 2 + 1] = cy + sinf(a) * ri;
+            }
+            break;
+        }
+
+        tri__polygon(vg, pts, n);
+        nvgFillColor(vg, nvgHSLA(tri__random(&seed), 0.7f, 0.5f, (unsigned char)(128 + tri__random(&seed) * 127)));
+        nvgFill(vg);
+    }
+    nvgEndFrame(vg);
+}
+
+static int tri__writeFrame(const char* path, const unsigned char* pixels, int w, int h) {
+    FILE* fp = fopen(path, "wb");
+    int i;
+    if (fp == NULL) return 0;
+    fprintf(fp, "P6\n%d %d\n255\n", w, h);
+    for (i = 0; i < w * h; i++) fwrite(&pixels[i * 4], 1, 3, fp);
+    return fclose(fp) == 0;
+}
+
+int main(int argc, char** argv) {
+    const NVGworkers workers = { NULL, 2, tri__parallelFor, NULL };
+    const char* write = NULL;
+    const unsigned char* reference;
+    unsigned int seed = 1;
+    int i, j, c, w, h, failed = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-write") == 0 && i + 1 < argc) {
+            write = argv[++i];
+        } else {
+            seed = (unsigned int)strtoul(argv[i], NULL, 10);
+        }
+    }
+
+    for (i = 0; i < TRI_VARIANTS; i++) {
+        NVGparams* params;
+        // Same flags as the app's deko3d context.
+        variants[i].vg = nvgCreateSw(NVGSW_ANTIALIAS | NVGSW_STENCIL_STROKES);
+        if (variants[i].vg == NULL) {
+            fprintf(stderr, "failed to create the software renderer\n");
+            return 1;
+        }
+        nvgSwClearColor(variants[i].vg, nvgRGBA(0, 0, 0, 255));
+        params = nvgInternalParams(variants[i].vg);
+        params->triangulateFills = variants[i].triangulate;
+        variants[i].renderFill = params->renderFill;
+        params->renderFill = tri__renderFill;
+        if (variants[i].deferred) nvgSetWorkers(variants[i].vg, &workers);
+        tri__drawFrame(variants[i].vg, seed);
+    }
+
+    reference = nvgSwFramebuffer(variants[0].vg, &w, &h);
+    printf("seed %u, %dx%d\n", seed, w, h);
+    for (i = 0; i < TRI_VARIANTS; i++) {
+        const unsigned char* pixels = nvgSwFramebuffer(variants[i].vg, &w, &h);
+        int diff = 0, cornerDiff = 0, maxDiff = 0;
+        for (j = 0; j < w * h; j++) {
+            int d = 0;
+            for (c = 0; c < 3; c++) {
+                const int e = abs((int)pixels[j * 4 + c] - (int)reference[j * 4 + c]);
+                if (e > d) d = e;
+            }
+            if (d <= 1) continue;
+            if (corners[j]) {
+                cornerDiff++;
+            } else {
+                diff++;
+                if (d > maxDiff) maxDiff = d;
+            }
+        }
+        printf("%-10s %3d fills %3d triangulated, %4d pixels off by more than one step, %4d at corners, max difference %d\n",
+               variants[i].name, variants[i].fills, variants[i].triangulated, diff, cornerDiff, maxDiff);
+        if (diff > 0 || (variants[i].triangulate && (variants[i].triangulated == 0 || variants[i].triangulated != variants[1].triangulated))) {
+            failed = 1;
+        }
+
+        if (write != NULL) {
+            char path[1024];
+            snprintf(path, sizeof(path), "%s%s.ppm", write, variants[i].name);
+            if (!tri__writeFrame(path, pixels, w, h)) fprintf(stderr, "failed to write %s\n", path);
+        }
+    }
+
+    for (i = 0; i < TRI_VARIANTS; i++) nvgDeleteSw(variants[i].vg);
+    printf(failed ? "triangulated fills differ\n" : "ok\n");
+    return failed ? 2 : 0;
+}